@@ -53,6 +53,17 @@
 #define ANIM_GO_TAG_PARTS	(4)
 #define ANIM_STAY_TAG_FORMAT	"!stay(%d)"
 #define ANIM_STAY_TAG_PARTS	(1)
+#define ANIM_LOOP_TAG_FORMAT	"!loop(%63[a-zA-Z0-9]%63[#,]%d)"
+#define ANIM_LOOP_TAG_PARTS	(3)
+#define ANIM_MAX_LOOPS		(255u) /* Max. count of the !loop tag. */
+#define PARALLAX_TAG_FORMAT	"!parallax(%d%1[%])"
+#define PARALLAX_TAG_PARTS	(2)
+#define PARALLAX_ONE		(64u) /* Parallax of 100%, see XG_PX_ONE. */
+#define PARALLAX_MAX		(398) /* Max. parallax, in percent. */
+#define GROUPS_MAX		(255u) /* Max. # of layer groups per scene. */
+#define CACHED_MAX		(64u)  /* Max. # of cached layers. */
+#define SCENE_MAX_NAME		(64u)  /* Max. length of the scene name */
+#define SCENES_MAX		(64u)  /* Max. # of scenes in the registry. */
 
 /******************************************************************************
  * Basic configuration.
@@ -192,6 +203,7 @@ struct layer_ctx_t {
 	anim_path_t	*anim_path;
 	uint16_t	 anim_frame_stay;
 	uint8_t		 anim_alt_path_chance;
+	uint8_t		 anim_alt_path_loops;
 
 	gboolean	 has_hash;
 	gboolean	 has_base_pt;
@@ -210,8 +222,14 @@ struct scene_layer_t {
 	point_t		 base_pt;
 	gint		 layer_id;
 	layer_obj_t	 obj_type;
+	uint8_t		 group;
 };
 
+/* Top-level group of the image layers. */
+typedef struct scene_group_t {
+	uint8_t		 parallax; /* In 1/PARALLAX_ONE units. */
+} scene_group_t;
+
 /*
  * Animation frame.
  *
@@ -222,6 +240,7 @@ struct scene_layer_t {
  * next_i	Index of the next animation frame.
  * alt_i	Index of the alternative next animation frame.
  * chance	Chance to draw the alternative frame, in percent.
+ * loops	Number of times to go to the alternative frame, 0 if none.
  */
 struct anim_frame_t {
 	char		alt_path_name[ANIM_MAX_NAME];
@@ -233,6 +252,7 @@ struct anim_frame_t {
 	uint32_t	alt_path_idx;
 	uint16_t	stay;
 	uint8_t		alt_path_chance;
+	uint8_t		alt_path_loops;
 };
 
 /*
@@ -268,6 +288,7 @@ static void	 chk_parse_anim_tag(layer_ctx_t *ctx);
 static void	 chk_parse_anim_frame(layer_ctx_t *ctx);
 static void	 chk_parse_go_tag(layer_ctx_t *ctx);
 static void	 chk_parse_stay_tag(layer_ctx_t *ctx);
+static void	 chk_parse_loop_tag(layer_ctx_t *ctx);
 static void	 chk_parse_inactive_tag(layer_ctx_t *ctx);
 static void	 chk_link_anim_frames(layer_ctx_t *ctx);
 static void	 chk_update_anim_frame_indexes(layer_ctx_t *ctx);
@@ -296,6 +317,9 @@ static FILE	*util_open_anim_file(void);
 static void	 util_close_anim_file(void);
 static void	 util_reset_layer_context(layer_ctx_t *ctx);
 static void	 util_process_layer(const gint layer_id);
+static void	 util_add_group(const gint layer_id);
+static void	 util_write_frame_jump(const anim_t *anim,
+		     const anim_frame_t *frame);
 
 /******************************************************************************
  * Plugin-wide variables.
@@ -320,6 +344,7 @@ static layer_chk_t layer_checks[] = {
 	{ .kind = CHECK_PER_LAYER,	.cbk = &chk_parse_anim_tag },
 	{ .kind = CHECK_PER_LAYER,	.cbk = &chk_parse_go_tag },
 	{ .kind = CHECK_PER_LAYER,	.cbk = &chk_parse_stay_tag },
+	{ .kind = CHECK_PER_LAYER,	.cbk = &chk_parse_loop_tag },
 	{ .kind = CHECK_PER_LAYER,	.cbk = &chk_parse_anim_frame },
 	{ .kind = CHECK_PER_LAYER,	.cbk = &chk_parse_inactive_tag },
 
@@ -347,6 +372,14 @@ static uint32_t layer_checks_n =
 static scene_layer_t scene_layers[LAYERS_MAX];
 static uint32_t scene_layers_n;
 
+/*
+ * Groups of the scene layers: top-level layer groups of the image. The first
+ * one is for the layers which aren't in any group.
+ */
+static scene_group_t groups[GROUPS_MAX];
+static uint32_t groups_n;
+static uint8_t group;
+
 /* Animations in the scene. */
 static anim_t animations[ANIM_MAX];
 static uint32_t animations_n;
@@ -368,6 +401,10 @@ static gchar *image_name;
  */
 static gboolean kbd = FALSE;
 
+/* Names of the exported scenes, they're written to the registry at last. */
+static char scene_names[SCENES_MAX][SCENE_MAX_NAME];
+static uint32_t scenes_n;
+
 static FILE *f_scenes;
 static FILE *f_anim;
 
@@ -444,6 +481,8 @@ run(const gchar *name, gint nparams, const GimpParam *param,
 		frames_n = 0;
 		paths_n = 0;
 		kbd = FALSE;
+		groups[0].parallax = PARALLAX_ONE;
+		groups_n = 1;
 
 		/* Obtain information about an image. */
 		image_id = image_ids[i];
@@ -473,6 +512,7 @@ run(const gchar *name, gint nparams, const GimpParam *param,
 
 		/* Process all layers and groups of layers. */
 		for (gint j = 0; j < layers_n; j++) {
+			util_add_group(layers[j]);
 			util_process_layer(layers[j]);
 		}
 
@@ -529,6 +569,7 @@ util_process_layer(const gint layer_id)
 			ctx.ignore = FALSE;
 			ctx.layer_id = layer_id;
 			ctx.anim_alt_path_chance = 0;
+			ctx.anim_alt_path_loops = 0;
 			ctx.anim_frame_stay = 0;
 
 			/* Call all per-layer checks for the current layer. */
@@ -545,6 +586,41 @@ util_process_layer(const gint layer_id)
 	}
 }
 
+/*
+ * Appends a visible top-level layer group of the image as a group of the scene
+ * layers and makes it the current one. Other layers are in the first group.
+ */
+static void
+util_add_group(const gint layer_id)
+{
+	const gchar *name = gimp_item_get_name(layer_id);
+	const gchar *tag;
+	char pct[2];
+	int parallax = 100;
+
+	group = 0;
+	if (gimp_item_is_group(layer_id) == FALSE ||
+	    gimp_item_get_visible(layer_id) == FALSE) {
+		return;
+	}
+	if (groups_n == GROUPS_MAX) {
+		printf("Too many groups, \"%s\" isn't added\n", name);
+		return;
+	}
+
+	tag = strstr(name, "!parallax(");
+	if (tag != NULL && (sscanf(tag, PARALLAX_TAG_FORMAT, &parallax,
+	    pct) != PARALLAX_TAG_PARTS || parallax < 0 ||
+	    parallax > PARALLAX_MAX)) {
+		printf("Bad !parallax() tag of \"%s\"\n", name);
+		parallax = 100;
+	}
+
+	groups[groups_n].parallax = (uint8_t)(((parallax *
+	    (int) PARALLAX_ONE) + 50) / 100);
+	group = (uint8_t) groups_n++;
+}
+
 /*
  * Parses !ignore() tag from the layer name.
  */
@@ -742,6 +818,7 @@ chk_parse_anim_tag(layer_ctx_t *ctx)
 				scn_layer = &scene_layers[scene_layers_n];
 				scn_layer->obj_type = OT_ANIMATION;
 				scn_layer->layer_id = ctx->layer_id;
+				scn_layer->group = group;
 				scn_layer->base_pt.x = 0;
 				scn_layer->base_pt.y = 0;
 				strncpy(scn_layer->name, anim_name,
@@ -790,6 +867,7 @@ chk_parse_anim_tag(layer_ctx_t *ctx)
 			scn_layer = &scene_layers[scene_layers_n];
 			scn_layer->obj_type = OT_IMAGE;
 			scn_layer->layer_id = ctx->layer_id;
+			scn_layer->group = group;
 			scn_layer->base_pt.x = ctx->base_pt.x;
 			scn_layer->base_pt.y = ctx->base_pt.y;
 
@@ -899,6 +977,56 @@ chk_parse_stay_tag(layer_ctx_t *ctx)
 	}
 }
 
+/*
+ * Parses !loop(path, count) from the layer name.
+ */
+static void
+chk_parse_loop_tag(layer_ctx_t *ctx)
+{
+	char layer_name[LAYER_MAX_NAME];
+	char path_name[ANIM_MAX_NAME];
+	char buf[ANIM_MAX_NAME];
+	gchar *gpos;
+	char *token;
+	int loops, rc = 0;
+
+	if (!ctx->ignore && ctx->is_anim_frame) {
+		/* An animation frame. */
+
+		/* Get a copy of the layer name. */
+		gpos = gimp_item_get_name(ctx->layer_id);
+		strncpy(layer_name, gpos, LAYER_MAX_NAME);
+
+		/* Parse layer name by token. */
+		token = strtok(layer_name, "_");
+		while (token != NULL) {
+			/* Replace all spaces */
+			REPLACE_STR(token, " ", '#');
+
+			/* An attempt to parse !loop tag. */
+			rc = sscanf(token, ANIM_LOOP_TAG_FORMAT, path_name,
+			    buf, &loops);
+			if (rc == ANIM_LOOP_TAG_PARTS) {
+				break;
+			}
+
+			/* Go to the next token. */
+			token = strtok(NULL, "_");
+		}
+
+		if (rc == ANIM_LOOP_TAG_PARTS && loops > 0 &&
+		    loops <= (int) ANIM_MAX_LOOPS) {
+			/* Loop tag found! It overrides the !go tag. */
+			snprintf(ctx->anim_alt_path_name, ANIM_MAX_NAME,
+			    "%s@%s", path_name, ctx->anim->name);
+			ctx->anim_alt_path_chance = 0;
+			ctx->anim_alt_path_loops = (uint8_t) loops;
+		}
+	} else {
+		/* Not an animation frame - do nothing. */
+	}
+}
+
 /*
  * Adds current layer's image as an animation frame to the list of frames and
  * updates its animation path.
@@ -917,10 +1045,12 @@ chk_parse_anim_frame(layer_ctx_t *ctx)
 		frame->stay = ctx->anim_frame_stay;
 
 		/* Alternative path for this frame */
-		if (ctx->anim_alt_path_chance > 0u) {
+		if (ctx->anim_alt_path_chance > 0u ||
+		    ctx->anim_alt_path_loops > 0u) {
 			strncpy(frame->alt_path_name, ctx->anim_alt_path_name,
 			    ANIM_MAX_NAME);
 			frame->alt_path_chance = ctx->anim_alt_path_chance;
+			frame->alt_path_loops = ctx->anim_alt_path_loops;
 		}
 
 		/* Append frame to the path */
@@ -973,7 +1103,8 @@ chk_link_anim_frames(layer_ctx_t *ctx)
 	for (uint32_t i = 0; i < frames_n; i++) {
 		frame = &frames[i];
 
-		if (frame->alt_path_chance > 0u) {
+		if (frame->alt_path_chance > 0u ||
+		    frame->alt_path_loops > 0u) {
 			/* Frame has an alternative path. */
 			for (uint32_t j = 0; j < paths_n; j++) {
 				if (IS_SAME_NAME(frame->alt_path_name,
@@ -1044,7 +1175,16 @@ chk_print_animations(layer_ctx_t *ctx)
 				util_sha1_to_text(frame->hash, HASH_SZ, hasht,
 				    sizeof(hasht));
 
-				if (frame->alt_path_chance > 0u) {
+				if (frame->alt_path_loops > 0u) {
+					/* There's a loop */
+					printf("\t\t#%d %s at (%d, %d) ---> "
+					    "#%d x%d\n",
+					    frame->frame_idx, hasht,
+					    frame->base_pt.x, frame->base_pt.y,
+					    frames[paths[frame->alt_path_idx]
+					    .frames_idx[0]].frame_idx,
+					    frame->alt_path_loops);
+				} else if (frame->alt_path_chance > 0u) {
 					/* There's an alternative path */
 					util_sha1_to_text(
 					    frames[paths[frame->alt_path_idx].frames_idx[0]].hash,
@@ -1087,6 +1227,7 @@ chk_open_animations_header(layer_ctx_t *ctx)
 		fprintf(f_anim, "#ifndef XGANIMATIONS_H_\n");
 		fprintf(f_anim, "#define XGANIMATIONS_H_ 1\n");
 		fprintf(f_anim, "\n");
+		fprintf(f_anim, "#include <avr/pgmspace.h>\n");
 		fprintf(f_anim, "#include \"xling/graphics.h\"\n");
 	}
 }
@@ -1143,8 +1284,8 @@ chk_write_animations_header(layer_ctx_t *ctx)
 			n = 0;
 
 			fprintf(f_anim, "\n");
-			fprintf(f_anim, "xg_anim_frame_t XG_ANMF_%s_%s[] = {\n",
-			    image_name, anim->name);
+			fprintf(f_anim, "const xg_anim_frame_t PROGMEM "
+			    "XG_ANMF_%s_%s[] = {\n", image_name, anim->name);
 
 			/* Paths */
 			for (uint32_t j = 0; j < anim->paths_n; j++) {
@@ -1159,17 +1300,14 @@ chk_write_animations_header(layer_ctx_t *ctx)
 					    hasht, sizeof(hasht));
 
 					fprintf(f_anim, "\t{ "
-					    ".base_pt = { %d, %d }, "
-					    ".alt = %d, "
+					    ".base_pt = { %d, %d }, ",
+					    frame->base_pt.x, frame->base_pt.y);
+					util_write_frame_jump(anim, frame);
+					fprintf(f_anim,
 					    ".img = &XG_IMG_%s, "
-					    ".alt_chance = %d, "
 					    ".stay = %d, "
 					    "},\n",
-					    frame->base_pt.x, frame->base_pt.y,
-					    frames[paths[frame->alt_path_idx].frames_idx[0]].frame_idx,
-					    hasht, frame->alt_path_chance,
-					    frame->stay
-					);
+					    hasht, frame->stay);
 
 					/* Increase # of the frames. */
 					n++;
@@ -1177,15 +1315,17 @@ chk_write_animations_header(layer_ctx_t *ctx)
 			}
 
 			fprintf(f_anim, "};\n");
-			fprintf(f_anim, "xg_anim_t XG_ANM_%s_%s = { "
+			fprintf(f_anim, "xg_anim_state_t XG_ANMS_%s_%s;\n",
+			    image_name, anim->name);
+			fprintf(f_anim, "const xg_anim_t PROGMEM XG_ANM_%s_%s = { "
 			    ".frames = XG_ANMF_%s_%s, "
 			    ".frames_n = %d, "
-			    ".frame_idx = 0, "
-			    ".stay_cnt = 0, "
+			    ".state = &XG_ANMS_%s_%s, "
 			    ".active = %d, "
 			    "};\n",
 			    image_name, anim->name,
-			    image_name, anim->name, n, anim->active
+			    image_name, anim->name, n,
+			    image_name, anim->name, anim->active
 			);
 		}
 	}
@@ -1195,11 +1335,13 @@ static void
 chk_open_scenes_header(layer_ctx_t *ctx)
 {
 	f_scenes = fopen(OUTPUT_DIR "/scenes.h", "w");
+	scenes_n = 0;
 
 	if (f_scenes != NULL) {
 		fprintf(f_scenes, "#ifndef XG_SCENES_H_\n");
 		fprintf(f_scenes, "#define XG_SCENES_H_ 1\n");
 		fprintf(f_scenes, "\n");
+		fprintf(f_scenes, "#include <avr/pgmspace.h>\n");
 		fprintf(f_scenes, "#include \"xling/graphics.h\"\n");
 		fprintf(f_scenes, "#include \"xling/scenes/anim.h\"\n\n");
 	}
@@ -1209,6 +1351,21 @@ static void
 chk_close_scenes_header(layer_ctx_t *ctx)
 {
 	if (f_scenes != NULL) {
+		/*
+		 * Registry of the scenes (see xg_switch_scene()) lists all
+		 * of the exported images in the order they're open.
+		 */
+		for (uint32_t i = 0; i < scenes_n; i++) {
+			fprintf(f_scenes, "#define XG_SCN_IDX_%s (%uu)\n",
+			    scene_names[i], i);
+		}
+		fprintf(f_scenes, "#define XG_SCENES_N (%uu)\n", scenes_n);
+		fprintf(f_scenes, "const xg_scene_t * const PROGMEM "
+		    "XG_SCENES[] = {\n");
+		for (uint32_t i = 0; i < scenes_n; i++) {
+			fprintf(f_scenes, "\t&XG_SCN_%s,\n", scene_names[i]);
+		}
+		fprintf(f_scenes, "};\n\n");
 		fprintf(f_scenes, "#endif /* XG_SCENES_H_ */");
 		fclose(f_scenes);
 	}
@@ -1219,6 +1376,14 @@ chk_write_scenes_header(layer_ctx_t *ctx)
 {
 	char kbd_cbk_name[256];
 	scene_layer_t *scn_layer;
+	uint32_t i, cached_n = 0;
+
+	if (f_scenes != NULL && (scenes_n == SCENES_MAX ||
+	    strlen(image_name) >= SCENE_MAX_NAME)) {
+		fprintf(stderr, "%s: too many scenes or too long name, %s "
+		    "isn't exported\n", PLUGIN_NAME, image_name);
+		return;
+	}
 
 	if (f_scenes != NULL) {
 		fprintf(f_scenes, SCENE_COMMENT, image_name);
@@ -1227,7 +1392,7 @@ chk_write_scenes_header(layer_ctx_t *ctx)
 		 * Iterate over scene layers to write down header files for
 		 * static images.
 		 */
-		for (uint32_t i = 0; i < scene_layers_n; i++) {
+		for (i = 0; i < scene_layers_n; i++) {
 			scn_layer = &scene_layers[i];
 
 			if (scn_layer->obj_type == OT_IMAGE) {
@@ -1246,44 +1411,88 @@ chk_write_scenes_header(layer_ctx_t *ctx)
 			);
 		}
 
-		/* Write scene layers down. */
-		fprintf(f_scenes, "xg_layer_t XG_SCNL_%s[] = {\n",
-		    image_name);
-		for (uint32_t i = 0; i < scene_layers_n; i++) {
+		/*
+		 * Write the draw list down: scene layers from the bottom one
+		 * to the top. Static layers at the bottom are cached.
+		 */
+		fprintf(f_scenes, "const xg_draw_op_t PROGMEM XG_SCND_%s[] = "
+		    "{\n", image_name);
+		for (uint32_t k = 0; k < scene_layers_n; k++) {
+			i = scene_layers_n - 1 - k;
 			scn_layer = &scene_layers[i];
 
+			if (cached_n == k && cached_n < CACHED_MAX &&
+			    scn_layer->obj_type == OT_IMAGE) {
+				cached_n++;
+			}
+
 			if (scn_layer->obj_type == OT_IMAGE) {
 				fprintf(f_scenes, "\t /* %u */ { "
 				    ".obj = &XG_IMG_%s, "
 				    ".obj_type = XG_OT_IMG, "
-				    ".base_pt = { %d, %d } },\n",
+				    ".base_pt = { %d, %d }, "
+				    ".group = %u },\n",
 				    i, scn_layer->name,
 				    scn_layer->base_pt.x,
-				    scn_layer->base_pt.y);
+				    scn_layer->base_pt.y,
+				    scn_layer->group);
 			} else {
 				fprintf(f_scenes, "\t /* %u */ { "
 				    ".obj = &XG_ANM_%s_%s, "
-				    ".obj_type = XG_OT_ANIM },\n",
-				    i, image_name, scn_layer->name);
+				    ".obj_type = XG_OT_ANIM, "
+				    ".group = %u },\n",
+				    i, image_name, scn_layer->name,
+				    scn_layer->group);
 			}
 		}
 		fprintf(f_scenes, "};\n\n");
 
+		/* Write groups of the layers down. */
+		fprintf(f_scenes, "const xg_group_t PROGMEM XG_SCNG_%s[] = {\n",
+		    image_name);
+		for (i = 0; i < groups_n; i++) {
+			fprintf(f_scenes, "\t /* %u */ { .parallax = %u },\n",
+			    i, groups[i].parallax);
+		}
+		fprintf(f_scenes, "};\n\n");
+
 		/* Prepare a name of the keyboard callback function. */
 		snprintf(kbd_cbk_name, 256,
 		    (kbd == TRUE ? "XG_SCNKBD_%s" : "%s"),
 		    (kbd == TRUE ? image_name : "NULL"));
 
-		fprintf(f_scenes, "xg_scene_t XG_SCN_%s = {\n"
-		    "\t.layers = XG_SCNL_%s,\n"
-		    "\t.layers_n = %d,\n"
+		/*
+		 * Offsets of the groups and the pan are the only parts of
+		 * a scene in RAM, they're initialized by xg_enter_scene().
+		 */
+		fprintf(f_scenes, "xg_point_t XG_SCNO_%s[%d];\n",
+		    image_name, groups_n);
+		fprintf(f_scenes, "xg_point_t XG_SCNP_%s;\n\n", image_name);
+
+		fprintf(f_scenes, "const xg_scene_t PROGMEM XG_SCN_%s = {\n"
+		    "\t.ops = XG_SCND_%s,\n"
+		    "\t.groups = XG_SCNG_%s,\n"
+		    "\t.offsets = XG_SCNO_%s,\n"
+		    "\t.pan = &XG_SCNP_%s,\n"
+		    "\t.ops_n = %d,\n"
+		    "\t.cached_n = %u,\n"
+		    "\t.groups_n = %d,\n"
 		    "\t.kbd_cbk = %s,\n"
 		    "};\n\n",
 		    image_name,
 		    image_name,
+		    image_name,
+		    image_name,
+		    image_name,
 		    scene_layers_n,
+		    cached_n,
+		    groups_n,
 		    kbd_cbk_name
 		);
+
+		/* The scene is listed in the registry at the end. */
+		snprintf(scene_names[scenes_n++], SCENE_MAX_NAME, "%s",
+		    image_name);
 	}
 }
 
@@ -1372,8 +1581,43 @@ util_reset_layer_context(layer_ctx_t *ctx)
 	ctx->is_anim_frame = FALSE;
 	ctx->ignore = FALSE;
 	ctx->anim_alt_path_chance = 0;
+	ctx->anim_alt_path_loops = 0;
 	ctx->anim_frame_stay = 0;
 
 	ctx->anim = NULL;
 	ctx->anim_path = NULL;
 }
+
+/*
+ * Writes down the transition of a frame to the next one (see xg_anim_frame_t
+ * and xlingc): the chance in percent is scaled to 0..255.
+ */
+static void
+util_write_frame_jump(const anim_t *anim, const anim_frame_t *frame)
+{
+	uint32_t total = 0, next, threshold;
+	const char *op;
+
+	for (uint32_t j = 0; j < anim->paths_n; j++) {
+		total += paths[anim->paths_idx[j]].frames_n;
+	}
+	next = frame->frame_idx + 1u;
+	next = next >= total ? 0 : next;
+
+	if (frame->alt_path_loops > 0u) {
+		op = "XG_AT_LOOP";
+		threshold = frame->alt_path_loops;
+	} else {
+		op = "XG_AT_CHANCE";
+		threshold = (frame->alt_path_chance * 255u + 50u) / 100u;
+		threshold = threshold > 255u ? 255u : threshold;
+	}
+
+	fprintf(f_anim,
+	    ".next = %u, "
+	    ".alt = %u, "
+	    ".threshold = %u, "
+	    ".op = %s, ",
+	    next, frames[paths[frame->alt_path_idx].frames_idx[0]].frame_idx,
+	    threshold, op);
+}
@@ -0,0 +1,403 @@
+/*-
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * This file is part of xlingc, a standalone asset compiler to generate header
+ * files with graphics for Xling, a tamagotchi-like toy.
+ *
+ * Copyright (c) 2020 Dmitry Salychev
+ *
+ * Xling firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Xling firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/*
+ * Persistent cache of the converted layers.
+ *
+ * The cache lives in CACHE_FILE of the output directory and keeps two kinds
+ * of records:
+ *
+ *	F <size> <mtime> <mtime_ns> <pixels SHA-1> <path>
+ *
+ *		SHA-1 of the pixels of a PNG file with the given size and time
+ *		of the last modification. It allows to skip decoding of the
+ *		files which haven't been changed since the last run.
+ *
+ *	B <pixels SHA-1> <settings SHA-1> <output SHA-1> <x> <y> <w> <h>
+ *	  <saved>
+ *
+ *		Headers generated from the pixels by the converter with the
+ *		given settings and properties of the image (see block_info_t).
+ *		Conversion is skipped if the headers are still in the output
+ *		directory and their content is the same.
+ *
+ * Any change of the conversion settings (or of the converter itself, see
+ * CONVERTER_VERSION) invalidates all of the images.
+ */
+
+#include "xlingc.h"
+
+#define CACHE_FILE		".xlingc.cache"
+#define CACHE_LINE_SZ		(PATH_MAX_LEN + 256u)
+
+typedef struct file_rec_t {
+	char		 path[PATH_MAX_LEN];
+	long long	 size;
+	long long	 mtime;
+	long		 mtime_ns;
+	uint8_t		 hash[HASH_SZ];
+} file_rec_t;
+
+typedef struct block_rec_t {
+	uint8_t		 hash[HASH_SZ];
+	uint8_t		 settings[HASH_SZ];
+	uint8_t		 digest[HASH_SZ];
+	block_info_t	 info;
+} block_rec_t;
+
+static int	 text_to_sha1(const char *hasht, uint8_t *hash);
+static int	 digest_block(const xc_config_t *cfg, const uint8_t *hash,
+		     uint8_t *digest);
+static int	 digest_file(const char *path, sha1_ctx_t *ctx);
+static void	*grow(void *arr, uint32_t *n, uint32_t *max, size_t el_sz);
+
+static file_rec_t *files;
+static uint32_t files_n;
+static uint32_t files_max;
+static block_rec_t *blocks;
+static uint32_t blocks_n;
+static uint32_t blocks_max;
+static uint8_t settings[HASH_SZ];
+
+/* Loads records of the cache from the output directory. */
+int
+cache_load(const xc_config_t *cfg)
+{
+	char path[PATH_MAX_LEN];
+	char line[CACHE_LINE_SZ];
+	char h1[HASHT_SZ], h2[HASHT_SZ], h3[HASHT_SZ];
+	char settings_text[256];
+	file_rec_t frec;
+	block_rec_t brec;
+	sha1_ctx_t ctx;
+	FILE *f;
+	int pos;
+
+	/* Settings of the converter which affect the generated headers. */
+	snprintf(settings_text, sizeof(settings_text),
+	    "%s edge=%u", CONVERTER_VERSION, MONO_EDGE);
+	sha1_init(&ctx);
+	sha1_update(&ctx, settings_text, strlen(settings_text));
+	sha1_final(&ctx, settings);
+
+	if (cfg->rebuild) {
+		/* Forget everything known about the previous runs. */
+		return (0);
+	}
+
+	snprintf(path, sizeof(path), "%s/%s", cfg->out_dir, CACHE_FILE);
+	f = fopen(path, "r");
+	if (f == NULL) {
+		/* There is no cache yet. */
+		return (0);
+	}
+
+	while (fgets(line, sizeof(line), f) != NULL) {
+		line[strcspn(line, "\r\n")] = '\0';
+
+		if (sscanf(line, "F %lld %lld %ld %40s %n", &frec.size,
+		    &frec.mtime, &frec.mtime_ns, h1, &pos) == 4 &&
+		    text_to_sha1(h1, frec.hash) == 0) {
+			if (strlen(&line[pos]) >= sizeof(frec.path)) {
+				continue;
+			}
+			strcpy(frec.path, &line[pos]);
+			files = grow(files, &files_n, &files_max,
+			    sizeof(files[0]));
+			if (files != NULL) {
+				files[files_n++] = frec;
+			}
+		} else if (sscanf(line, "B %40s %40s %40s %d %d %u %u %u", h1,
+		    h2, h3, &brec.info.offset.x, &brec.info.offset.y,
+		    &brec.info.width, &brec.info.height,
+		    &brec.info.saved) == 8 &&
+		    text_to_sha1(h1, brec.hash) == 0 &&
+		    text_to_sha1(h2, brec.settings) == 0 &&
+		    text_to_sha1(h3, brec.digest) == 0) {
+			blocks = grow(blocks, &blocks_n, &blocks_max,
+			    sizeof(blocks[0]));
+			if (blocks != NULL) {
+				blocks[blocks_n++] = brec;
+			}
+		} else {
+			/* Ignore broken records silently. */
+		}
+	}
+	fclose(f);
+
+	return (0);
+}
+
+/* Saves records of the cache to the output directory. */
+int
+cache_save(const xc_config_t *cfg)
+{
+	char path[PATH_MAX_LEN];
+	char h1[HASHT_SZ], h2[HASHT_SZ], h3[HASHT_SZ];
+	FILE *f;
+	int rc = 0;
+
+	snprintf(path, sizeof(path), "%s/%s", cfg->out_dir, CACHE_FILE);
+	f = fopen(path, "w");
+	if (f == NULL) {
+		fprintf(stderr, "xlingc: can't open %s for writing\n", path);
+		rc = 1;
+	}
+
+	for (uint32_t i = 0; rc == 0 && i < files_n; i++) {
+		util_sha1_to_text(files[i].hash, HASH_SZ, h1, sizeof(h1));
+		fprintf(f, "F %lld %lld %ld %s %s\n", files[i].size,
+		    files[i].mtime, files[i].mtime_ns, h1, files[i].path);
+	}
+	for (uint32_t i = 0; rc == 0 && i < blocks_n; i++) {
+		/* Don't keep blocks of the other versions of the converter. */
+		if (memcmp(blocks[i].settings, settings, HASH_SZ) != 0) {
+			continue;
+		}
+		util_sha1_to_text(blocks[i].hash, HASH_SZ, h1, sizeof(h1));
+		util_sha1_to_text(blocks[i].settings, HASH_SZ, h2, sizeof(h2));
+		util_sha1_to_text(blocks[i].digest, HASH_SZ, h3, sizeof(h3));
+		fprintf(f, "B %s %s %s %d %d %u %u %u\n", h1, h2, h3,
+		    blocks[i].info.offset.x, blocks[i].info.offset.y,
+		    blocks[i].info.width, blocks[i].info.height,
+		    blocks[i].info.saved);
+	}
+
+	if (f != NULL) {
+		rc |= (ferror(f) != 0);
+		fclose(f);
+	}
+
+	free(files);
+	free(blocks);
+	files = NULL;
+	blocks = NULL;
+	files_n = files_max = 0;
+	blocks_n = blocks_max = 0;
+
+	return (rc);
+}
+
+/*
+ * Looks for SHA-1 of the pixels of an unchanged PNG file.
+ *
+ * Returns 0 and the hash if the file is known and hasn't been modified since
+ * the last run.
+ */
+int
+cache_lookup_file(const char *path, uint8_t *hash)
+{
+	struct stat st;
+
+	if (stat(path, &st) != 0) {
+		return (1);
+	}
+
+	for (uint32_t i = 0; i < files_n; i++) {
+		if (IS_SAME_NAME(files[i].path, path) &&
+		    files[i].size == (long long) st.st_size &&
+		    files[i].mtime == (long long) st.st_mtim.tv_sec &&
+		    files[i].mtime_ns == st.st_mtim.tv_nsec) {
+			memcpy(hash, files[i].hash, HASH_SZ);
+			return (0);
+		}
+	}
+
+	return (1);
+}
+
+/* Remembers SHA-1 of the pixels of a PNG file. */
+void
+cache_store_file(const char *path, const uint8_t *hash)
+{
+	struct stat st;
+	file_rec_t *rec = NULL;
+
+	if (stat(path, &st) != 0 || strlen(path) >= PATH_MAX_LEN) {
+		return;
+	}
+
+	for (uint32_t i = 0; i < files_n; i++) {
+		if (IS_SAME_NAME(files[i].path, path)) {
+			rec = &files[i];
+			break;
+		}
+	}
+	if (rec == NULL) {
+		files = grow(files, &files_n, &files_max, sizeof(files[0]));
+		if (files == NULL) {
+			return;
+		}
+		rec = &files[files_n++];
+	}
+
+	snprintf(rec->path, sizeof(rec->path), "%s", path);
+	rec->size = (long long) st.st_size;
+	rec->mtime = (long long) st.st_mtim.tv_sec;
+	rec->mtime_ns = st.st_mtim.tv_nsec;
+	memcpy(rec->hash, hash, HASH_SZ);
+}
+
+/*
+ * Checks whether headers of the image are up to date, i.e. they've been
+ * generated from the same pixels with the same settings and nobody has
+ * touched them since then. Returns properties of the image if so.
+ */
+int
+cache_is_block_fresh(const xc_config_t *cfg, const uint8_t *hash,
+    block_info_t *info)
+{
+	uint8_t digest[HASH_SZ];
+
+	for (uint32_t i = 0; i < blocks_n; i++) {
+		if (memcmp(blocks[i].hash, hash, HASH_SZ) == 0 &&
+		    memcmp(blocks[i].settings, settings, HASH_SZ) == 0) {
+			if (digest_block(cfg, hash, digest) != 0 ||
+			    memcmp(blocks[i].digest, digest, HASH_SZ) != 0) {
+				return (0);
+			}
+			(*info) = blocks[i].info;
+			return (1);
+		}
+	}
+
+	return (0);
+}
+
+/* Remembers headers of the image which have just been generated. */
+void
+cache_store_block(const xc_config_t *cfg, const uint8_t *hash,
+    const block_info_t *info)
+{
+	block_rec_t *rec = NULL;
+
+	for (uint32_t i = 0; i < blocks_n; i++) {
+		if (memcmp(blocks[i].hash, hash, HASH_SZ) == 0) {
+			rec = &blocks[i];
+			break;
+		}
+	}
+	if (rec == NULL) {
+		blocks = grow(blocks, &blocks_n, &blocks_max,
+		    sizeof(blocks[0]));
+		if (blocks == NULL) {
+			return;
+		}
+		rec = &blocks[blocks_n++];
+	}
+
+	memcpy(rec->hash, hash, HASH_SZ);
+	memcpy(rec->settings, settings, HASH_SZ);
+	rec->info = (*info);
+	if (digest_block(cfg, hash, rec->digest) != 0) {
+		/* Headers can't be read back - don't trust them next time. */
+		memset(rec->settings, 0, HASH_SZ);
+	}
+}
+
+/* Calculates SHA-1 of the headers generated for the image. */
+static int
+digest_block(const xc_config_t *cfg, const uint8_t *hash, uint8_t *digest)
+{
+	char hasht[HASHT_SZ];
+	char path[PATH_MAX_LEN];
+	sha1_ctx_t ctx;
+	int rc;
+
+	util_sha1_to_text(hash, HASH_SZ, hasht, sizeof(hasht));
+	sha1_init(&ctx);
+
+	snprintf(path, sizeof(path), "%s/%s.h", cfg->out_dir, hasht);
+	rc = digest_file(path, &ctx);
+
+	/* Alpha channel is optional. */
+	snprintf(path, sizeof(path), "%s/%s_a.h", cfg->out_dir, hasht);
+	(void) digest_file(path, &ctx);
+
+	sha1_final(&ctx, digest);
+
+	return (rc);
+}
+
+static int
+digest_file(const char *path, sha1_ctx_t *ctx)
+{
+	uint8_t buf[4096];
+	size_t n;
+	FILE *f;
+
+	f = fopen(path, "rb");
+	if (f == NULL) {
+		return (1);
+	}
+	while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+		sha1_update(ctx, buf, n);
+	}
+	fclose(f);
+
+	return (0);
+}
+
+static int
+text_to_sha1(const char *hasht, uint8_t *hash)
+{
+	unsigned int byte;
+
+	if (strlen(hasht) != (HASH_SZ * 2)) {
+		return (1);
+	}
+	for (uint32_t i = 0; i < HASH_SZ; i++) {
+		if (sscanf(&hasht[i * 2], "%2x", &byte) != 1) {
+			return (1);
+		}
+		hash[i] = (uint8_t) byte;
+	}
+
+	return (0);
+}
+
+/*
+ * Makes sure there is a space for one more element in the array. The array is
+ * dropped if there is no memory: it's a cache, nothing is really lost.
+ */
+static void *
+grow(void *arr, uint32_t *n, uint32_t *max, size_t el_sz)
+{
+	void *p = arr;
+
+	if ((*n) == (*max)) {
+		(*max) = ((*max) == 0) ? 64 : ((*max) * 2);
+		p = realloc(arr, (*max) * el_sz);
+		if (p == NULL) {
+			free(arr);
+			(*n) = 0;
+			(*max) = 0;
+		}
+	}
+
+	return (p);
+}
@@ -0,0 +1,526 @@
+/*-
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * This file is part of xlingc, a standalone asset compiler to generate header
+ * files with graphics for Xling, a tamagotchi-like toy.
+ *
+ * Copyright (c) 2020 Dmitry Salychev
+ *
+ * Xling firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Xling firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+/*
+ * Conversion of the layer images by a pool of worker threads.
+ *
+ * Every job decodes PNG files, calculates SHA-1 of their pixels, composes them
+ * into a single image (for the layers flattened by the !flat() tag), trims its
+ * transparent margins, aligns static layers to the display pages and writes
+ * headers with the image data unless there are fresh ones already. Jobs don't
+ * depend on each other: headers are named after the pixels, so it doesn't
+ * matter in which order they're written. Results are kept in the jobs and
+ * consumed by the caller in the original order after all of the workers have
+ * finished, i.e. the scene and animation headers and the cache are the same
+ * regardless of the number of workers.
+ *
+ * Delta jobs are run after the images of the frames, see conv_do_delta().
+ */
+
+#include "xlingc.h"
+
+typedef struct pool_t {
+	const xc_config_t	*cfg;
+	conv_job_t		*jobs;
+	uint32_t		 jobs_n;
+	uint32_t		 next;	/* Index of the next job to take. */
+	pthread_mutex_t		 lock;
+} pool_t;
+
+static void	*conv_worker(void *arg);
+static void	 conv_do_job(pool_t *pool, conv_job_t *job);
+static void	 conv_do_delta(pool_t *pool, conv_job_t *job);
+static int	 conv_make_delta(const image_t *img, const image_t *prev,
+		     uint8_t flags, delta_t *delta);
+static int	 conv_decode(conv_src_t *src);
+static void	 conv_calc_hash(conv_job_t *job);
+static int	 conv_is_block_known(pool_t *pool, const uint8_t *hash);
+
+/* Hashes of the images written during this run of the compiler. */
+static uint8_t (*blocks)[HASH_SZ];
+static uint32_t blocks_n;
+static uint32_t blocks_max;
+
+/* Runs all of the jobs and waits until they're finished. */
+int
+conv_run(const xc_config_t *cfg, conv_job_t *jobs, uint32_t jobs_n)
+{
+	pthread_t workers[XC_MAX_JOBS];
+	uint32_t workers_n;
+	pool_t pool = {
+		.cfg = cfg,
+		.jobs = jobs,
+		.jobs_n = jobs_n,
+		.next = 0,
+	};
+	int rc = 0;
+
+	workers_n = (cfg->jobs < jobs_n) ? cfg->jobs : jobs_n;
+	if (workers_n > XC_MAX_JOBS) {
+		workers_n = XC_MAX_JOBS;
+	}
+	if (pthread_mutex_init(&pool.lock, NULL) != 0) {
+		return (1);
+	}
+
+	for (uint32_t i = 0; i < workers_n; i++) {
+		if (pthread_create(&workers[i], NULL, &conv_worker,
+		    &pool) != 0) {
+			/* Carry on with the workers we've got so far. */
+			workers_n = i;
+			break;
+		}
+	}
+
+	/* Do the rest in the calling thread if there are no workers. */
+	if (workers_n == 0) {
+		(void) conv_worker(&pool);
+	}
+
+	for (uint32_t i = 0; i < workers_n; i++) {
+		rc |= (pthread_join(workers[i], NULL) != 0);
+	}
+	pthread_mutex_destroy(&pool.lock);
+
+	for (uint32_t i = 0; i < jobs_n; i++) {
+		rc |= jobs[i].error;
+	}
+
+	return (rc);
+}
+
+/* Forgets images written during this run. */
+void
+conv_reset(void)
+{
+	free(blocks);
+	blocks = NULL;
+	blocks_n = 0;
+	blocks_max = 0;
+}
+
+static void *
+conv_worker(void *arg)
+{
+	pool_t *pool = arg;
+	conv_job_t *job;
+
+	for (;;) {
+		pthread_mutex_lock(&pool->lock);
+		job = (pool->next < pool->jobs_n) ?
+		    &pool->jobs[pool->next++] : NULL;
+		pthread_mutex_unlock(&pool->lock);
+
+		if (job == NULL) {
+			break;
+		} else if (job->delta) {
+			conv_do_delta(pool, job);
+		} else {
+			conv_do_job(pool, job);
+		}
+	}
+
+	return (NULL);
+}
+
+/*
+ * Exports image data of the layer as a separate header file named as <SHA-1>.h
+ * (and <SHA-1>_a.h if layer has an alpha channel). Image of the layer tagged
+ * by !tiles() is exported as a tile map instead.
+ */
+static void
+conv_do_job(pool_t *pool, conv_job_t *job)
+{
+	char hasht[HASHT_SZ];
+	bitmap_t flat = { .px = NULL };
+	bitmap_t *bmp = &job->srcs[0].bmp;
+	image_t img;
+	tilemap_t tm;
+	int known, fresh;
+
+	job->converted = 0;
+	job->error = 0;
+
+	/* Don't decode PNG files which haven't been changed since the last run. */
+	for (uint32_t i = 0; i < job->srcs_n; i++) {
+		job->srcs[i].decoded = 0;
+		if (job->error == 0 && !job->srcs[i].hashed) {
+			job->error = conv_decode(&job->srcs[i]);
+		}
+	}
+	if (job->error != 0) {
+		goto out;
+	}
+	conv_calc_hash(job);
+	util_sha1_to_text(job->hash, HASH_SZ, hasht, sizeof(hasht));
+
+	/*
+	 * Convert the same pixels only once and only if there are no headers
+	 * generated for them by one of the previous runs.
+	 */
+	known = conv_is_block_known(pool, job->hash);
+	fresh = !known && cache_is_block_fresh(pool->cfg, job->hash,
+	    &job->info);
+	if (!fresh) {
+		for (uint32_t i = 0; i < job->srcs_n; i++) {
+			if (job->error == 0 && !job->srcs[i].decoded) {
+				job->error = conv_decode(&job->srcs[i]);
+			}
+		}
+		if (job->error == 0 && job->srcs_n > 1) {
+			job->error = img_compose(job->srcs, job->srcs_n, &flat);
+			bmp = &flat;
+		}
+		if (job->error != 0) {
+			goto out;
+		}
+		/* Position of the cropped image is needed anyway. */
+		img_crop(bmp, &job->info);
+		job->error = img_shift(bmp, job->shift, &job->info);
+		job->info.width = bmp->width;
+		job->info.height = bmp->height;
+	}
+
+	if (job->error == 0 && !known && !fresh) {
+		job->error = img_pack(bmp, &img);
+		if (job->error == 0 && job->tiles) {
+			job->error = img_slice_tiles(&img, &tm);
+			if (job->error == 0) {
+				job->error = out_write_tilemap(pool->cfg, hasht,
+				    &tm);
+				img_free_tiles(&tm);
+			}
+			img_free(&img);
+		} else if (job->error == 0) {
+			job->error = img_encode_alpha(&img);
+			if (job->error == 0) {
+				job->error = out_write_image(pool->cfg, hasht,
+				    &img);
+			}
+			img_free(&img);
+		}
+		job->converted = (job->error == 0);
+	}
+
+out:
+	img_free_bitmap(&flat);
+	for (uint32_t i = 0; i < job->srcs_n; i++) {
+		if (job->srcs[i].decoded) {
+			img_free_bitmap(&job->srcs[i].bmp);
+		}
+	}
+}
+
+/*
+ * Exports frames of an animation as deltas into a header file named as
+ * <SHA-1>.h (see XG_DF_KEY in "xling/graphics.h").
+ *
+ * Frames are placed into a box which contains all of them, positions of the
+ * frames are relative to its top-left corner. Every frame is stored as spans
+ * of bytes which differ from the previous frame, or from the empty box for the
+ * key frames, i.e. the first frames of the paths. Deltas are drawn from a work
+ * image in RAM, so they're worth using only if they take less flash than the
+ * cropped images of the frames and the work image is small enough. The number
+ * of bytes saved is zero otherwise.
+ */
+static void
+conv_do_delta(pool_t *pool, conv_job_t *job)
+{
+	char hasht[HASHT_SZ];
+	bitmap_t box;
+	block_info_t crop;
+	image_t *planes = NULL, img;
+	delta_t *deltas = NULL;
+	uint32_t w = 0, h = 0, bx, by, total = 0, frames_sz = 0, i, j;
+	int known, fresh;
+
+	job->converted = 0;
+	job->error = 0;
+
+	/* Hashes of the frames are known from their own jobs. */
+	for (i = 0; i < job->srcs_n; i++) {
+		job->srcs[i].decoded = 0;
+		if (job->error == 0 && !job->srcs[i].hashed) {
+			job->error = conv_decode(&job->srcs[i]);
+		}
+	}
+	if (job->error != 0) {
+		goto out;
+	}
+	conv_calc_hash(job);
+	util_sha1_to_text(job->hash, HASH_SZ, hasht, sizeof(hasht));
+
+	known = conv_is_block_known(pool, job->hash);
+	fresh = !known && cache_is_block_fresh(pool->cfg, job->hash,
+	    &job->info);
+	if (fresh) {
+		goto out;
+	}
+
+	for (i = 0; i < job->srcs_n; i++) {
+		if (job->error == 0 && !job->srcs[i].decoded) {
+			job->error = conv_decode(&job->srcs[i]);
+		}
+		if (job->error == 0) {
+			bx = (uint32_t) job->srcs[i].pt.x +
+			    job->srcs[i].bmp.width;
+			by = (uint32_t) job->srcs[i].pt.y +
+			    job->srcs[i].bmp.height;
+			w = (bx > w) ? bx : w;
+			h = (by > h) ? by : h;
+		}
+	}
+	planes = calloc(job->srcs_n, sizeof(planes[0]));
+	deltas = calloc(job->srcs_n, sizeof(deltas[0]));
+	if (job->error == 0 && (planes == NULL || deltas == NULL)) {
+		fprintf(stderr, "xlingc: out of memory\n");
+		job->error = 1;
+	}
+
+	for (i = 0; job->error == 0 && i < job->srcs_n; i++) {
+		/* Place the frame into the box. */
+		box.px = NULL;
+		box.width = w;
+		box.height = h;
+		job->error = img_compose(&job->srcs[i], 1, &box);
+		if (job->error == 0) {
+			job->error = img_pack(&box, &planes[i]);
+		}
+		img_free_bitmap(&box);
+
+		/* Count the frame images exported once each. */
+		for (j = 0; j < i; j++) {
+			if (memcmp(job->srcs[j].hash, job->srcs[i].hash,
+			    HASH_SZ) == 0) {
+				break;
+			}
+		}
+		if (job->error != 0 || j < i) {
+			continue;
+		}
+		img_crop(&job->srcs[i].bmp, &crop);
+		job->error = img_pack(&job->srcs[i].bmp, &img);
+		if (job->error == 0) {
+			job->error = img_encode_alpha(&img);
+			frames_sz += img.size + img.alpha_size;
+			img_free(&img);
+		}
+	}
+
+	for (i = 0; job->error == 0 && i < job->srcs_n; i++) {
+		job->error = job->srcs[i].key
+		    ? conv_make_delta(&planes[i], NULL, DELTA_KEY, &deltas[i])
+		    : conv_make_delta(&planes[i], &planes[i - 1], 0, &deltas[i]);
+		total += deltas[i].size;
+	}
+	if (job->error != 0) {
+		goto out;
+	}
+
+	job->info.offset.x = 0;
+	job->info.offset.y = 0;
+	job->info.width = w;
+	job->info.height = h;
+	job->info.saved = (total < frames_sz &&
+	    (2 * planes[0].size) <= DELTA_MAX_RAM) ? (frames_sz - total) : 0;
+
+	if (!known) {
+		job->error = out_write_deltas(pool->cfg, hasht, deltas,
+		    job->srcs_n);
+		job->converted = (job->error == 0);
+	}
+
+out:
+	for (i = 0; i < job->srcs_n; i++) {
+		if (planes != NULL) {
+			img_free(&planes[i]);
+		}
+		if (deltas != NULL) {
+			free(deltas[i].data);
+		}
+		if (job->srcs[i].decoded) {
+			img_free_bitmap(&job->srcs[i].bmp);
+		}
+	}
+	free(planes);
+	free(deltas);
+}
+
+/*
+ * Makes a delta of the image with the previous one (or with the empty image
+ * if there is none). Spans of the changed bytes separated by a single byte
+ * which is the same are merged: it's cheaper than a header of the next span.
+ */
+static int
+conv_make_delta(const image_t *img, const image_t *prev, uint8_t flags,
+    delta_t *delta)
+{
+	uint32_t start, last, pos = 0;
+
+#define CHANGED(i)	((prev == NULL)					\
+			    ? (img->data[(i)] != 0 || img->alpha[(i)] != 0)	\
+			    : (img->data[(i)] != prev->data[(i)] ||	\
+			    img->alpha[(i)] != prev->alpha[(i)]))
+
+	/* Every byte might be a span of its own in the worst case. */
+	delta->data = malloc((img->size * 5) + 2);
+	if (delta->data == NULL) {
+		fprintf(stderr, "xlingc: out of memory\n");
+		return (1);
+	}
+	delta->data[pos++] = flags;
+
+	for (uint32_t i = 0; i < img->size; i++) {
+		if (!CHANGED(i)) {
+			continue;
+		}
+		start = last = i;
+		for (i++; i < img->size && (i - start) < DELTA_MAX_SPAN; i++) {
+			if (CHANGED(i)) {
+				last = i;
+			} else if ((i - last) > 1) {
+				break;
+			}
+		}
+		i = last;
+
+		delta->data[pos++] = (uint8_t)(last - start + 1);
+		delta->data[pos++] = (uint8_t)(start & 0xFFu);
+		delta->data[pos++] = (uint8_t)(start >> 8);
+		memcpy(&delta->data[pos], &img->data[start], last - start + 1);
+		pos += last - start + 1;
+		memcpy(&delta->data[pos], &img->alpha[start], last - start + 1);
+		pos += last - start + 1;
+	}
+	delta->data[pos++] = 0;
+	delta->size = pos;
+
+#undef CHANGED
+
+	return (0);
+}
+
+/* Decodes a PNG file and calculates SHA-1 of its pixels. */
+static int
+conv_decode(conv_src_t *src)
+{
+	if (img_load_png(src->path, &src->bmp) != 0) {
+		return (1);
+	}
+	src->decoded = 1;
+	img_calc_sha1(&src->bmp, src->hash);
+	src->hashed = 1;
+
+	return (0);
+}
+
+/*
+ * Calculates SHA-1 of the image. It's SHA-1 of the pixels for an image of a
+ * single PNG file, otherwise, it's SHA-1 of the pixels and positions of all
+ * of the composed files. Shifted images are hashed together with the shift,
+ * deltas are hashed together with the key frames. Tile maps never share
+ * headers with the images of the same pixels.
+ */
+static void
+conv_calc_hash(conv_job_t *job)
+{
+	sha1_ctx_t ctx;
+	uint8_t pt[8], key;
+
+	if (job->srcs_n == 1 && job->shift == 0 && !job->delta &&
+	    !job->tiles) {
+		memcpy(job->hash, job->srcs[0].hash, HASH_SZ);
+		return;
+	}
+
+	sha1_init(&ctx);
+	if (job->shift != 0) {
+		sha1_update(&ctx, "shift", 5);
+		sha1_update(&ctx, &job->shift, 1);
+	}
+	if (job->delta) {
+		sha1_update(&ctx, "delta", 5);
+	} else if (job->tiles) {
+		sha1_update(&ctx, "tiles", 5);
+	} else {
+		sha1_update(&ctx, "flat", 4);
+	}
+	for (uint32_t i = 0; i < job->srcs_n; i++) {
+		for (uint32_t j = 0; j < 4; j++) {
+			pt[j] = (uint8_t)((uint32_t) job->srcs[i].pt.x >>
+			    (24 - (j * 8)));
+			pt[j + 4] = (uint8_t)((uint32_t) job->srcs[i].pt.y >>
+			    (24 - (j * 8)));
+		}
+		sha1_update(&ctx, job->srcs[i].hash, HASH_SZ);
+		sha1_update(&ctx, pt, sizeof(pt));
+		if (job->delta) {
+			key = (uint8_t) job->srcs[i].key;
+			sha1_update(&ctx, &key, 1);
+		}
+	}
+	sha1_final(&ctx, job->hash);
+}
+
+/*
+ * Checks whether an image with the given hash has already been taken by one of
+ * the jobs during this run of the compiler. Remembers the hash if it's a new
+ * one, so that only a single worker writes headers of the same image.
+ */
+static int
+conv_is_block_known(pool_t *pool, const uint8_t *hash)
+{
+	void *p;
+	int known = 0;
+
+	pthread_mutex_lock(&pool->lock);
+
+	for (uint32_t i = 0; i < blocks_n; i++) {
+		if (memcmp(blocks[i], hash, HASH_SZ) == 0) {
+			known = 1;
+			break;
+		}
+	}
+
+	if (!known && blocks_n == blocks_max) {
+		blocks_max = (blocks_max == 0) ? 64 : (blocks_max * 2);
+		p = realloc(blocks, blocks_max * sizeof(blocks[0]));
+		if (p == NULL) {
+			/* Convert it again, it's a waste of time only. */
+			blocks_max = blocks_n;
+		} else {
+			blocks = p;
+		}
+	}
+	if (!known && blocks_n < blocks_max) {
+		memcpy(blocks[blocks_n++], hash, HASH_SZ);
+	}
+
+	pthread_mutex_unlock(&pool->lock);
+
+	return (known);
+}
@@ -0,0 +1,411 @@
+/*-
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * This file is part of xlingc, a standalone asset compiler to generate header
+ * files with graphics for Xling, a tamagotchi-like toy.
+ *
+ * Copyright (c) 2020 Dmitry Salychev
+ *
+ * Xling firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Xling firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+/*
+ * Conversion of the bitmap fonts.
+ *
+ * Fonts are read from the XML documents of the LCD Image Converter (see
+ * common/lcd-image-converter/fonts), every glyph of the document is a PNG
+ * picture. The converter is only used to edit the documents: its templates
+ * can't pack the glyphs, so headers of the fonts are made by "xlingc -f". Only glyphs of the characters used by the string literals of the
+ * given C sources and the extra characters (see -c) are kept, all of them are
+ * kept if neither sources nor extra characters are given.
+ *
+ * Glyphs are packed at their real height instead of the whole display pages:
+ * columns of a glyph follow one after another, each of them takes exactly
+ * "height" bits and the top pixel is the least significant one (see
+ * xg_glyph_t in "xling/graphics.h").
+ */
+
+#include "xlingc.h"
+
+#define CHAR_TAG		"<char "
+#define PICTURE_TAG		"<picture"
+#define PICTURE_END_TAG		"</picture>"
+#define NAME_ATTR		"<data name=\""
+
+static int	 fnt_read_file(const char *path, char **buf, size_t *len);
+static void	 fnt_scan_source(const char *buf, size_t len, uint8_t *used);
+static const char *fnt_scan_escape(const char *p, const char *end,
+		     uint8_t *used);
+static int	 fnt_add_glyph(font_t *font, uint32_t code,
+		     const bitmap_t *bmp);
+static uint8_t	*fnt_decode_base64(const char *p, const char *end,
+		     size_t *len);
+static int	 fnt_cmp_glyphs(const void *a, const void *b);
+
+/*
+ * Compiles a font described by the XML document of the LCD Image Converter
+ * into the <font name>.h header in the output directory.
+ */
+int
+fnt_compile(const xc_config_t *cfg, const char *path, const char *chars,
+    char *const *srcs, int srcs_n)
+{
+	uint8_t used[256];
+	font_t font;
+	bitmap_t bmp;
+	char *doc = NULL, *src, *p, *q, *end;
+	uint8_t *png;
+	size_t len, png_len;
+	unsigned int code;
+	int rc;
+
+	memset(&font, 0, sizeof(font));
+	memset(used, (srcs_n > 0 || chars[0] != '\0') ? 0 : 1, sizeof(used));
+
+	/* Collect characters of the firmware strings. */
+	for (int i = 0; i < srcs_n; i++) {
+		if (fnt_read_file(srcs[i], &src, &len) != 0) {
+			return (1);
+		}
+		fnt_scan_source(src, len, used);
+		free(src);
+	}
+	for (const char *c = chars; (*c) != '\0'; c++) {
+		used[(uint8_t)(*c)] = 1;
+	}
+
+	rc = fnt_read_file(path, &doc, &len);
+	if (rc == 0) {
+		p = strstr(doc, NAME_ATTR);
+		q = (p != NULL) ? strchr(p + strlen(NAME_ATTR), '"') : NULL;
+		if (q == NULL || (size_t)(q - p) - strlen(NAME_ATTR) >=
+		    sizeof(font.name)) {
+			fprintf(stderr, "xlingc: %s: no font name\n", path);
+			rc = 1;
+		} else {
+			p += strlen(NAME_ATTR);
+			memcpy(font.name, p, (size_t)(q - p));
+			font.name[q - p] = '\0';
+		}
+	}
+
+	/* Convert pictures of the used characters. */
+	for (p = doc; rc == 0 && (p = strstr(p, CHAR_TAG)) != NULL; p = end) {
+		q = strstr(p, "code=\"");
+		p = strstr(p, PICTURE_TAG);
+		p = (p != NULL) ? strchr(p, '>') : NULL;
+		end = (p != NULL) ? strstr(p, PICTURE_END_TAG) : NULL;
+		if (q == NULL || end == NULL || q > p ||
+		    sscanf(q, "code=\"%x\"", &code) != 1) {
+			fprintf(stderr, "xlingc: %s: bad glyph\n", path);
+			rc = 1;
+			break;
+		}
+
+		font.total_n++;
+		if (code > 0xFFu || !used[code]) {
+			continue;
+		}
+
+		png = fnt_decode_base64(p + 1, end, &png_len);
+		if (png == NULL) {
+			fprintf(stderr, "xlingc: %s: bad picture of the glyph "
+			    "0x%02x\n", path, code);
+			rc = 1;
+			break;
+		}
+		rc = img_load_png_mem(path, png, png_len, &bmp);
+		free(png);
+		if (rc == 0) {
+			rc = fnt_add_glyph(&font, code, &bmp);
+			img_free_bitmap(&bmp);
+		}
+		if (rc != 0) {
+			fprintf(stderr, "xlingc: %s: can't convert the glyph "
+			    "0x%02x\n", path, code);
+		}
+	}
+
+	/* The firmware looks for glyphs by a binary search. */
+	if (rc == 0) {
+		qsort(font.glyphs, font.glyphs_n, sizeof(font.glyphs[0]),
+		    &fnt_cmp_glyphs);
+		rc = out_write_font(cfg, &font);
+	}
+	if (rc == 0) {
+		printf("%s: %u of %u glyphs, %u bytes\n", font.name,
+		    font.glyphs_n, font.total_n, font.size);
+	}
+
+	free(doc);
+	free(font.glyphs);
+	free(font.bitmaps);
+
+	return (rc);
+}
+
+static int
+fnt_read_file(const char *path, char **buf, size_t *len)
+{
+	FILE *f;
+	long sz;
+	int rc = 0;
+
+	*buf = NULL;
+	f = fopen(path, "rb");
+	if (f == NULL) {
+		fprintf(stderr, "xlingc: can't open %s\n", path);
+		return (1);
+	}
+
+	if (fseek(f, 0, SEEK_END) != 0 || (sz = ftell(f)) < 0 ||
+	    fseek(f, 0, SEEK_SET) != 0) {
+		rc = 1;
+	}
+	if (rc == 0) {
+		*buf = malloc((size_t) sz + 1);
+		rc = (*buf == NULL);
+	}
+	if (rc == 0) {
+		*len = fread(*buf, 1, (size_t) sz, f);
+		(*buf)[*len] = '\0';
+		rc = (ferror(f) != 0);
+	}
+	fclose(f);
+
+	if (rc != 0) {
+		fprintf(stderr, "xlingc: can't read %s\n", path);
+		free(*buf);
+		*buf = NULL;
+	}
+
+	return (rc);
+}
+
+/*
+ * Marks characters of the string literals of a C source as used. Comments,
+ * character constants and file names of the #include directives are skipped.
+ *
+ * NOTE: Characters of the formatted numbers aren't in the literals, they
+ *       should be given by -c.
+ */
+static void
+fnt_scan_source(const char *buf, size_t len, uint8_t *used)
+{
+	const char *p = buf, *end = buf + len, *q;
+	int line_start = 1;
+	char quote;
+
+	while (p < end) {
+		if (line_start && (*p) == '#') {
+			for (q = p + 1; q < end && ((*q) == ' ' ||
+			    (*q) == '\t'); q++) {
+			}
+			if ((size_t)(end - q) >= 7 &&
+			    strncmp(q, "include", 7) == 0) {
+				while (p < end && (*p) != '\n') {
+					p++;
+				}
+				continue;
+			}
+		}
+		if ((*p) == '\n') {
+			line_start = 1;
+			p++;
+			continue;
+		}
+		if (!isspace((unsigned char)(*p))) {
+			line_start = 0;
+		}
+
+		if ((end - p) >= 2 && p[0] == '/' && p[1] == '/') {
+			while (p < end && (*p) != '\n') {
+				p++;
+			}
+		} else if ((end - p) >= 2 && p[0] == '/' && p[1] == '*') {
+			for (p += 2; (end - p) >= 2 && !(p[0] == '*' &&
+			    p[1] == '/'); p++) {
+			}
+			p = ((end - p) >= 2) ? (p + 2) : end;
+		} else if ((*p) == '"' || (*p) == '\'') {
+			quote = *p++;
+			while (p < end && (*p) != quote && (*p) != '\n') {
+				if ((*p) == '\\') {
+					p = fnt_scan_escape(p + 1, end,
+					    (quote == '"') ? used : NULL);
+				} else {
+					if (quote == '"') {
+						used[(uint8_t)(*p)] = 1;
+					}
+					p++;
+				}
+			}
+			p = (p < end) ? (p + 1) : end;
+		} else {
+			p++;
+		}
+	}
+}
+
+/* Marks a character of the escape sequence as used (if it isn't NULL). */
+static const char *
+fnt_scan_escape(const char *p, const char *end, uint8_t *used)
+{
+	static const char simple[] = "n\nt\tr\ra\ab\bf\fv\v";
+	unsigned int c = 0;
+	int n = 0;
+
+	if (p >= end) {
+		return (end);
+	}
+
+	if ((*p) == 'x') {
+		for (p++; p < end && isxdigit((unsigned char)(*p)); p++) {
+			c = (c << 4) | (unsigned int)(isdigit((unsigned char)
+			    (*p)) ? ((*p) - '0') : ((tolower((unsigned char)
+			    (*p)) - 'a') + 10));
+		}
+	} else if ((*p) >= '0' && (*p) <= '7') {
+		for (; p < end && n < 3 && (*p) >= '0' && (*p) <= '7'; n++) {
+			c = (c << 3) | (unsigned int)((*p++) - '0');
+		}
+	} else {
+		c = (uint8_t)(*p);
+		for (uint32_t i = 0; i < sizeof(simple) - 1; i += 2) {
+			if ((*p) == simple[i]) {
+				c = (uint8_t) simple[i + 1];
+				break;
+			}
+		}
+		p++;
+	}
+
+	if (used != NULL) {
+		used[c & 0xFFu] = 1;
+	}
+
+	return (p);
+}
+
+/* Packs the glyph at its real height and appends it to the font. */
+static int
+fnt_add_glyph(font_t *font, uint32_t code, const bitmap_t *bmp)
+{
+	const uint32_t bits = bmp->width * bmp->height;
+	glyph_t *glyph;
+	image_t img;
+	uint32_t bit;
+	void *p;
+
+	if (bmp->width > FONT_MAX_WIDTH || bmp->height > FONT_MAX_HEIGHT ||
+	    font->size + ((bits + 7) / 8) > FONT_MAX_SIZE) {
+		return (1);
+	}
+
+	p = realloc(font->glyphs, (font->glyphs_n + 1) *
+	    sizeof(font->glyphs[0]));
+	if (p == NULL) {
+		return (1);
+	}
+	font->glyphs = p;
+	p = realloc(font->bitmaps, font->size + ((bits + 7) / 8) + 1);
+	if (p == NULL) {
+		return (1);
+	}
+	font->bitmaps = p;
+
+	if (img_pack(bmp, &img) != 0) {
+		return (1);
+	}
+
+	glyph = &font->glyphs[font->glyphs_n++];
+	glyph->code = code;
+	glyph->width = bmp->width;
+	glyph->height = bmp->height;
+	glyph->offset = font->size;
+
+	/* Glyph bitmap starts at a byte boundary. */
+	memset(&font->bitmaps[font->size], 0, (bits + 7) / 8);
+	for (uint32_t x = 0; x < bmp->width; x++) {
+		for (uint32_t y = 0; y < bmp->height; y++) {
+			if ((img.data[((y / PHEIGHT) * img.width) + x] &
+			    (1u << (y % PHEIGHT))) == 0) {
+				continue;
+			}
+			bit = (x * bmp->height) + y;
+			font->bitmaps[font->size + (bit / 8)] |=
+			    (uint8_t)(1u << (bit % 8));
+		}
+	}
+	font->size += (bits + 7) / 8;
+
+	img_free(&img);
+
+	return (0);
+}
+
+static uint8_t *
+fnt_decode_base64(const char *p, const char *end, size_t *len)
+{
+	static const char digits[] =
+	    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	const char *d;
+	uint8_t *buf;
+	uint32_t acc = 0, n = 0;
+
+	buf = malloc(((size_t)(end - p) / 4 * 3) + 3);
+	if (buf == NULL) {
+		return (NULL);
+	}
+	*len = 0;
+
+	for (; p < end && (*p) != '='; p++) {
+		if (isspace((unsigned char)(*p))) {
+			continue;
+		}
+		d = strchr(digits, *p);
+		if (d == NULL || (*p) == '\0') {
+			free(buf);
+			return (NULL);
+		}
+		acc = (acc << 6) | (uint32_t)(d - digits);
+		if ((++n % 4) == 0) {
+			buf[(*len)++] = (uint8_t)(acc >> 16);
+			buf[(*len)++] = (uint8_t)(acc >> 8);
+			buf[(*len)++] = (uint8_t) acc;
+			acc = 0;
+		}
+	}
+	if ((n % 4) == 2) {
+		buf[(*len)++] = (uint8_t)(acc >> 4);
+	} else if ((n % 4) == 3) {
+		buf[(*len)++] = (uint8_t)(acc >> 10);
+		buf[(*len)++] = (uint8_t)(acc >> 2);
+	}
+
+	return (buf);
+}
+
+static int
+fnt_cmp_glyphs(const void *a, const void *b)
+{
+	const glyph_t *ga = a, *gb = b;
+
+	return ((ga->code > gb->code) - (ga->code < gb->code));
+}
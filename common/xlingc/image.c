@@ -0,0 +1,519 @@
+/*-
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * This file is part of xlingc, a standalone asset compiler to generate header
+ * files with graphics for Xling, a tamagotchi-like toy.
+ *
+ * Copyright (c) 2020 Dmitry Salychev
+ *
+ * Xling firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Xling firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <png.h>
+
+/*
+ * Loading of the layer images and their conversion into the page-major
+ * monochrome format of the SH1106 display.
+ *
+ * The conversion repeats what "Xling_SH1106_display_preset" of the LCD Image
+ * Converter does: a pixel is lit if its luminance isn't less than MONO_EDGE,
+ * image is scanned in bands of 8 pixels from the left to the right and the
+ * top pixel of the band goes to the least significant bit of a byte. A pixel
+ * of the alpha channel is opaque if its alpha isn't less than MONO_EDGE.
+ */
+
+#include "xlingc.h"
+
+#define PX_R(bmp, x, y)	((bmp)->px[((((y) * (bmp)->width) + (x)) * 4) + 0])
+#define PX_G(bmp, x, y)	((bmp)->px[((((y) * (bmp)->width) + (x)) * 4) + 1])
+#define PX_B(bmp, x, y)	((bmp)->px[((((y) * (bmp)->width) + (x)) * 4) + 2])
+#define PX_A(bmp, x, y)	((bmp)->px[((((y) * (bmp)->width) + (x)) * 4) + 3])
+
+static int	 img_finish_png(png_image *png, const char *name,
+		     bitmap_t *bmp);
+
+int
+img_load_png(const char *path, bitmap_t *bmp)
+{
+	png_image png;
+
+	memset(&png, 0, sizeof(png));
+	png.version = PNG_IMAGE_VERSION;
+	bmp->px = NULL;
+
+	if (png_image_begin_read_from_file(&png, path) == 0) {
+		fprintf(stderr, "xlingc: %s: %s\n", path, png.message);
+		return (1);
+	}
+
+	return (img_finish_png(&png, path, bmp));
+}
+
+/* Decodes a PNG file which has already been read into memory. */
+int
+img_load_png_mem(const char *name, const uint8_t *buf, size_t len,
+    bitmap_t *bmp)
+{
+	png_image png;
+
+	memset(&png, 0, sizeof(png));
+	png.version = PNG_IMAGE_VERSION;
+	bmp->px = NULL;
+
+	if (png_image_begin_read_from_memory(&png, buf, len) == 0) {
+		fprintf(stderr, "xlingc: %s: %s\n", name, png.message);
+		return (1);
+	}
+
+	return (img_finish_png(&png, name, bmp));
+}
+
+static int
+img_finish_png(png_image *png, const char *name, bitmap_t *bmp)
+{
+	int rc = 0;
+
+	/* Remember whether the original image has transparency. */
+	bmp->has_alpha = (png->format & PNG_FORMAT_FLAG_ALPHA) != 0;
+	bmp->width = png->width;
+	bmp->height = png->height;
+
+	/* Read image as RGBA regardless of its original format. */
+	png->format = PNG_FORMAT_RGBA;
+	bmp->px = malloc(PNG_IMAGE_SIZE(*png));
+	if (bmp->px == NULL) {
+		fprintf(stderr, "xlingc: %s: out of memory\n", name);
+		png_image_free(png);
+		rc = 1;
+	}
+
+	if (rc == 0) {
+		if (png_image_finish_read(png, NULL, bmp->px, 0, NULL) == 0) {
+			fprintf(stderr, "xlingc: %s: %s\n", name,
+			    png->message);
+			img_free_bitmap(bmp);
+			rc = 1;
+		}
+	}
+
+	return (rc);
+}
+
+void
+img_free_bitmap(bitmap_t *bmp)
+{
+	free(bmp->px);
+	bmp->px = NULL;
+}
+
+/*
+ * Calculates SHA-1 hash of the layer pixels. Dimensions of the bitmap are
+ * hashed too, so the same pixels of the differently shaped layers won't
+ * collide.
+ */
+void
+img_calc_sha1(const bitmap_t *bmp, uint8_t *hash)
+{
+	sha1_ctx_t ctx;
+	uint8_t dims[9];
+
+	for (uint32_t i = 0; i < 4; i++) {
+		dims[i] = (uint8_t)(bmp->width >> (24 - (i * 8)));
+		dims[i + 4] = (uint8_t)(bmp->height >> (24 - (i * 8)));
+	}
+	dims[8] = (uint8_t)(bmp->has_alpha != 0);
+
+	sha1_init(&ctx);
+	sha1_update(&ctx, dims, sizeof(dims));
+	sha1_update(&ctx, bmp->px, (size_t) bmp->width * bmp->height * 4u);
+	sha1_final(&ctx, hash);
+}
+
+/*
+ * Composes bitmaps of the layers into a single one. The first layer is on top
+ * of the others, positions of the layers are relative to the top-left corner
+ * of the result. A pixel of the result is taken from the top-most layer where
+ * it's opaque, the result is transparent where none of the layers is opaque.
+ * The result is at least as large as the size given in the bitmap.
+ */
+int
+img_compose(const conv_src_t *srcs, uint32_t srcs_n, bitmap_t *bmp)
+{
+	const bitmap_t *layer;
+	uint32_t w = bmp->width, h = bmp->height, bx, by;
+
+	for (uint32_t i = 0; i < srcs_n; i++) {
+		bx = (uint32_t) srcs[i].pt.x + srcs[i].bmp.width;
+		by = (uint32_t) srcs[i].pt.y + srcs[i].bmp.height;
+		w = (bx > w) ? bx : w;
+		h = (by > h) ? by : h;
+	}
+
+	bmp->width = w;
+	bmp->height = h;
+	bmp->has_alpha = 1;
+	bmp->px = calloc(((size_t) w * h * 4) + 1, 1);
+	if (bmp->px == NULL) {
+		fprintf(stderr, "xlingc: out of memory\n");
+		return (1);
+	}
+
+	/* Paint layers from the bottom one to the top. */
+	for (uint32_t i = srcs_n; i > 0; i--) {
+		layer = &srcs[i - 1].bmp;
+		bx = (uint32_t) srcs[i - 1].pt.x;
+		by = (uint32_t) srcs[i - 1].pt.y;
+
+		for (uint32_t y = 0; y < layer->height; y++) {
+			for (uint32_t x = 0; x < layer->width; x++) {
+				if (PX_A(layer, x, y) < MONO_EDGE) {
+					continue;
+				}
+				memcpy(&PX_R(bmp, bx + x, by + y),
+				    &PX_R(layer, x, y), 4);
+			}
+		}
+	}
+
+	return (0);
+}
+
+/*
+ * Trims transparent margins of the bitmap.
+ *
+ * Columns are trimmed to the tightest box, rows are trimmed by whole pages at
+ * the top (so the pixels stay in the same bits of the page bytes) and to the
+ * last visible row at the bottom. The offset of the top-left corner of what's
+ * left is returned to adjust the position of the layer.
+ *
+ * NOTE: A single transparent pixel is left of the fully transparent bitmap.
+ */
+void
+img_crop(bitmap_t *bmp, block_info_t *info)
+{
+	const uint32_t old_sz = ((bmp->height + PHEIGHT - 1) / PHEIGHT) *
+	    bmp->width * 2;
+	uint32_t x0 = bmp->width, x1 = 0, y0 = bmp->height, y1 = 0;
+	uint32_t width, height;
+
+	info->offset.x = 0;
+	info->offset.y = 0;
+	info->saved = 0;
+
+	if (!bmp->has_alpha) {
+		/* Nothing to trim. */
+		return;
+	}
+
+	for (uint32_t y = 0; y < bmp->height; y++) {
+		for (uint32_t x = 0; x < bmp->width; x++) {
+			if (PX_A(bmp, x, y) >= MONO_EDGE) {
+				x0 = (x < x0) ? x : x0;
+				x1 = (x > x1) ? x : x1;
+				y0 = (y < y0) ? y : y0;
+				y1 = (y > y1) ? y : y1;
+			}
+		}
+	}
+
+	if (x0 > x1) {
+		/* There are no visible pixels at all. */
+		x0 = x1 = 0;
+		y0 = y1 = 0;
+	}
+	y0 -= (y0 % PHEIGHT);
+	width = x1 - x0 + 1;
+	height = y1 - y0 + 1;
+
+	/* Rows are moved towards the beginning, they never overlap. */
+	for (uint32_t y = 0; y < height; y++) {
+		memmove(&bmp->px[y * width * 4], &PX_R(bmp, x0, y0 + y),
+		    width * 4);
+	}
+	bmp->width = width;
+	bmp->height = height;
+
+	info->offset.x = (int32_t) x0;
+	info->offset.y = (int32_t) y0;
+	info->saved = old_sz - (((height + PHEIGHT - 1) / PHEIGHT) * width * 2);
+}
+
+/*
+ * Shifts the bitmap down by adding transparent rows at the top.
+ *
+ * It's used to align the image to the display pages: an image drawn at the
+ * y coordinate which isn't a multiple of PHEIGHT is split between two pages,
+ * the shifted one is drawn at the top of the page and isn't split.
+ */
+int
+img_shift(bitmap_t *bmp, uint32_t shift, block_info_t *info)
+{
+	const size_t row_sz = (size_t) bmp->width * 4;
+	uint8_t *px;
+
+	if (shift == 0) {
+		return (0);
+	}
+
+	px = calloc((row_sz * (bmp->height + shift)) + 1, 1);
+	if (px == NULL) {
+		fprintf(stderr, "xlingc: out of memory\n");
+		return (1);
+	}
+	memcpy(&px[row_sz * shift], bmp->px, row_sz * bmp->height);
+
+	free(bmp->px);
+	bmp->px = px;
+	bmp->height += shift;
+	bmp->has_alpha = 1;
+	info->offset.y -= (int32_t) shift;
+
+	return (0);
+}
+
+/*
+ * Converts RGBA pixels into the monochrome data and 1-bit alpha channel
+ * (the latter only if the bitmap has transparency).
+ *
+ * NOTE: Data bits under the transparent pixels are cleared. They'd be masked
+ *       out while drawing anyway.
+ */
+int
+img_pack(const bitmap_t *bmp, image_t *img)
+{
+	const uint32_t pages = (bmp->height + PHEIGHT - 1) / PHEIGHT;
+	uint32_t idx, lum;
+	uint8_t bit;
+	int rc = 0;
+
+	img->width = bmp->width;
+	img->height = bmp->height;
+	img->size = pages * bmp->width;
+	img->alpha_size = 0;
+	img->alpha_runs = 0;
+	img->data = calloc(img->size > 0 ? img->size : 1, 1);
+	img->alpha = NULL;
+
+	if (img->data == NULL) {
+		rc = 1;
+	}
+	if (rc == 0 && bmp->has_alpha) {
+		img->alpha = calloc(img->size > 0 ? img->size : 1, 1);
+		img->alpha_size = img->size;
+		if (img->alpha == NULL) {
+			img_free(img);
+			rc = 1;
+		}
+	}
+
+	for (uint32_t y = 0; rc == 0 && y < bmp->height; y++) {
+		bit = (uint8_t)(1u << (y % PHEIGHT));
+
+		for (uint32_t x = 0; x < bmp->width; x++) {
+			idx = ((y / PHEIGHT) * bmp->width) + x;
+
+			/* The same weights as in ITU-R BT.601. */
+			lum = ((299u * PX_R(bmp, x, y)) +
+			    (587u * PX_G(bmp, x, y)) +
+			    (114u * PX_B(bmp, x, y))) / 1000u;
+
+			if (bmp->has_alpha && PX_A(bmp, x, y) < MONO_EDGE) {
+				/* Transparent pixel. */
+				continue;
+			}
+			if (img->alpha != NULL) {
+				img->alpha[idx] |= bit;
+			}
+			if (lum >= MONO_EDGE) {
+				img->data[idx] |= bit;
+			}
+		}
+	}
+
+	return (rc);
+}
+
+/*
+ * Encodes alpha channel of the image into runs of transparent, opaque and
+ * masked columns for every page (see xg_alpha_t in "xling/graphics.h").
+ *
+ * Rows below the bottom of the image don't matter while classifying columns
+ * of the last page. Alpha channel is dropped if the whole image is opaque.
+ */
+int
+img_encode_alpha(image_t *img)
+{
+	const uint32_t pages = (img->height + PHEIGHT - 1) / PHEIGHT;
+	uint8_t *runs, *hdr = NULL;
+	uint8_t valid, a, kind, last = 0;
+	uint32_t len = 0, n = 0;
+	int opaque = 1;
+
+	if (img->alpha == NULL || img->alpha_runs) {
+		return (0);
+	}
+
+	/* Header for every mask byte is the worst case. */
+	runs = malloc((img->size * 2) + 1);
+	if (runs == NULL) {
+		return (1);
+	}
+
+	for (uint32_t p = 0; p < pages; p++) {
+		valid = ((img->height - (p * PHEIGHT)) >= PHEIGHT) ? 0xFFu :
+		    (uint8_t)((1u << (img->height - (p * PHEIGHT))) - 1u);
+
+		for (uint32_t x = 0; x < img->width; x++) {
+			a = img->alpha[(p * img->width) + x];
+			if ((a & valid) == 0) {
+				kind = ALPHA_RUN_TRANSPARENT;
+			} else if ((a | (uint8_t) ~valid) == 0xFFu) {
+				kind = ALPHA_RUN_OPAQUE;
+			} else {
+				kind = ALPHA_RUN_MASK;
+			}
+			opaque = opaque && (kind == ALPHA_RUN_OPAQUE);
+
+			/* Runs never cross pages of the image. */
+			if (hdr == NULL || x == 0 || kind != last ||
+			    len == ALPHA_RUN_MAX_LEN) {
+				hdr = &runs[n++];
+				last = kind;
+				len = 0;
+			}
+			len++;
+			(*hdr) = (uint8_t)(kind | (len - 1));
+			if (kind == ALPHA_RUN_MASK) {
+				runs[n++] = a;
+			}
+		}
+	}
+
+	free(img->alpha);
+	if (opaque) {
+		free(runs);
+		img->alpha = NULL;
+		img->alpha_size = 0;
+	} else {
+		img->alpha = runs;
+		img->alpha_size = n;
+		img->alpha_runs = 1;
+	}
+
+	return (0);
+}
+
+/*
+ * Slices an image into tiles of a single page and TILE_WIDTH columns. The same
+ * tiles are stored only once, the image is padded by the empty columns on the
+ * right to be a whole number of tiles wide.
+ *
+ * NOTE: Tile maps are opaque, alpha channel of the image is ignored.
+ */
+int
+img_slice_tiles(const image_t *img, tilemap_t *tm)
+{
+	uint8_t tile[TILE_WIDTH];
+	uint32_t col, idx;
+
+	tm->width = (img->width + TILE_WIDTH - 1) / TILE_WIDTH;
+	tm->height = (img->height + PHEIGHT - 1) / PHEIGHT;
+	tm->tiles_n = 0;
+	tm->tiles = malloc(TILES_MAX * TILE_WIDTH);
+	tm->map = malloc((tm->width * tm->height) + 1);
+	if (tm->tiles == NULL || tm->map == NULL) {
+		fprintf(stderr, "xlingc: out of memory\n");
+		img_free_tiles(tm);
+		return (1);
+	}
+
+	for (uint32_t p = 0; p < tm->height; p++) {
+		for (uint32_t t = 0; t < tm->width; t++) {
+			for (uint32_t x = 0; x < TILE_WIDTH; x++) {
+				col = (t * TILE_WIDTH) + x;
+				tile[x] = (col < img->width)
+				    ? img->data[(p * img->width) + col] : 0u;
+			}
+
+			for (idx = 0; idx < tm->tiles_n; idx++) {
+				if (memcmp(&tm->tiles[idx * TILE_WIDTH], tile,
+				    TILE_WIDTH) == 0) {
+					break;
+				}
+			}
+			if (idx == TILES_MAX) {
+				fprintf(stderr, "xlingc: more than %u different "
+				    "tiles\n", TILES_MAX);
+				img_free_tiles(tm);
+				return (1);
+			} else if (idx == tm->tiles_n) {
+				memcpy(&tm->tiles[idx * TILE_WIDTH], tile,
+				    TILE_WIDTH);
+				tm->tiles_n++;
+			}
+			tm->map[(p * tm->width) + t] = (uint8_t) idx;
+		}
+	}
+
+	return (0);
+}
+
+void
+img_free_tiles(tilemap_t *tm)
+{
+	free(tm->tiles);
+	free(tm->map);
+	tm->tiles = NULL;
+	tm->map = NULL;
+}
+
+/*
+ * Checks whether the image is a horizontal mirror of the other one. Both of
+ * them should be packed, but their alpha channels shouldn't be encoded yet.
+ */
+int
+img_is_mirror(const image_t *img, const image_t *other)
+{
+	const uint32_t w = img->width;
+	uint32_t idx;
+
+	if (img->width != other->width || img->height != other->height ||
+	    (img->alpha == NULL) != (other->alpha == NULL) ||
+	    img->alpha_runs || other->alpha_runs) {
+		return (0);
+	}
+
+	for (uint32_t i = 0; i < img->size; i++) {
+		/* The same column of the other image counted from the right. */
+		idx = ((i / w) * w) + (w - 1 - (i % w));
+		if (img->data[i] != other->data[idx] || (img->alpha != NULL &&
+		    img->alpha[i] != other->alpha[idx])) {
+			return (0);
+		}
+	}
+
+	return (1);
+}
+
+void
+img_free(image_t *img)
+{
+	free(img->data);
+	free(img->alpha);
+	img->data = NULL;
+	img->alpha = NULL;
+}
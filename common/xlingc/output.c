@@ -0,0 +1,467 @@
+/*-
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * This file is part of xlingc, a standalone asset compiler to generate header
+ * files with graphics for Xling, a tamagotchi-like toy.
+ *
+ * Copyright (c) 2020 Dmitry Salychev
+ *
+ * Xling firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Xling firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Writers of the header files with image data.
+ *
+ * Layout of the generated headers follows the "image.tmpl", "image_alpha.tmpl"
+ * and "alpha.tmpl" templates of the LCD Image Converter, so the firmware
+ * can't tell which tool has generated them. The only difference is the alpha
+ * channel: it's encoded into runs of columns (XG_AT_RUNS) and it's dropped
+ * for the opaque images.
+ */
+
+#include "xlingc.h"
+
+#define BYTES_PER_LINE		(16u)
+
+#define LICENSE_HEADER							\
+"/*-\n"									\
+" * SPDX-License-Identifier: GPL-3.0-or-later\n"			\
+" *\n"									\
+" * This file is part of a firmware for Xling, a tamagotchi-like toy.\n"	\
+" *\n"									\
+" * Copyright (c) 2020 Dmitry Salychev\n"				\
+" *\n"									\
+" * Xling firmware is free software: you can redistribute it and/or modify\n" \
+" * it under the terms of the GNU General Public License as published by\n" \
+" * the Free Software Foundation, either version 3 of the License, or\n"	\
+" * (at your option) any later version.\n"				\
+" *\n"									\
+" * Xling firmware is distributed in the hope that it will be useful,\n"	\
+" * but WITHOUT ANY WARRANTY; without even the implied warranty of\n"	\
+" * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the\n"	\
+" * GNU General Public License for more details.\n"			\
+" *\n"									\
+" * You should have received a copy of the GNU General Public License\n"	\
+" * along with this program.  If not, see <https://www.gnu.org/licenses/>.\n" \
+" */\n"
+
+static void	write_bytes(FILE *f, const uint8_t *buf, uint32_t len);
+static int	write_alpha(const xc_config_t *cfg, const char *name,
+		    const image_t *img);
+
+char *
+util_sha1_to_text(const uint8_t *hash, uint32_t hash_sz, char *hasht,
+    uint32_t hasht_sz)
+{
+	char *val = NULL;
+
+	/*
+	 * Check whether we have enough buffer space to keep text representation
+	 * of the hash or not.
+	 */
+	if (hasht_sz >= ((hash_sz * 2) + 1)) {
+		/* Print hash byte by byte. */
+		for (uint32_t i = 0; i < hash_sz; i++) {
+			snprintf(&hasht[i * 2], 3, "%02x", hash[i]);
+		}
+		/* Terminate hash string */
+		hasht[hash_sz * 2] = 0;
+
+		/* Update return value */
+		val = hasht;
+	}
+
+	return (val);
+}
+
+/*
+ * Opens a file in the output directory for writing.
+ *
+ * Content of the file is collected in memory and written down by out_close()
+ * only if it differs from the one on disk: timestamps of the headers which
+ * haven't been changed are kept and the firmware isn't rebuilt needlessly.
+ */
+int
+out_open(const xc_config_t *cfg, const char *name, out_file_t *of)
+{
+	of->buf = NULL;
+	of->len = 0;
+	of->verbose = cfg->verbose;
+	snprintf(of->path, sizeof(of->path), "%s/%s", cfg->out_dir, name);
+
+	of->f = open_memstream(&of->buf, &of->len);
+	if (of->f == NULL) {
+		fprintf(stderr, "xlingc: can't open %s for writing\n",
+		    of->path);
+		return (1);
+	}
+
+	return (0);
+}
+
+/* Writes down content of the file if it has been changed and closes it. */
+int
+out_close(out_file_t *of)
+{
+	uint8_t buf[4096];
+	size_t n, pos = 0;
+	FILE *f;
+	int rc = 0, same = 0;
+
+	if (of->f == NULL) {
+		return (1);
+	}
+	rc = (ferror(of->f) != 0);
+	rc |= (fclose(of->f) != 0);
+	of->f = NULL;
+
+	/* Compare with the file on disk. */
+	f = fopen(of->path, "rb");
+	if (rc == 0 && f != NULL) {
+		same = 1;
+		while (same && (n = fread(buf, 1, sizeof(buf), f)) > 0) {
+			same = (pos + n <= of->len) &&
+			    (memcmp(&of->buf[pos], buf, n) == 0);
+			pos += n;
+		}
+		same = same && (pos == of->len);
+	}
+	if (f != NULL) {
+		fclose(f);
+	}
+
+	if (rc == 0 && !same) {
+		if (of->verbose) {
+			printf("Writing: %s\n", of->path);
+		}
+		f = fopen(of->path, "wb");
+		if (f == NULL) {
+			fprintf(stderr, "xlingc: can't open %s for writing\n",
+			    of->path);
+			rc = 1;
+		} else {
+			rc = (fwrite(of->buf, 1, of->len, f) != of->len);
+			rc |= (fclose(f) != 0);
+		}
+	}
+
+	free(of->buf);
+	of->buf = NULL;
+	of->len = 0;
+
+	return (rc);
+}
+
+/*
+ * Writes <name>.h with the image data (and <name>_a.h with its alpha channel
+ * if the image has transparency).
+ */
+int
+out_write_image(const xc_config_t *cfg, const char *name, const image_t *img)
+{
+	char fname[PATH_MAX_LEN];
+	out_file_t of;
+	FILE *f;
+	int rc = 0;
+
+	snprintf(fname, sizeof(fname), "%s.h", name);
+	rc = out_open(cfg, fname, &of);
+	f = of.f;
+
+	if (rc == 0 && img->alpha != NULL) {
+		rc = write_alpha(cfg, name, img);
+	}
+
+	if (f != NULL) {
+		fprintf(f, LICENSE_HEADER);
+		fprintf(f, "#ifndef XG_IMG_%s_H_\n", name);
+		fprintf(f, "#define XG_IMG_%s_H_ 1\n\n", name);
+		fprintf(f, "#include <stdlib.h>\n");
+		fprintf(f, "#include <stdint.h>\n");
+		fprintf(f, "#include <avr/pgmspace.h>\n\n");
+		fprintf(f, "/*\n"
+		    " * This file with monochrome image%s has been generated\n"
+		    " * for Xling, a tamagotchi-like toy by xlingc.\n"
+		    " *\n"
+		    " * Filename: %s\n"
+		    " * Size: %ux%u px\n"
+		    " */\n\n",
+		    (img->alpha != NULL) ? " with 1-bit alpha channel" : "",
+		    name, img->width, img->height);
+		fprintf(f, "/* Xling graphics header. */\n");
+		fprintf(f, "#include \"xling/graphics.h\"\n\n");
+		if (img->alpha != NULL) {
+			fprintf(f, "/* Header file with alpha channel for the "
+			    "image. */\n");
+			fprintf(f, "#include \"xling/scenes/%s_a.h\"\n\n", name);
+		}
+		fprintf(f, "static const __memx uint8_t XG_IMG_DATA_%s[%u] = "
+		    "{\n", name, img->size);
+		write_bytes(f, img->data, img->size);
+		fprintf(f, "};\n");
+		fprintf(f, "const xg_image_t PROGMEM XG_IMG_%s = {\n", name);
+		fprintf(f, "\t.data = XG_IMG_DATA_%s,\n", name);
+		if (img->alpha != NULL) {
+			fprintf(f, "\t.alpha = XG_IMGA_%s,\n", name);
+		} else {
+			fprintf(f, "\t.alpha = NULL,\n");
+		}
+		fprintf(f, "\t.width = %u,\n", img->width);
+		fprintf(f, "\t.height = %u,\n", img->height);
+		fprintf(f, "\t.data_size = 8,\n");
+		if (img->alpha != NULL && img->alpha_runs) {
+			fprintf(f, "\t.alpha_type = XG_AT_RUNS,\n");
+		}
+		fprintf(f, "};\n");
+		fprintf(f, "#endif /* XG_IMG_%s_H_ */\n", name);
+
+		rc |= out_close(&of);
+	}
+
+	return (rc);
+}
+
+/*
+ * Writes <name>.h with deltas of the animation frames, an array per frame
+ * named as XG_DLT_<name>_<index of the frame>.
+ */
+int
+out_write_deltas(const xc_config_t *cfg, const char *name,
+    const delta_t *deltas, uint32_t deltas_n)
+{
+	char fname[PATH_MAX_LEN];
+	out_file_t of;
+	FILE *f;
+	int rc = 0;
+
+	snprintf(fname, sizeof(fname), "%s.h", name);
+	rc = out_open(cfg, fname, &of);
+	f = of.f;
+
+	if (f != NULL) {
+		fprintf(f, LICENSE_HEADER);
+		fprintf(f, "#ifndef XG_DLT_%s_H_\n", name);
+		fprintf(f, "#define XG_DLT_%s_H_ 1\n\n", name);
+		fprintf(f, "#include <stdint.h>\n");
+		fprintf(f, "#include <avr/pgmspace.h>\n\n");
+		fprintf(f, "/*\n"
+		    " * This file with deltas of animation frames has been "
+		    "generated\n"
+		    " * for Xling, a tamagotchi-like toy by xlingc.\n"
+		    " *\n"
+		    " * Filename: %s\n"
+		    " * Frames: %u\n"
+		    " */\n\n",
+		    name, deltas_n);
+		for (uint32_t i = 0; i < deltas_n; i++) {
+			fprintf(f, "static const __memx uint8_t "
+			    "XG_DLT_%s_%u[%u] = {\n", name, i,
+			    deltas[i].size);
+			write_bytes(f, deltas[i].data, deltas[i].size);
+			fprintf(f, "};\n");
+		}
+		fprintf(f, "#endif /* XG_DLT_%s_H_ */\n", name);
+
+		rc |= out_close(&of);
+	}
+
+	return (rc);
+}
+
+/*
+ * Writes <name>.h with the tile set and the map of a tile map, both are in
+ * flash.
+ */
+int
+out_write_tilemap(const xc_config_t *cfg, const char *name,
+    const tilemap_t *tm)
+{
+	char fname[PATH_MAX_LEN];
+	out_file_t of;
+	FILE *f;
+	int rc = 0;
+
+	snprintf(fname, sizeof(fname), "%s.h", name);
+	rc = out_open(cfg, fname, &of);
+	f = of.f;
+
+	if (f != NULL) {
+		fprintf(f, LICENSE_HEADER);
+		fprintf(f, "#ifndef XG_TLM_%s_H_\n", name);
+		fprintf(f, "#define XG_TLM_%s_H_ 1\n\n", name);
+		fprintf(f, "#include <stdint.h>\n");
+		fprintf(f, "#include <avr/pgmspace.h>\n\n");
+		fprintf(f, "/*\n"
+		    " * This file with tile map has been generated\n"
+		    " * for Xling, a tamagotchi-like toy by xlingc.\n"
+		    " *\n"
+		    " * Filename: %s\n"
+		    " * Size: %ux%u tiles\n"
+		    " * Tiles: %u\n"
+		    " */\n\n",
+		    name, tm->width, tm->height, tm->tiles_n);
+		fprintf(f, "/* Xling graphics header. */\n");
+		fprintf(f, "#include \"xling/graphics.h\"\n\n");
+		fprintf(f, "static const __memx uint8_t XG_TLS_DATA_%s[%u] = "
+		    "{\n", name, tm->tiles_n * TILE_WIDTH);
+		write_bytes(f, tm->tiles, tm->tiles_n * TILE_WIDTH);
+		fprintf(f, "};\n");
+		fprintf(f, "static const __memx uint8_t XG_TLM_DATA_%s[%u] = "
+		    "{\n", name, tm->width * tm->height);
+		write_bytes(f, tm->map, tm->width * tm->height);
+		fprintf(f, "};\n");
+		fprintf(f, "const xg_tilemap_t PROGMEM XG_TLM_%s = {\n", name);
+		fprintf(f, "\t.tiles = XG_TLS_DATA_%s,\n", name);
+		fprintf(f, "\t.map = XG_TLM_DATA_%s,\n", name);
+		fprintf(f, "\t.width = %u,\n", tm->width);
+		fprintf(f, "\t.height = %u,\n", tm->height);
+		fprintf(f, "};\n");
+		fprintf(f, "#endif /* XG_TLM_%s_H_ */\n", name);
+
+		rc |= out_close(&of);
+	}
+
+	return (rc);
+}
+
+/*
+ * Writes <font name>.h with the glyph bitmaps and the glyph table, both are
+ * in flash.
+ */
+int
+out_write_font(const xc_config_t *cfg, const font_t *font)
+{
+	char fname[PATH_MAX_LEN];
+	const glyph_t *glyph;
+	out_file_t of;
+	FILE *f;
+	int rc = 0;
+
+	snprintf(fname, sizeof(fname), "%s.h", font->name);
+	rc = out_open(cfg, fname, &of);
+	f = of.f;
+
+	if (f != NULL) {
+		fprintf(f, LICENSE_HEADER);
+		fprintf(f, "#ifndef XG_FONT_%s_H_\n", font->name);
+		fprintf(f, "#define XG_FONT_%s_H_ 1\n\n", font->name);
+		fprintf(f, "#include <stdint.h>\n");
+		fprintf(f, "#include <avr/pgmspace.h>\n\n");
+		fprintf(f, "/*\n"
+		    " * This file with bitmap font has been generated for "
+		    "Xling,\n"
+		    " * a tamagotchi-like toy, by xlingc.\n"
+		    " *\n"
+		    " * Filename: %s\n"
+		    " * Glyphs: %u of %u\n"
+		    " */\n\n",
+		    font->name, font->glyphs_n, font->total_n);
+		fprintf(f, "/* Xling graphics header */\n");
+		fprintf(f, "#include \"xling/graphics.h\"\n\n");
+		fprintf(f, "/* Glyphs bitmap */\n");
+		fprintf(f, "static const __memx uint8_t "
+		    "XG_FONT_%s_bitmaps[%u] = {\n", font->name, font->size);
+		write_bytes(f, font->bitmaps, font->size);
+		fprintf(f, "};\n\n");
+		fprintf(f, "/* Glyphs */\n");
+		fprintf(f, "static const xg_glyph_t PROGMEM "
+		    "XG_FONT_%s_glyphs[%u] = {\n", font->name,
+		    font->glyphs_n);
+		for (uint32_t i = 0; i < font->glyphs_n; i++) {
+			glyph = &font->glyphs[i];
+			fprintf(f, "\t{ .offset = %u, .code = 0x%02x, "
+			    ".width = %u, .height = %u, },", glyph->offset,
+			    glyph->code, glyph->width, glyph->height);
+			if (glyph->code >= 0x20u && glyph->code < 0x7Fu) {
+				fprintf(f, "\t/* '%s%c' */",
+				    (glyph->code == '\'' || glyph->code == '\\')
+				    ? "\\" : "", (char) glyph->code);
+			}
+			fprintf(f, "\n");
+		}
+		fprintf(f, "};\n\n");
+		fprintf(f, "/* Font */\n");
+		fprintf(f, "const xg_font_t XG_FONT_%s = {\n", font->name);
+		fprintf(f, "\t.glyphs = XG_FONT_%s_glyphs,\n", font->name);
+		fprintf(f, "\t.bitmaps = XG_FONT_%s_bitmaps,\n", font->name);
+		fprintf(f, "\t.length = %u,\n", font->glyphs_n);
+		fprintf(f, "};\n\n");
+		fprintf(f, "#endif /* XG_FONT_%s_H_ */\n", font->name);
+
+		rc |= out_close(&of);
+	}
+
+	return (rc);
+}
+
+static int
+write_alpha(const xc_config_t *cfg, const char *name, const image_t *img)
+{
+	char fname[PATH_MAX_LEN];
+	out_file_t of;
+	FILE *f;
+	int rc = 0;
+
+	snprintf(fname, sizeof(fname), "%s_a.h", name);
+	rc = out_open(cfg, fname, &of);
+	f = of.f;
+
+	if (f != NULL) {
+		fprintf(f, LICENSE_HEADER);
+		fprintf(f, "#ifndef XG_IMGA_%s_H_\n", name);
+		fprintf(f, "#define XG_IMGA_%s_H_ 1\n\n", name);
+		fprintf(f, "#include <stdint.h>\n");
+		fprintf(f, "#include <avr/pgmspace.h>\n\n");
+		fprintf(f, "/*\n"
+		    " * This file with 1-bit alpha channel (runs of columns) "
+		    "for monochrome\n"
+		    " * image has been generated for Xling, a tamagotchi-like "
+		    "toy by xlingc.\n"
+		    " *\n"
+		    " * Filename: %s\n"
+		    " * Size: %ux%u px\n"
+		    " */\n\n",
+		    name, img->width, img->height);
+		fprintf(f, "const __memx uint8_t XG_IMGA_%s[%u] = {\n",
+		    name, img->alpha_size);
+		write_bytes(f, img->alpha, img->alpha_size);
+		fprintf(f, "};\n");
+		fprintf(f, "#endif /* XG_IMGA_%s_H_ */\n", name);
+
+		rc |= out_close(&of);
+	}
+
+	return (rc);
+}
+
+static void
+write_bytes(FILE *f, const uint8_t *buf, uint32_t len)
+{
+	for (uint32_t i = 0; i < len; i++) {
+		if ((i % BYTES_PER_LINE) == 0) {
+			fprintf(f, "\t");
+		}
+		fprintf(f, "0x%02x,", buf[i]);
+		if (((i % BYTES_PER_LINE) == (BYTES_PER_LINE - 1)) ||
+		    (i == (len - 1))) {
+			fprintf(f, "\n");
+		} else {
+			fprintf(f, " ");
+		}
+	}
+}
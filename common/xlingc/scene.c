@@ -0,0 +1,2276 @@
+/*-
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * This file is part of xlingc, a standalone asset compiler to generate header
+ * files with graphics for Xling, a tamagotchi-like toy.
+ *
+ * Copyright (c) 2020 Dmitry Salychev
+ *
+ * Xling firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Xling firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+/*
+ * Scene manifests and their compilation into the scene and animation headers.
+ *
+ * A scene manifest is a text file which lists layers of the scene from the top
+ * to the bottom one, just like the layers dialog of GIMP does. Name of the
+ * manifest (without extension) is a name of the scene. Each line is one of:
+ *
+ *	layer <x> <y> <file> <name>
+ *
+ *		Layer with the top-left corner at (x, y) and pixels in a PNG
+ *		file (relative to the manifest). Name of the layer may contain
+ *		the same tags the xlingtool plug-in understands: !anim(),
+ *		!go(), !stay(), !inactive(), !kbd() and !ignore(). File can be
+ *		"-" for the layers without pixels, e.g. "!kbd()".
+ *
+ *		Animation frame tagged by !loop(path#N) goes to the first frame
+ *		of the path N times in a row, then to its next frame. Use it
+ *		for the scripted sequences, e.g. "blink 3 times, then yawn".
+ *		Loops can't be nested: there's a single loop counter per
+ *		animation.
+ *
+ *		Adjacent static layers tagged by !flat(name) with the same
+ *		name are composed into a single image at export time and
+ *		occupy a single layer of the scene. Use it for the layers which
+ *		never move independently only: indexes of the scene layers,
+ *		e.g. the ones moved by the XG_SCNKBD_* callback, are changed.
+ *
+ *		Static layer tagged by !tiles() is sliced into 8x8 tiles and
+ *		exported as a tile map (see xg_tilemap_t) instead of an image.
+ *		The same tiles are stored only once, so it's the way to go for
+ *		the backgrounds wider than the display. Tile maps are opaque.
+ *
+ *	group <name>
+ *	end
+ *
+ *		Group of layers. Layers of the group are processed in place of
+ *		the group itself. Every top-level group is exported as a group
+ *		of the scene layers (see xg_group_t) which are moved by a single
+ *		offset, nested groups belong to their top-level one. Name of the
+ *		group may contain a !parallax(N%) tag, a factor to scroll the
+ *		group with the scene by (100% by default). Layers outside of
+ *		any group are in the first group of the scene.
+ *
+ *	script <file>
+ *
+ *		Behaviour of the scene: the script (see script.c) is compiled
+ *		into the bytecode of the scene which is run by the firmware
+ *		instead of the XG_SCNKBD_* callback.
+ *
+ * Empty lines and lines starting with '#' are ignored.
+ *
+ * NOTE: Tags are parsed exactly like in the xlingtool plug-in, i.e. the layer
+ *       name is split into tokens by '_' and spaces are treated as '#'.
+ */
+
+#include "xlingc.h"
+
+#define SCENE_COMMENT							\
+"/* ----------------------------------------------------------"		\
+"---------------- */\n"							\
+"/* Scene: %s */\n"							\
+"/* ----------------------------------------------------------"		\
+"---------------- */\n"
+
+/* Rows between the top of the display page and the given y coordinate. */
+#define PAGE_SHIFT(y)		((uint8_t)((((y) % (int32_t) PHEIGHT) +	\
+				    (int32_t) PHEIGHT) % (int32_t) PHEIGHT))
+
+#define REPLACE_STR(str, substr, ch) do {				\
+	char *__rep_subst_pos = NULL;					\
+	while ((__rep_subst_pos = strstr((str), (substr))) != NULL) {	\
+		(*__rep_subst_pos) = (ch);				\
+	}								\
+} while(0)
+
+/******************************************************************************
+ * Local types.
+ ******************************************************************************/
+typedef struct scene_layer_t scene_layer_t;
+typedef struct layer_chk_t layer_chk_t;
+typedef struct layer_ctx_t layer_ctx_t;
+typedef struct anim_t anim_t;
+typedef struct anim_frame_t anim_frame_t;
+typedef struct anim_path_t anim_path_t;
+
+typedef void (*layer_callback_t)(layer_ctx_t *ctx);
+
+/* Different types of checks for layers. */
+typedef enum layer_chk_kind_t {
+	CHECK_INACTIVE = 0,
+	CHECK_BEFORE_IMG,
+	CHECK_AFTER_IMG,
+	CHECK_PER_LAYER
+} layer_chk_kind_t;
+
+/* Helps to describe checks for layers. */
+struct layer_chk_t {
+	layer_chk_kind_t kind;
+	layer_callback_t cbk;
+};
+
+/*
+ * Layer check context.
+ *
+ * Helps to de-duplicate operations between different checks applied to the same
+ * layer like calculating hash, obtaining coordinates, etc.
+ *
+ * Context options:
+ *
+ *	ignore	Ignore this layer (won't be used in any parsing routines,
+ *		won't be exported).
+ */
+struct layer_ctx_t {
+	char		 name[LAYER_MAX_NAME];
+	char		 path[PATH_MAX_LEN];
+	const conv_job_t *job;
+	char		 anim_alt_path_name[ANIM_MAX_NAME];
+	uint8_t		 hash[HASH_SZ];
+	point_t		 base_pt;
+	point_t		 src_pt;	/* Position in the manifest. */
+	uint8_t		 group;		/* Group of the layer. */
+	anim_t		*anim;
+	anim_path_t	*anim_path;
+	uint16_t	 anim_frame_stay;
+	uint8_t		 anim_alt_path_chance;
+	uint8_t		 anim_alt_path_loops;
+
+	int		 has_hash;
+	int		 is_anim_frame;
+	int		 ignore;
+	int		 error;
+};
+
+/* Layer as it's listed in the manifest. */
+typedef struct src_layer_t {
+	char		 name[LAYER_MAX_NAME];
+	char		 path[PATH_MAX_LEN];
+	char		 flat[ANIM_MAX_NAME]; /* Name of the !flat() run. */
+	point_t		 base_pt;
+	int32_t		 job_idx; /* Conversion job, -1 if there is none. */
+	uint8_t		 group;
+} src_layer_t;
+
+/* Top-level group of the layers in the manifest. */
+typedef struct scene_group_t {
+	char		 name[LAYER_MAX_NAME];
+	uint8_t		 parallax; /* In 1/PARALLAX_ONE units. */
+} scene_group_t;
+
+typedef enum layer_obj_t {
+	OT_IMAGE,
+	OT_ANIMATION,
+	OT_TILEMAP
+} layer_obj_t;
+
+struct scene_layer_t {
+	char		 name[LAYER_MAX_NAME];
+	point_t		 base_pt;
+	layer_obj_t	 obj_type;
+	uint8_t		 group;
+};
+
+/*
+ * Animation frame.
+ *
+ * hash		SHA-1 hash of the frame image.
+ * base_pt	Coordinates of the top-left corner of the frame.
+ * src_pt	Coordinates of the frame in the manifest.
+ * job_idx	Index of the conversion job of the frame image.
+ * anim_i	Index of the animation this frame belongs to.
+ * path_i	Index of the animation's path this frame belongs to.
+ * next_i	Index of the next animation frame.
+ * alt_i	Index of the alternative next animation frame.
+ * chance	Chance to draw the alternative frame, in percent.
+ * loops	Number of times to go to the alternative frame, 0 if none.
+ */
+struct anim_frame_t {
+	char		alt_path_name[ANIM_MAX_NAME];
+	uint8_t		hash[HASH_SZ];
+	point_t		base_pt;
+	point_t		src_pt;
+	int32_t		job_idx;
+	uint32_t	anim_idx;
+	uint32_t	path_idx;
+	uint32_t	frame_idx; /* within animation only! */
+	uint32_t	alt_path_idx;
+	uint16_t	stay;
+	uint8_t		alt_path_chance;
+	uint8_t		alt_path_loops;
+};
+
+/*
+ * Animation.
+ *
+ * name		Name of the animation.
+ * paths_i	Indexes of the animation's paths.
+ * delta_idx	Index of the delta job of the frames, -1 if there is none.
+ * origin	Top-left corner of the box with all of the frames.
+ * group	Group of the layers with the frames.
+ * mirror_idx	Index of the animation this one is a mirror of, -1 if none.
+ * mirror_x	Frame pixel at x is the pixel of the original at mirror_x-1-x.
+ */
+struct anim_t {
+	char		name[ANIM_MAX_NAME];
+	uint32_t	paths_idx[ANIM_MAX_PATHS];
+	uint32_t	paths_n;
+	uint32_t	anim_idx;
+	uint8_t		active;
+	int32_t		delta_idx;
+	point_t		origin;
+	uint8_t		group;
+	int32_t		mirror_idx;
+	int32_t		mirror_x;
+};
+
+/* Frames of the animation are stored as deltas. */
+#define ANIM_HAS_DELTAS(anim)	((anim)->delta_idx >= 0 &&		\
+				    jobs[(anim)->delta_idx].info.saved > 0)
+
+/* Animation path. */
+struct anim_path_t {
+	char		name[ANIM_MAX_NAME];
+	uint32_t	frames_idx[ANIM_MAX_FRAMES];
+	uint32_t	frames_n;
+	uint32_t	anim_idx;
+	uint32_t	path_idx;
+};
+
+/******************************************************************************
+ * Prototypes of the local functions.
+ ******************************************************************************/
+static void	 chk_parse_frame(layer_ctx_t *ctx);
+static void	 chk_parse_ignore_tag(layer_ctx_t *ctx);
+static void	 chk_parse_kbd_tag(layer_ctx_t *ctx);
+static void	 chk_parse_anim_tag(layer_ctx_t *ctx);
+static void	 chk_parse_anim_frame(layer_ctx_t *ctx);
+static void	 chk_parse_go_tag(layer_ctx_t *ctx);
+static void	 chk_parse_stay_tag(layer_ctx_t *ctx);
+static void	 chk_parse_loop_tag(layer_ctx_t *ctx);
+static void	 chk_parse_inactive_tag(layer_ctx_t *ctx);
+static void	 chk_link_anim_frames(layer_ctx_t *ctx);
+static void	 chk_update_anim_frame_indexes(layer_ctx_t *ctx);
+static void	 chk_find_mirrored_anims(layer_ctx_t *ctx);
+static void	 chk_encode_anim_deltas(layer_ctx_t *ctx);
+static void	 chk_print_animations(layer_ctx_t *ctx);
+static void	 chk_print_scene_layers(layer_ctx_t *ctx);
+static void	 chk_compile_script(layer_ctx_t *ctx);
+static void	 chk_write_animations_header(layer_ctx_t *ctx);
+static void	 chk_write_scenes_header(layer_ctx_t *ctx);
+
+static int	 util_read_manifest(const char *manifest);
+static int	 util_add_group(const char *name);
+static int	 util_add_layer(const char *name, const char *path,
+		     point_t base_pt, uint8_t group);
+static int	 util_convert_layers(void);
+static conv_job_t *util_add_job(void);
+static int	 util_add_src(conv_job_t *job, const char *path,
+		     point_t pt);
+static void	 util_free_jobs(void);
+static void	 util_write_scene_ram(void);
+static void	 util_write_registry(void);
+static void	 util_write_work_image(const anim_t *anim);
+static void	 util_write_frame_jump(const anim_t *anim,
+		     const anim_frame_t *frame);
+static void	 util_write_delta_frame(const anim_t *anim,
+		     const anim_frame_t *frame);
+static void	 util_write_mirrored_anim(const anim_t *anim);
+static int	 util_is_mirrored_anim(const anim_t *anim,
+		     const anim_t *other, int32_t *mirror_x);
+static int	 util_pack_frame(const anim_frame_t *frame, image_t *img);
+static void	 util_process_layer(layer_ctx_t *ctx);
+static void	 util_run_checks(layer_chk_kind_t kind, layer_ctx_t *ctx);
+static int	 util_scene_name(const char *manifest, char *name, size_t sz);
+
+/******************************************************************************
+ * Compiler-wide variables.
+ ******************************************************************************/
+/* List of check functions to be applied to image layers. */
+static layer_chk_t layer_checks[] = {
+	{ .kind = CHECK_PER_LAYER,	.cbk = &chk_parse_ignore_tag },
+	{ .kind = CHECK_PER_LAYER,	.cbk = &chk_parse_kbd_tag },
+	{ .kind = CHECK_PER_LAYER,	.cbk = &chk_parse_frame },
+	{ .kind = CHECK_PER_LAYER,	.cbk = &chk_parse_anim_tag },
+	{ .kind = CHECK_PER_LAYER,	.cbk = &chk_parse_go_tag },
+	{ .kind = CHECK_PER_LAYER,	.cbk = &chk_parse_stay_tag },
+	{ .kind = CHECK_PER_LAYER,	.cbk = &chk_parse_loop_tag },
+	{ .kind = CHECK_PER_LAYER,	.cbk = &chk_parse_anim_frame },
+	{ .kind = CHECK_PER_LAYER,	.cbk = &chk_parse_inactive_tag },
+
+	{ .kind = CHECK_AFTER_IMG,	.cbk = &chk_link_anim_frames },
+	{ .kind = CHECK_AFTER_IMG,	.cbk = &chk_update_anim_frame_indexes },
+	{ .kind = CHECK_AFTER_IMG,	.cbk = &chk_find_mirrored_anims },
+	{ .kind = CHECK_AFTER_IMG,	.cbk = &chk_encode_anim_deltas },
+	{ .kind = CHECK_AFTER_IMG,	.cbk = &chk_print_animations },
+	{ .kind = CHECK_AFTER_IMG,	.cbk = &chk_print_scene_layers },
+	{ .kind = CHECK_AFTER_IMG,	.cbk = &chk_compile_script },
+	{ .kind = CHECK_AFTER_IMG,	.cbk = &chk_write_animations_header },
+	{ .kind = CHECK_AFTER_IMG,	.cbk = &chk_write_scenes_header },
+};
+static const uint32_t layer_checks_n =
+    sizeof(layer_checks)/sizeof(layer_checks[0]);
+
+/*
+ * Information about scene layers.
+ *
+ * NOTE: Scene layers aren't usually the same as image layers.
+ *       For example, a single animation occupies one scene
+ *       layer, but might contain several frames (each per
+ *       single image layer).
+ */
+static scene_layer_t scene_layers[LAYERS_MAX];
+static uint32_t scene_layers_n;
+
+/* Groups of the scene layers, the first one is for the ungrouped layers. */
+static scene_group_t groups[GROUPS_MAX];
+static uint32_t groups_n;
+
+/* Animations in the scene. */
+static anim_t animations[ANIM_MAX];
+static uint32_t animations_n;
+
+/* Animation paths in the scene. */
+static anim_path_t paths[ANIM_MAX * ANIM_MAX_PATHS];
+static uint32_t paths_n;
+
+/* Animation frames in the scene. */
+static anim_frame_t frames[ANIM_MAX * ANIM_MAX_PATHS * ANIM_MAX_FRAMES];
+static uint32_t frames_n;
+
+/* Layers of the scene in the order they're listed in the manifest. */
+static src_layer_t *src_layers;
+static uint32_t src_layers_n;
+static uint32_t src_layers_max;
+
+/* Conversion jobs for the PNG files of the scene. */
+static conv_job_t *jobs;
+static uint32_t jobs_n;
+static uint32_t jobs_max;
+
+static const xc_config_t *config;
+static char scene_name[SCENE_MAX_NAME];
+static char scene_dir[PATH_MAX_LEN];
+
+/*
+ * Flag to generate a callout function XG_SCNKBD_<scene_name> in order to
+ * process keyboard events. This function should be implemented explicitly.
+ */
+static int kbd = 0;
+
+/* Script of the scene (if any) and its bytecode. */
+static char script_path[PATH_MAX_LEN];
+static script_t script;
+
+/* Names of the compiled scenes to write down their registry. */
+static char scene_names[SCENES_MAX][SCENE_MAX_NAME];
+static uint32_t scenes_n;
+
+static out_file_t of_scenes;
+static out_file_t of_anim;
+static FILE *f_scenes;
+static FILE *f_anim;
+
+/******************************************************************************
+ * Implementation.
+ ******************************************************************************/
+int
+scn_open_headers(const xc_config_t *cfg)
+{
+	int rc = 0;
+
+	config = cfg;
+	scenes_n = 0;
+	rc |= out_open(cfg, "anim.h", &of_anim);
+	rc |= out_open(cfg, "scenes.h", &of_scenes);
+	f_anim = of_anim.f;
+	f_scenes = of_scenes.f;
+
+	if (f_anim != NULL) {
+		fprintf(f_anim, "#ifndef XGANIMATIONS_H_\n");
+		fprintf(f_anim, "#define XGANIMATIONS_H_ 1\n");
+		fprintf(f_anim, "\n");
+		fprintf(f_anim, "#include <avr/pgmspace.h>\n");
+		fprintf(f_anim, "#include \"xling/graphics.h\"\n");
+		fprintf(f_anim, "\n/* RAM of the scenes, see scenes.h. */\n");
+		fprintf(f_anim, "extern union xg_scn_ram_t XG_SCN_RAM;\n");
+	} else {
+		rc = 1;
+	}
+
+	if (f_scenes != NULL) {
+		fprintf(f_scenes, "#ifndef XG_SCENES_H_\n");
+		fprintf(f_scenes, "#define XG_SCENES_H_ 1\n");
+		fprintf(f_scenes, "\n");
+		fprintf(f_scenes, "#include <avr/pgmspace.h>\n");
+		fprintf(f_scenes, "#include \"xling/graphics.h\"\n");
+		fprintf(f_scenes, "#include \"xling/scenes/anim.h\"\n\n");
+	} else {
+		rc = 1;
+	}
+
+	return (rc);
+}
+
+int
+scn_close_headers(void)
+{
+	int rc = 0;
+
+	if (f_anim != NULL) {
+		fprintf(f_anim, "\n#endif /* XGANIMATIONS_H_ */\n");
+		rc |= out_close(&of_anim);
+		f_anim = NULL;
+	}
+	if (f_scenes != NULL) {
+		util_write_registry();
+		fprintf(f_scenes, "#endif /* XG_SCENES_H_ */\n");
+		rc |= out_close(&of_scenes);
+		f_scenes = NULL;
+	}
+
+	free(src_layers);
+	src_layers = NULL;
+	src_layers_n = src_layers_max = 0;
+	util_free_jobs();
+	free(jobs);
+	jobs = NULL;
+	jobs_max = 0;
+	conv_reset();
+
+	return (rc);
+}
+
+/* Compiles a single scene described by the manifest. */
+int
+scn_compile(const xc_config_t *cfg, const char *manifest)
+{
+	layer_ctx_t ctx;
+	int rc = 0;
+
+	config = cfg;
+
+	/* Reset compiler-wide variables */
+	scene_layers_n = 0;
+	animations_n = 0;
+	frames_n = 0;
+	paths_n = 0;
+	kbd = 0;
+	script_path[0] = '\0';
+	src_layers_n = 0;
+	util_free_jobs();
+	memset(&groups[0], 0, sizeof(groups[0]));
+	groups[0].parallax = PARALLAX_ONE;
+	groups_n = 1;
+
+	memset(&ctx, 0, sizeof(ctx));
+
+	if (scenes_n == SCENES_MAX) {
+		fprintf(stderr, "xlingc: %s: too many scenes (max. %u)\n",
+		    manifest, SCENES_MAX);
+		return (1);
+	}
+	rc = util_scene_name(manifest, scene_name, sizeof(scene_name));
+	if (rc != 0) {
+		fprintf(stderr, "xlingc: %s: bad scene name\n", manifest);
+	}
+
+	if (rc == 0) {
+		rc = util_read_manifest(manifest);
+	}
+
+	/* Convert images first, layers can't be processed without them. */
+	if (rc == 0) {
+		rc = util_convert_layers();
+	}
+
+	if (rc == 0) {
+		util_run_checks(CHECK_BEFORE_IMG, &ctx);
+	}
+
+	for (uint32_t i = 0; rc == 0 && i < src_layers_n; i++) {
+		/* Setup context before start of the "leaf" layer. */
+		memcpy(ctx.name, src_layers[i].name, LAYER_MAX_NAME);
+		memcpy(ctx.path, src_layers[i].path, PATH_MAX_LEN);
+		ctx.base_pt = src_layers[i].base_pt;
+		ctx.src_pt = src_layers[i].base_pt;
+		ctx.group = src_layers[i].group;
+		ctx.job = (src_layers[i].job_idx < 0) ? NULL :
+		    &jobs[src_layers[i].job_idx];
+
+		util_process_layer(&ctx);
+		rc = ctx.error;
+	}
+
+	if (rc == 0) {
+		util_run_checks(CHECK_AFTER_IMG, &ctx);
+		rc = ctx.error;
+	}
+
+	return (rc);
+}
+
+/* Reads layers of the scene from the manifest. */
+static int
+util_read_manifest(const char *manifest)
+{
+	char line[PATH_MAX_LEN + LAYER_MAX_NAME];
+	char kw[16], file[PATH_MAX_LEN], path[PATH_MAX_LEN];
+	char *name, *end;
+	point_t base_pt;
+	uint32_t line_n = 0;
+	uint8_t group = 0;
+	int depth = 0;
+	int x, y, pos;
+	FILE *f;
+	int rc = 0;
+
+	f = fopen(manifest, "r");
+	if (f == NULL) {
+		fprintf(stderr, "xlingc: can't open %s\n", manifest);
+		rc = 1;
+	}
+
+	while (rc == 0 && fgets(line, sizeof(line), f) != NULL) {
+		line_n++;
+
+		/* Strip a line ending and skip comments. */
+		line[strcspn(line, "\r\n")] = '\0';
+		name = line;
+		while (isspace((unsigned char)(*name))) {
+			name++;
+		}
+		if ((*name) == '\0' || (*name) == '#') {
+			continue;
+		}
+
+		pos = 0;
+		if (sscanf(name, "%15s %n", kw, &pos) != 1) {
+			rc = 1;
+		} else if (IS_SAME_NAME(kw, "group")) {
+			if (depth++ == 0) {
+				rc = util_add_group(name + pos);
+				group = (uint8_t)(groups_n - 1);
+			}
+		} else if (IS_SAME_NAME(kw, "end")) {
+			depth--;
+			rc = (depth < 0);
+			group = (depth == 0) ? 0u : group;
+		} else if (IS_SAME_NAME(kw, "layer")) {
+			if (sscanf(name, "%15s %d %d %1023s %n", kw, &x, &y,
+			    file, &pos) != 4) {
+				rc = 1;
+			}
+		} else if (IS_SAME_NAME(kw, "script")) {
+			if (script_path[0] != '\0' || sscanf(name,
+			    "%15s %1023s", kw, file) != 2) {
+				rc = 1;
+			} else if (snprintf(script_path, sizeof(script_path),
+			    "%s%s", (file[0] == '/') ? "" : scene_dir,
+			    file) >= (int) sizeof(script_path)) {
+				fprintf(stderr, "xlingc: %s:%u: path is too "
+				    "long\n", manifest, line_n);
+				rc = 1;
+				break;
+			}
+		} else {
+			rc = 1;
+		}
+
+		if (rc != 0) {
+			fprintf(stderr, "xlingc: %s:%u: syntax error\n",
+			    manifest, line_n);
+			break;
+		}
+		if (IS_NOT_SAME_NAME(kw, "layer")) {
+			continue;
+		}
+
+		/* Trim trailing spaces of the layer name. */
+		name += pos;
+		end = name + strlen(name);
+		while (end > name && isspace((unsigned char) end[-1])) {
+			(*(--end)) = '\0';
+		}
+
+		if (IS_SAME_NAME(file, "-")) {
+			path[0] = '\0';
+		} else if (snprintf(path, sizeof(path), "%s%s",
+		    (file[0] == '/') ? "" : scene_dir, file) >=
+		    (int) sizeof(path)) {
+			fprintf(stderr, "xlingc: %s:%u: path is too long\n",
+			    manifest, line_n);
+			rc = 1;
+			break;
+		}
+		base_pt.x = x;
+		base_pt.y = y;
+
+		rc = util_add_layer(name, path, base_pt, group);
+	}
+
+	if (rc == 0 && depth != 0) {
+		fprintf(stderr, "xlingc: %s: unbalanced groups\n", manifest);
+		rc = 1;
+	}
+	if (f != NULL) {
+		fclose(f);
+	}
+
+	return (rc);
+}
+
+/* Appends a top-level group of the layers to the scene. */
+static int
+util_add_group(const char *name)
+{
+	char pct[2];
+	const char *tag;
+	scene_group_t *grp;
+	int parallax = 100;
+
+	if (groups_n == GROUPS_MAX) {
+		fprintf(stderr, "xlingc: %s: too many groups\n", scene_name);
+		return (1);
+	}
+
+	tag = strstr(name, "!parallax(");
+	if (tag != NULL && (sscanf(tag, PARALLAX_TAG_FORMAT, &parallax,
+	    pct) != PARALLAX_TAG_PARTS || parallax < 0 ||
+	    parallax > PARALLAX_MAX)) {
+		fprintf(stderr, "xlingc: %s: bad !parallax() tag of group "
+		    "\"%s\"\n", scene_name, name);
+		return (1);
+	}
+
+	grp = &groups[groups_n++];
+	snprintf(grp->name, sizeof(grp->name), "%s", name);
+	grp->parallax = (uint8_t)(((parallax * (int) PARALLAX_ONE) + 50) /
+	    100);
+
+	return (0);
+}
+
+/*
+ * Appends a layer to the scene. A conversion job is added for the PNG file of
+ * the layer unless it's been added by one of the previous layers. PNG files of
+ * the adjacent layers of the same !flat() run are added to a single job.
+ *
+ * Images of the static layers are shifted to start at the top of the display
+ * page, i.e. they're drawn without splitting bytes between two pages. It isn't
+ * done for the animation frames: there are too many of them to waste flash.
+ */
+static int
+util_add_layer(const char *name, const char *path, point_t base_pt,
+    uint8_t group)
+{
+	char flat[ANIM_MAX_NAME] = "";
+	const char *tag;
+	src_layer_t *layer;
+	uint8_t shift;
+	int tiles;
+	void *p;
+
+	shift = (strstr(name, "!anim(") == NULL) ? PAGE_SHIFT(base_pt.y) : 0u;
+
+	tag = strstr(name, "!flat(");
+	if (tag != NULL && sscanf(tag, FLAT_TAG_FORMAT, flat) !=
+	    FLAT_TAG_PARTS) {
+		fprintf(stderr, "xlingc: %s: bad !flat() tag of \"%s\"\n",
+		    scene_name, name);
+		return (1);
+	}
+	if (tag != NULL && strstr(name, "!anim(") != NULL) {
+		fprintf(stderr, "xlingc: %s: animated layer \"%s\" can't be "
+		    "flattened\n", scene_name, name);
+		return (1);
+	}
+	tiles = (strstr(name, TILES_TAG) != NULL);
+	if (tiles && (tag != NULL || strstr(name, "!anim(") != NULL)) {
+		fprintf(stderr, "xlingc: %s: layer \"%s\" can't be a tile "
+		    "map\n", scene_name, name);
+		return (1);
+	}
+
+	/* Layers without pixels and ignored ones aren't converted. */
+	if (path[0] == '\0' || strstr(name, "!ignore()") != NULL ||
+	    strstr(name, "!kbd()") != NULL) {
+		flat[0] = '\0';
+	}
+
+	/* Continue the run of the flattened layers. */
+	layer = (src_layers_n > 0) ? &src_layers[src_layers_n - 1] : NULL;
+	if (flat[0] != '\0' && layer != NULL && layer->job_idx >= 0 &&
+	    layer->group == group && IS_SAME_NAME(layer->flat, flat)) {
+		layer->base_pt.x = (base_pt.x < layer->base_pt.x)
+		    ? base_pt.x : layer->base_pt.x;
+		layer->base_pt.y = (base_pt.y < layer->base_pt.y)
+		    ? base_pt.y : layer->base_pt.y;
+		jobs[layer->job_idx].shift = PAGE_SHIFT(layer->base_pt.y);
+		return (util_add_src(&jobs[layer->job_idx], path, base_pt));
+	}
+
+	if (src_layers_n == src_layers_max) {
+		src_layers_max = (src_layers_max == 0) ? 64 :
+		    (src_layers_max * 2);
+		p = realloc(src_layers, src_layers_max * sizeof(src_layers[0]));
+		if (p == NULL) {
+			fprintf(stderr, "xlingc: out of memory\n");
+			return (1);
+		}
+		src_layers = p;
+	}
+	layer = &src_layers[src_layers_n++];
+
+	strncpy(layer->name, name, LAYER_MAX_NAME - 1);
+	layer->name[LAYER_MAX_NAME - 1] = '\0';
+	snprintf(layer->path, PATH_MAX_LEN, "%s", path);
+	memcpy(layer->flat, flat, sizeof(flat));
+	layer->base_pt = base_pt;
+	layer->job_idx = -1;
+	layer->group = group;
+
+	if (path[0] == '\0' || strstr(name, "!ignore()") != NULL ||
+	    strstr(name, "!kbd()") != NULL) {
+		return (0);
+	}
+
+	for (uint32_t i = 0; flat[0] == '\0' && i < jobs_n; i++) {
+		if (jobs[i].srcs_n == 1 && jobs[i].shift == shift &&
+		    jobs[i].tiles == tiles && IS_SAME_NAME(jobs[i].srcs[0].path, path)) {
+			layer->job_idx = (int32_t) i;
+			return (0);
+		}
+	}
+
+	if (util_add_job() == NULL) {
+		return (1);
+	}
+	jobs[jobs_n - 1].shift = shift;
+	jobs[jobs_n - 1].tiles = tiles;
+	layer->job_idx = (int32_t)(jobs_n - 1);
+
+	return (util_add_src(&jobs[layer->job_idx], path, base_pt));
+}
+
+/* Appends an empty conversion job. */
+static conv_job_t *
+util_add_job(void)
+{
+	void *p;
+
+	if (jobs_n == jobs_max) {
+		jobs_max = (jobs_max == 0) ? 64 : (jobs_max * 2);
+		p = realloc(jobs, jobs_max * sizeof(jobs[0]));
+		if (p == NULL) {
+			fprintf(stderr, "xlingc: out of memory\n");
+			return (NULL);
+		}
+		jobs = p;
+	}
+	memset(&jobs[jobs_n], 0, sizeof(jobs[0]));
+
+	return (&jobs[jobs_n++]);
+}
+
+/* Adds a PNG file at the given position to the conversion job. */
+static int
+util_add_src(conv_job_t *job, const char *path, point_t pt)
+{
+	conv_src_t *src;
+
+	src = realloc(job->srcs, (job->srcs_n + 1) * sizeof(job->srcs[0]));
+	if (src == NULL) {
+		fprintf(stderr, "xlingc: out of memory\n");
+		return (1);
+	}
+	job->srcs = src;
+	src = &job->srcs[job->srcs_n++];
+
+	memset(src, 0, sizeof(*src));
+	snprintf(src->path, PATH_MAX_LEN, "%s", path);
+	src->pt = pt;
+
+	return (0);
+}
+
+static void
+util_free_jobs(void)
+{
+	for (uint32_t i = 0; i < jobs_n; i++) {
+		free(jobs[i].srcs);
+	}
+	jobs_n = 0;
+}
+
+/*
+ * Converts PNG files of the scene by the worker pool and updates the cache
+ * with the results once all of the workers have finished.
+ */
+static int
+util_convert_layers(void)
+{
+	conv_src_t *src;
+	uint32_t saved = 0;
+	int rc;
+
+	for (uint32_t i = 0; i < src_layers_n; i++) {
+		if (src_layers[i].job_idx < 0) {
+			continue;
+		}
+
+		/*
+		 * Positions of the composed files are relative to the top-left
+		 * corner of the flattened layer.
+		 */
+		for (uint32_t j = 0; j < jobs[src_layers[i].job_idx].srcs_n;
+		    j++) {
+			src = &jobs[src_layers[i].job_idx].srcs[j];
+			if (jobs[src_layers[i].job_idx].srcs_n == 1) {
+				src->pt.x = 0;
+				src->pt.y = 0;
+			} else {
+				src->pt.x -= src_layers[i].base_pt.x;
+				src->pt.y -= src_layers[i].base_pt.y;
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < jobs_n; i++) {
+		for (uint32_t j = 0; j < jobs[i].srcs_n; j++) {
+			src = &jobs[i].srcs[j];
+			src->hashed = (cache_lookup_file(src->path,
+			    src->hash) == 0);
+		}
+	}
+
+	rc = conv_run(config, jobs, jobs_n);
+
+	for (uint32_t i = 0; i < jobs_n; i++) {
+		for (uint32_t j = 0; j < jobs[i].srcs_n; j++) {
+			src = &jobs[i].srcs[j];
+			if (src->decoded) {
+				cache_store_file(src->path, src->hash);
+			}
+		}
+		if (jobs[i].converted) {
+			cache_store_block(config, jobs[i].hash, &jobs[i].info);
+		}
+		saved += jobs[i].info.saved;
+	}
+
+	if (rc == 0) {
+		printf("%s: %u bytes saved by auto-crop\n", scene_name, saved);
+	}
+
+	return (rc);
+}
+
+static void
+util_process_layer(layer_ctx_t *ctx)
+{
+	ctx->is_anim_frame = 0;
+	ctx->has_hash = 0;
+	ctx->ignore = 0;
+	ctx->error = 0;
+	ctx->anim_alt_path_chance = 0;
+	ctx->anim_alt_path_loops = 0;
+	ctx->anim_frame_stay = 0;
+
+	/* Call all per-layer checks for the current layer. */
+	util_run_checks(CHECK_PER_LAYER, ctx);
+}
+
+static void
+util_run_checks(layer_chk_kind_t kind, layer_ctx_t *ctx)
+{
+	for (uint32_t i = 0; i < layer_checks_n; i++) {
+		if (layer_checks[i].kind == kind && ctx->error == 0) {
+			layer_checks[i].cbk(ctx);
+		}
+	}
+}
+
+/*
+ * Parses !ignore() tag from the layer name.
+ */
+static void
+chk_parse_ignore_tag(layer_ctx_t *ctx)
+{
+	if (strstr(ctx->name, "!ignore()") != NULL) {
+		ctx->ignore = 1;
+	}
+}
+
+/*
+ * Parses !kbd() tag from the layer name.
+ */
+static void
+chk_parse_kbd_tag(layer_ctx_t *ctx)
+{
+	if ((ctx->ignore == 0) && (strstr(ctx->name, "!kbd()") != NULL)) {
+		/* Ignore the layer in any other parsing routines. */
+		ctx->ignore = 1;
+		/* Attach a keyboard callback function to the scene. */
+		kbd = 1;
+	}
+}
+
+/*
+ * Takes SHA-1 of the layer pixels from its conversion job (see convert.c) and
+ * moves the layer to the top-left corner of its cropped image.
+ */
+static void
+chk_parse_frame(layer_ctx_t *ctx)
+{
+	if (ctx->ignore) {
+		/* Let's not process ignored layers. */
+		return;
+	}
+	if (ctx->path[0] == '\0' || ctx->job == NULL) {
+		fprintf(stderr, "xlingc: %s: layer \"%s\" has no pixels\n",
+		    scene_name, ctx->name);
+		ctx->error = 1;
+		return;
+	}
+
+	memcpy(ctx->hash, ctx->job->hash, HASH_SZ);
+	ctx->has_hash = 1;
+	ctx->base_pt.x += ctx->job->info.offset.x;
+	ctx->base_pt.y += ctx->job->info.offset.y;
+}
+
+/*
+ * Parses !anim(name, path) tag from the layer name.
+ */
+static void
+chk_parse_anim_tag(layer_ctx_t *ctx)
+{
+	char layer_name[LAYER_MAX_NAME];
+	char anim_name[ANIM_MAX_NAME];
+	char path_name[ANIM_MAX_NAME];
+	char name_buf[(2 * ANIM_MAX_NAME) + 1];
+	char hasht[HASHT_SZ];
+	char *token;
+	scene_layer_t *scn_layer;
+	int rc = 0;
+
+	if (ctx->ignore) {
+		/* Let's not process ignored layers. */
+		return;
+	}
+
+	/* Get a copy of the layer name. */
+	strncpy(layer_name, ctx->name, LAYER_MAX_NAME);
+
+	/* Parse layer name by token. */
+	token = strtok(layer_name, "_");
+	while (token != NULL) {
+		/* Replace all spaces */
+		REPLACE_STR(token, " ", '#');
+
+		/* An attempt to parse the animation tag. */
+		rc = sscanf(token, ANIM_TAG_FORMAT, anim_name, name_buf,
+		    path_name);
+		if (rc == ANIM_TAG_PARTS) {
+			break;
+		}
+
+		/* Go to the next token. */
+		token = strtok(NULL, "_");
+	}
+
+	if (rc == ANIM_TAG_PARTS) {
+		/* Animation tag found! */
+		ctx->is_anim_frame = 1;
+
+		if ((ctx->anim == NULL) ||
+		    (IS_NOT_SAME_NAME(anim_name, ctx->anim->name))) {
+			if (animations_n == ANIM_MAX ||
+			    scene_layers_n == LAYERS_MAX) {
+				fprintf(stderr, "xlingc: %s: too many "
+				    "animations or layers\n", scene_name);
+				ctx->error = 1;
+				return;
+			}
+
+			/* Update current animation in the context. */
+			ctx->anim = &animations[animations_n];
+			memset(ctx->anim, 0, sizeof(*ctx->anim));
+			ctx->anim->anim_idx = animations_n;
+
+			/* Copy name of the animation */
+			strncpy(ctx->anim->name, anim_name, ANIM_MAX_NAME);
+			ctx->anim->group = ctx->group;
+
+			/* Append animation as a new scene layer. */
+			scn_layer = &scene_layers[scene_layers_n];
+			scn_layer->obj_type = OT_ANIMATION;
+			scn_layer->group = ctx->group;
+			scn_layer->base_pt.x = 0;
+			scn_layer->base_pt.y = 0;
+			strncpy(scn_layer->name, anim_name, ANIM_MAX_NAME);
+
+			/* Animation is active by default. */
+			ctx->anim->active = 1;
+
+			/* Increase # of the known animations. */
+			animations_n++;
+			/* Increase # of the known scene layers. */
+			scene_layers_n++;
+		}
+
+		/* All frames are moved by the offset of a single group. */
+		if (ctx->anim->group != ctx->group) {
+			fprintf(stderr, "xlingc: %s: frames of animation \"%s\" "
+			    "are in different groups\n", scene_name,
+			    anim_name);
+			ctx->error = 1;
+			return;
+		}
+
+		/*
+		 * Animation tag should contain a path for the current
+		 * frame also.
+		 */
+		snprintf(name_buf, sizeof(name_buf), "%s@%s", path_name,
+		    anim_name);
+		if (strlen(name_buf) >= ANIM_MAX_NAME) {
+			fprintf(stderr, "xlingc: %s: name of path \"%s\" is "
+			    "too long\n", scene_name, path_name);
+			ctx->error = 1;
+			return;
+		}
+		if ((ctx->anim_path == NULL) ||
+		    (IS_NOT_SAME_NAME(name_buf, ctx->anim_path->name))) {
+			if (ctx->anim->paths_n == ANIM_MAX_PATHS) {
+				fprintf(stderr, "xlingc: %s: animation \"%s\" "
+				    "has too many paths (max. %u)\n",
+				    scene_name, anim_name, ANIM_MAX_PATHS);
+				ctx->error = 1;
+				return;
+			}
+
+			/* Update current animation path in the context. */
+			ctx->anim_path = &paths[paths_n];
+			memset(ctx->anim_path, 0, sizeof(*ctx->anim_path));
+			ctx->anim_path->path_idx = paths_n;
+			ctx->anim_path->anim_idx = ctx->anim->anim_idx;
+
+			/* Append current path to the animation. */
+			ctx->anim->paths_idx[ctx->anim->paths_n] = paths_n;
+			ctx->anim->paths_n++;
+
+			/* Copy name of the path. */
+			strncpy(ctx->anim_path->name, name_buf, ANIM_MAX_NAME);
+
+			/* Increment number of the known paths. */
+			paths_n++;
+		}
+	} else {
+		/* Static image frame. */
+		if (scene_layers_n == LAYERS_MAX) {
+			fprintf(stderr, "xlingc: %s: too many layers\n",
+			    scene_name);
+			ctx->error = 1;
+			return;
+		}
+
+		/* Append image (or tile map) as a new scene layer. */
+		scn_layer = &scene_layers[scene_layers_n];
+		scn_layer->obj_type = (strstr(ctx->name, TILES_TAG) != NULL)
+		    ? OT_TILEMAP : OT_IMAGE;
+		scn_layer->group = ctx->group;
+		scn_layer->base_pt.x = ctx->base_pt.x;
+		scn_layer->base_pt.y = ctx->base_pt.y;
+
+		/* Use image hash as a name of the scene layer. */
+		util_sha1_to_text(ctx->hash, sizeof(ctx->hash), hasht,
+		    sizeof(hasht));
+		strncpy(scn_layer->name, hasht, LAYER_MAX_NAME);
+
+		/* Increase # of the known scene layers. */
+		scene_layers_n++;
+	}
+}
+
+/*
+ * Parses !go(path, chance) tag from the layer name.
+ */
+static void
+chk_parse_go_tag(layer_ctx_t *ctx)
+{
+	char layer_name[LAYER_MAX_NAME];
+	char path_name[ANIM_MAX_NAME];
+	char buf1[ANIM_MAX_NAME];
+	char buf2[ANIM_MAX_NAME];
+	int chance;
+	char *token;
+	int rc = 0;
+
+	if (!ctx->ignore && ctx->is_anim_frame) {
+		/* An animation frame. */
+
+		/* Get a copy of the layer name. */
+		strncpy(layer_name, ctx->name, LAYER_MAX_NAME);
+
+		/* Parse layer name by token. */
+		token = strtok(layer_name, "_");
+		while (token != NULL) {
+			/* Replace all spaces */
+			REPLACE_STR(token, " ", '#');
+
+			/* An attempt to parse the animation tag. */
+			rc = sscanf(token, ANIM_GO_TAG_FORMAT, path_name,
+			    buf1, &chance, buf2);
+			if (rc == ANIM_GO_TAG_PARTS) {
+				break;
+			}
+
+			/* Go to the next token. */
+			token = strtok(NULL, "_");
+		}
+
+		if (rc == ANIM_GO_TAG_PARTS) {
+			/* Go tag found! */
+			if (snprintf(ctx->anim_alt_path_name, ANIM_MAX_NAME,
+			    "%s@%s", path_name, ctx->anim->name) >=
+			    (int) ANIM_MAX_NAME) {
+				fprintf(stderr, "xlingc: %s: name of path "
+				    "\"%s\" is too long\n", scene_name,
+				    path_name);
+				ctx->error = 1;
+				return;
+			}
+			ctx->anim_alt_path_chance = (uint8_t) chance;
+		}
+	} else {
+		/* Not an animation frame - do nothing. */
+	}
+}
+
+/*
+ * Parses !stay(frames_n) from the layer name.
+ */
+static void
+chk_parse_stay_tag(layer_ctx_t *ctx)
+{
+	char layer_name[LAYER_MAX_NAME];
+	char *token;
+	int stay, rc = 0;
+
+	if (!ctx->ignore && ctx->is_anim_frame) {
+		/* An animation frame. */
+
+		/* Get a copy of the layer name. */
+		strncpy(layer_name, ctx->name, LAYER_MAX_NAME);
+
+		/* Parse layer name by token. */
+		token = strtok(layer_name, "_");
+		while (token != NULL) {
+			/* Replace all spaces */
+			REPLACE_STR(token, " ", '#');
+
+			/* An attempt to parse !stay tag. */
+			rc = sscanf(token, ANIM_STAY_TAG_FORMAT, &stay);
+			if (rc == ANIM_STAY_TAG_PARTS) {
+				break;
+			}
+
+			/* Go to the next token. */
+			token = strtok(NULL, "_");
+		}
+
+		if (rc == ANIM_STAY_TAG_PARTS) {
+			/* Stay tag found! */
+			ctx->anim_frame_stay = (uint16_t) stay;
+		}
+	} else {
+		/* Not an animation frame - do nothing. */
+	}
+}
+
+/*
+ * Parses !loop(path, count) from the layer name.
+ */
+static void
+chk_parse_loop_tag(layer_ctx_t *ctx)
+{
+	char layer_name[LAYER_MAX_NAME];
+	char path_name[ANIM_MAX_NAME];
+	char buf[ANIM_MAX_NAME];
+	char *token;
+	int loops, rc = 0;
+
+	if (!ctx->ignore && ctx->is_anim_frame) {
+		/* An animation frame. */
+
+		/* Get a copy of the layer name. */
+		strncpy(layer_name, ctx->name, LAYER_MAX_NAME);
+
+		/* Parse layer name by token. */
+		token = strtok(layer_name, "_");
+		while (token != NULL) {
+			/* Replace all spaces */
+			REPLACE_STR(token, " ", '#');
+
+			/* An attempt to parse !loop tag. */
+			rc = sscanf(token, ANIM_LOOP_TAG_FORMAT, path_name,
+			    buf, &loops);
+			if (rc == ANIM_LOOP_TAG_PARTS) {
+				break;
+			}
+
+			/* Go to the next token. */
+			token = strtok(NULL, "_");
+		}
+
+		if (rc == ANIM_LOOP_TAG_PARTS && loops > 0 &&
+		    loops <= (int) ANIM_MAX_LOOPS) {
+			/* Loop tag found! It overrides the !go tag. */
+			if (snprintf(ctx->anim_alt_path_name, ANIM_MAX_NAME,
+			    "%s@%s", path_name, ctx->anim->name) >=
+			    (int) ANIM_MAX_NAME) {
+				fprintf(stderr, "xlingc: %s: name of path "
+				    "\"%s\" is too long\n", scene_name,
+				    path_name);
+				ctx->error = 1;
+				return;
+			}
+			ctx->anim_alt_path_chance = 0;
+			ctx->anim_alt_path_loops = (uint8_t) loops;
+		}
+	} else {
+		/* Not an animation frame - do nothing. */
+	}
+}
+
+/*
+ * Adds current layer's image as an animation frame to the list of frames and
+ * updates its animation path.
+ */
+static void
+chk_parse_anim_frame(layer_ctx_t *ctx)
+{
+	anim_frame_t *frame;
+
+	if (!ctx->ignore && ctx->is_anim_frame) {
+		/* An animation frame. */
+		if (ctx->anim_path->frames_n == ANIM_MAX_FRAMES) {
+			fprintf(stderr, "xlingc: %s: path \"%s\" has too many "
+			    "frames (max. %u)\n", scene_name,
+			    ctx->anim_path->name, ANIM_MAX_FRAMES);
+			ctx->error = 1;
+			return;
+		}
+		frame = &frames[frames_n];
+		memset(frame, 0, sizeof(*frame));
+		frame->anim_idx = ctx->anim->anim_idx;
+		frame->path_idx = ctx->anim_path->path_idx;
+		frame->base_pt = ctx->base_pt;
+		frame->src_pt = ctx->src_pt;
+		frame->job_idx = (int32_t)(ctx->job - jobs);
+		frame->stay = ctx->anim_frame_stay;
+
+		/* Alternative path for this frame */
+		if (ctx->anim_alt_path_chance > 0u ||
+		    ctx->anim_alt_path_loops > 0u) {
+			strncpy(frame->alt_path_name, ctx->anim_alt_path_name,
+			    ANIM_MAX_NAME);
+			frame->alt_path_chance = ctx->anim_alt_path_chance;
+			frame->alt_path_loops = ctx->anim_alt_path_loops;
+		}
+
+		/* Append frame to the path */
+		ctx->anim_path->frames_idx[ctx->anim_path->frames_n] =
+		    frames_n;
+		ctx->anim_path->frames_n++;
+
+		/* Copy hash of the frame. */
+		memcpy(frame->hash, ctx->hash, HASH_SZ);
+
+		/* Increment number of the known animation frames. */
+		frames_n++;
+	} else {
+		/* Not an animation frame - do nothing. */
+	}
+}
+
+/*
+ * Parses !inactive() tag from the layer's name.
+ *
+ * NOTE: Requires animation to be available in the layer context.
+ */
+static void
+chk_parse_inactive_tag(layer_ctx_t *ctx)
+{
+	if (!ctx->ignore && ctx->is_anim_frame) {
+		/* An animation frame. */
+		if (strstr(ctx->name, "!inactive()") != NULL) {
+			/* Mark animation as inactive. */
+			ctx->anim->active = 0;
+		}
+	} else {
+		/* Not an animation frame - do nothing. */
+	}
+}
+
+/*
+ * Resolve alternative path names to path indexes. A frame which goes to an
+ * unknown path is an error.
+ */
+static void
+chk_link_anim_frames(layer_ctx_t *ctx)
+{
+	anim_frame_t *frame;
+	const anim_path_t *path;
+	uint32_t j, k;
+
+	for (uint32_t i = 0; i < frames_n; i++) {
+		frame = &frames[i];
+
+		if (frame->alt_path_chance > 0u ||
+		    frame->alt_path_loops > 0u) {
+			/* Frame has an alternative path. */
+			for (j = 0; j < paths_n; j++) {
+				if (IS_SAME_NAME(frame->alt_path_name,
+				    paths[j].name)) {
+					frame->alt_path_idx = j;
+					break;
+				}
+			}
+			if (j == paths_n) {
+				path = &paths[frame->path_idx];
+				for (k = 0; path->frames_idx[k] != i; k++) {
+				}
+				fprintf(stderr, "xlingc: %s: frame %u of path "
+				    "\"%s\" goes to unknown path \"%s\"\n",
+				    scene_name, k, path->name,
+				    frame->alt_path_name);
+				ctx->error = 1;
+				return;
+			}
+		}
+	}
+}
+
+static void
+chk_update_anim_frame_indexes(layer_ctx_t *ctx)
+{
+	anim_t *anim;
+	anim_path_t *path;
+	anim_frame_t *frame;
+	uint32_t frame_idx;
+
+	(void) ctx;
+
+	/* Animations */
+	for (uint32_t i = 0; i < animations_n; i++) {
+		/* Reset frame index for each animation. */
+		frame_idx = 0;
+
+		anim = &animations[i];
+
+		/* Paths */
+		for (uint32_t j = 0; j < anim->paths_n; j++) {
+			path = &paths[anim->paths_idx[j]];
+
+			/* Frames */
+			for (uint32_t k = 0; k < path->frames_n; k++) {
+				frame = &frames[path->frames_idx[k]];
+
+				frame->frame_idx = frame_idx;
+				frame_idx++;
+			}
+		}
+	}
+}
+
+/*
+ * Finds animations which are horizontal mirrors of the previous ones, e.g. a
+ * character facing the other way. Mirrored animation is drawn from the frames
+ * of the original one, so its own frames aren't exported at all.
+ */
+static void
+chk_find_mirrored_anims(layer_ctx_t *ctx)
+{
+	anim_t *anim;
+	uint32_t mirrored = 0;
+
+	(void) ctx;
+
+	for (uint32_t i = 0; i < animations_n; i++) {
+		anim = &animations[i];
+		anim->mirror_idx = -1;
+
+		for (uint32_t j = 0; j < i; j++) {
+			if (animations[j].mirror_idx < 0 &&
+			    util_is_mirrored_anim(&animations[j], anim,
+			    &anim->mirror_x)) {
+				anim->mirror_idx = (int32_t) j;
+				mirrored++;
+				break;
+			}
+		}
+	}
+
+	printf("%s: %u mirrored animations\n", scene_name, mirrored);
+}
+
+/*
+ * Converts frames of every animation into deltas (see conv_do_delta()) by the
+ * worker pool once the images of the frames are known. Positions of the frames
+ * are relative to the top-left corner of the box with all of them.
+ */
+static void
+chk_encode_anim_deltas(layer_ctx_t *ctx)
+{
+	const uint32_t first = jobs_n;
+	anim_t *anim;
+	anim_path_t *path;
+	anim_frame_t *frame;
+	conv_job_t *job;
+	conv_src_t *src;
+	point_t pt;
+	uint32_t n, saved = 0;
+
+	for (uint32_t i = 0; ctx->error == 0 && i < animations_n; i++) {
+		anim = &animations[i];
+		anim->delta_idx = -1;
+		if (anim->mirror_idx >= 0) {
+			/* Frames of the original animation are used. */
+			continue;
+		}
+
+		/* Find the box with all of the frames. */
+		n = 0;
+		for (uint32_t j = 0; j < anim->paths_n; j++) {
+			path = &paths[anim->paths_idx[j]];
+			for (uint32_t k = 0; k < path->frames_n; k++) {
+				frame = &frames[path->frames_idx[k]];
+				pt = (n++ == 0) ? frame->src_pt : anim->origin;
+				anim->origin.x = (frame->src_pt.x < pt.x)
+				    ? frame->src_pt.x : pt.x;
+				anim->origin.y = (frame->src_pt.y < pt.y)
+				    ? frame->src_pt.y : pt.y;
+			}
+		}
+		if (n < 2) {
+			continue;
+		}
+
+		job = util_add_job();
+		if (job == NULL) {
+			ctx->error = 1;
+			break;
+		}
+		job->delta = 1;
+		anim->delta_idx = (int32_t)(jobs_n - 1);
+
+		for (uint32_t j = 0; ctx->error == 0 && j < anim->paths_n;
+		    j++) {
+			path = &paths[anim->paths_idx[j]];
+			for (uint32_t k = 0; k < path->frames_n; k++) {
+				frame = &frames[path->frames_idx[k]];
+				src = &jobs[frame->job_idx].srcs[0];
+				pt.x = frame->src_pt.x - anim->origin.x;
+				pt.y = frame->src_pt.y - anim->origin.y;
+				ctx->error = util_add_src(job, src->path, pt);
+				if (ctx->error != 0) {
+					break;
+				}
+				memcpy(job->srcs[job->srcs_n - 1].hash,
+				    src->hash, HASH_SZ);
+				job->srcs[job->srcs_n - 1].hashed = 1;
+				job->srcs[job->srcs_n - 1].key = (k == 0);
+			}
+		}
+	}
+	if (ctx->error != 0 || jobs_n == first) {
+		return;
+	}
+
+	ctx->error = conv_run(config, &jobs[first], jobs_n - first);
+
+	/* Mirrored animations have their own work images for the deltas. */
+	for (uint32_t i = 0; i < animations_n; i++) {
+		anim = &animations[i];
+		if (anim->mirror_idx >= 0) {
+			anim->delta_idx =
+			    animations[anim->mirror_idx].delta_idx;
+		}
+	}
+
+	for (uint32_t i = first; i < jobs_n; i++) {
+		if (jobs[i].converted) {
+			cache_store_block(config, jobs[i].hash, &jobs[i].info);
+		}
+		saved += jobs[i].info.saved;
+	}
+
+	if (ctx->error == 0) {
+		printf("%s: %u bytes saved by delta frames\n", scene_name,
+		    saved);
+	}
+}
+
+static void
+chk_print_animations(layer_ctx_t *ctx)
+{
+	anim_t *anim;
+	anim_path_t *path;
+	anim_frame_t *frame, *alt;
+	char hasht[HASHT_SZ];
+	char hasht2[HASHT_SZ];
+
+	(void) ctx;
+
+	if (!config->verbose) {
+		return;
+	}
+
+	printf("\n--- Animations (%s) ---\n", scene_name);
+
+	/* Animations */
+	for (uint32_t i = 0; i < animations_n; i++) {
+		anim = &animations[i];
+		if (anim->mirror_idx >= 0) {
+			printf("%s (mirror of %s about x = %d)\n", anim->name,
+			    animations[anim->mirror_idx].name,
+			    anim->mirror_x);
+			continue;
+		}
+		printf("%s\n", anim->name);
+
+		/* Paths */
+		for (uint32_t j = 0; j < anim->paths_n; j++) {
+			path = &paths[anim->paths_idx[j]];
+			printf("\t%s\n", path->name);
+
+			/* Frames */
+			for (uint32_t k = 0; k < path->frames_n; k++) {
+				frame = &frames[path->frames_idx[k]];
+
+				util_sha1_to_text(frame->hash, HASH_SZ, hasht,
+				    sizeof(hasht));
+
+				if (frame->alt_path_loops > 0u) {
+					/* There's a loop */
+					alt = &frames[paths[frame->alt_path_idx]
+					    .frames_idx[0]];
+					util_sha1_to_text(alt->hash, HASH_SZ,
+					    hasht2, sizeof(hasht2));
+
+					printf("\t\t#%u %s at (%d, %d) ---> "
+					    "#%u %s x%u\n",
+					    frame->frame_idx, hasht,
+					    frame->base_pt.x, frame->base_pt.y,
+					    alt->frame_idx, hasht2,
+					    frame->alt_path_loops);
+				} else if (frame->alt_path_chance > 0u) {
+					/* There's an alternative path */
+					alt = &frames[paths[frame->alt_path_idx]
+					    .frames_idx[0]];
+					util_sha1_to_text(alt->hash, HASH_SZ,
+					    hasht2, sizeof(hasht2));
+
+					printf("\t\t#%u %s at (%d, %d) ---> "
+					    "#%u %s %u%%\n",
+					    frame->frame_idx, hasht,
+					    frame->base_pt.x, frame->base_pt.y,
+					    alt->frame_idx, hasht2,
+					    frame->alt_path_chance);
+				} else {
+					printf("\t\t#%u %s at (%d, %d)\n",
+					    frame->frame_idx, hasht,
+					    frame->base_pt.x, frame->base_pt.y);
+				}
+			}
+		}
+	}
+}
+
+static void
+chk_print_scene_layers(layer_ctx_t *ctx)
+{
+	(void) ctx;
+
+	if (!config->verbose) {
+		return;
+	}
+
+	printf("\n--- Scene layers (%s) ---\n", scene_name);
+
+	for (uint32_t i = 0; i < scene_layers_n; i++) {
+		printf("%u %s (group %u)\n", i, scene_layers[i].name,
+		    scene_layers[i].group);
+	}
+}
+
+/*
+ * Compiles the script of the scene (if any). Script refers to the animations
+ * by their names, so they're resolved to the scene layers here.
+ */
+static void
+chk_compile_script(layer_ctx_t *ctx)
+{
+	static script_layer_t layers[LAYERS_MAX];
+	const anim_t *anim;
+	uint32_t layers_n = 0;
+
+	if (script_path[0] == '\0') {
+		return;
+	}
+
+	for (uint32_t i = 0; i < scene_layers_n; i++) {
+		if (scene_layers[i].obj_type != OT_ANIMATION) {
+			continue;
+		}
+		for (uint32_t j = 0; j < animations_n; j++) {
+			anim = &animations[j];
+			if (IS_NOT_SAME_NAME(anim->name,
+			    scene_layers[i].name)) {
+				continue;
+			}
+			layers[layers_n].name = anim->name;
+			layers[layers_n].idx = i;
+			layers[layers_n].group = anim->group;
+			layers[layers_n].x = ANIM_HAS_DELTAS(anim) ?
+			    anim->origin.x : frames[paths[anim->paths_idx[0]]
+			    .frames_idx[0]].base_pt.x;
+			layers_n++;
+			break;
+		}
+	}
+
+	ctx->error = scr_compile(script_path, layers, layers_n, &script);
+}
+
+static void
+chk_write_animations_header(layer_ctx_t *ctx)
+{
+	anim_t *anim;
+	anim_path_t *path;
+	anim_frame_t *frame;
+	uint16_t n;
+	char hasht[HASHT_SZ];
+
+	(void) ctx;
+
+	if (f_anim != NULL) {
+		fprintf(f_anim, "\n");
+		fprintf(f_anim, SCENE_COMMENT, scene_name);
+
+		/*
+		 * Iterate over all of the animations in order to include
+		 * headers with frames data.
+		 */
+		for (uint32_t i = 0; i < animations_n; i++) {
+			anim = &animations[i];
+			if (anim->mirror_idx >= 0) {
+				continue;
+			}
+			if (ANIM_HAS_DELTAS(anim)) {
+				util_sha1_to_text(jobs[anim->delta_idx].hash,
+				    HASH_SZ, hasht, sizeof(hasht));
+				fprintf(f_anim,
+				    "#include \"xling/scenes/%s.h\"\n", hasht);
+				continue;
+			}
+			/* Paths */
+			for (uint32_t j = 0; j < anim->paths_n; j++) {
+				path = &paths[anim->paths_idx[j]];
+				/* Frames */
+				for (uint32_t k = 0; k < path->frames_n; k++) {
+					frame = &frames[path->frames_idx[k]];
+
+					/* Obtain a text form of the hash */
+					util_sha1_to_text(frame->hash, HASH_SZ,
+					    hasht, sizeof(hasht));
+
+					fprintf(f_anim,
+					    "#include \"xling/scenes/%s.h\"\n",
+					    hasht);
+				}
+			}
+		}
+
+		fprintf(f_anim, "\n");
+		util_write_scene_ram();
+
+		/* Animations */
+		for (uint32_t i = 0; i < animations_n; i++) {
+			anim = &animations[i];
+			n = 0;
+
+			fprintf(f_anim, "\n");
+			if (ANIM_HAS_DELTAS(anim)) {
+				util_write_work_image(anim);
+			}
+			if (anim->mirror_idx >= 0) {
+				util_write_mirrored_anim(anim);
+				continue;
+			}
+			fprintf(f_anim, "const xg_anim_frame_t PROGMEM "
+			    "XG_ANMF_%s_%s[] = {\n", scene_name, anim->name);
+
+			/* Paths */
+			for (uint32_t j = 0; j < anim->paths_n; j++) {
+				path = &paths[anim->paths_idx[j]];
+
+				/* Frames */
+				for (uint32_t k = 0; k < path->frames_n; k++) {
+					frame = &frames[path->frames_idx[k]];
+
+					/* Obtain a text form of the hash */
+					util_sha1_to_text(frame->hash, HASH_SZ,
+					    hasht, sizeof(hasht));
+
+					if (ANIM_HAS_DELTAS(anim)) {
+						util_write_delta_frame(anim,
+						    frame);
+						n++;
+						continue;
+					}
+
+					fprintf(f_anim, "\t{ "
+					    ".base_pt = { %d, %d }, ",
+					    frame->base_pt.x, frame->base_pt.y);
+					util_write_frame_jump(anim, frame);
+					fprintf(f_anim,
+					    ".img = &XG_IMG_%s, "
+					    ".stay = %u, "
+					    "},\n",
+					    hasht, frame->stay);
+
+					/* Increase # of the frames. */
+					n++;
+				}
+			}
+
+			fprintf(f_anim, "};\n");
+			fprintf(f_anim, "const xg_anim_t PROGMEM XG_ANM_%s_%s = { "
+			    ".frames = XG_ANMF_%s_%s, "
+			    ".frames_n = %u, "
+			    ".state = &XG_ANMS_%s_%s, "
+			    ".active = %u, ",
+			    scene_name, anim->name,
+			    scene_name, anim->name, n,
+			    scene_name, anim->name, anim->active
+			);
+			if (ANIM_HAS_DELTAS(anim)) {
+				fprintf(f_anim, ".work = &XG_ANMW_%s_%s, ",
+				    scene_name, anim->name);
+			}
+			fprintf(f_anim, "};\n");
+		}
+	}
+}
+
+/*
+ * Writes down the parts of the scene in RAM: offsets of the groups, the pan,
+ * states of the animations and data of their work images. They're fields of
+ * a structure, RAM of all scenes is a union of such structures (XG_SCN_RAM),
+ * i.e. it's taken by the entered scene only and initialized by
+ * xg_enter_scene() at run time. Names of the fields are available as macros.
+ */
+static void
+util_write_scene_ram(void)
+{
+	const anim_t *anim;
+	const block_info_t *info;
+	uint32_t size;
+
+	fprintf(f_anim, "typedef struct xg_scnr_%s_t {\n", scene_name);
+	fprintf(f_anim, "\txg_point_t offsets[%u];\n", groups_n);
+	fprintf(f_anim, "\txg_point_t pan;\n");
+	if (script_path[0] != '\0' && script.vars_n > 0) {
+		fprintf(f_anim, "\tuint8_t vars[%u];\n", script.vars_n);
+	}
+	for (uint32_t i = 0; i < animations_n; i++) {
+		anim = &animations[i];
+		fprintf(f_anim, "\txg_anim_state_t anms_%s;\n", anim->name);
+		if (ANIM_HAS_DELTAS(anim)) {
+			info = &jobs[anim->delta_idx].info;
+			size = info->width * ((info->height + PHEIGHT - 1) /
+			    PHEIGHT);
+			fprintf(f_anim, "\tuint8_t anmw_data_%s[%u];\n",
+			    anim->name, size);
+			fprintf(f_anim, "\tuint8_t anmw_alpha_%s[%u];\n",
+			    anim->name, size);
+		}
+	}
+	fprintf(f_anim, "} xg_scnr_%s_t;\n", scene_name);
+
+	fprintf(f_anim, "#define XG_SCNR_%s ((xg_scnr_%s_t *) &XG_SCN_RAM)\n",
+	    scene_name, scene_name);
+	fprintf(f_anim, "#define XG_SCNO_%s (XG_SCNR_%s->offsets)\n",
+	    scene_name, scene_name);
+	fprintf(f_anim, "#define XG_SCNP_%s (XG_SCNR_%s->pan)\n",
+	    scene_name, scene_name);
+	if (script_path[0] != '\0' && script.vars_n > 0) {
+		fprintf(f_anim, "#define XG_SCNV_%s (XG_SCNR_%s->vars)\n",
+		    scene_name, scene_name);
+	}
+	for (uint32_t i = 0; i < animations_n; i++) {
+		anim = &animations[i];
+		fprintf(f_anim, "#define XG_ANMS_%s_%s (XG_SCNR_%s->anms_%s)\n",
+		    scene_name, anim->name, scene_name, anim->name);
+		if (ANIM_HAS_DELTAS(anim)) {
+			fprintf(f_anim, "#define XG_ANMW_DATA_%s_%s "
+			    "(XG_SCNR_%s->anmw_data_%s)\n",
+			    scene_name, anim->name, scene_name, anim->name);
+			fprintf(f_anim, "#define XG_ANMW_ALPHA_%s_%s "
+			    "(XG_SCNR_%s->anmw_alpha_%s)\n",
+			    scene_name, anim->name, scene_name, anim->name);
+		}
+	}
+}
+
+/*
+ * Writes down RAM of the scenes and their registry in flash. Only a single
+ * scene is entered at a time, so they share RAM: it's as large as RAM of the
+ * largest scene.
+ */
+static void
+util_write_registry(void)
+{
+	if (scenes_n == 0) {
+		return;
+	}
+
+	fprintf(f_scenes, "/* RAM of the scenes, see xg_enter_scene(). */\n");
+	fprintf(f_scenes, "union xg_scn_ram_t {\n");
+	for (uint32_t i = 0; i < scenes_n; i++) {
+		fprintf(f_scenes, "\txg_scnr_%s_t %s;\n", scene_names[i],
+		    scene_names[i]);
+	}
+	fprintf(f_scenes, "};\n");
+	fprintf(f_scenes, "union xg_scn_ram_t XG_SCN_RAM;\n\n");
+
+	fprintf(f_scenes, "/* Registry of the scenes, see xg_switch_scene(). "
+	    "*/\n");
+	for (uint32_t i = 0; i < scenes_n; i++) {
+		fprintf(f_scenes, "#define XG_SCN_IDX_%s (%uu)\n",
+		    scene_names[i], i);
+	}
+	fprintf(f_scenes, "#define XG_SCENES_N (%uu)\n", scenes_n);
+	fprintf(f_scenes, "const xg_scene_t * const PROGMEM XG_SCENES[] = {\n");
+	for (uint32_t i = 0; i < scenes_n; i++) {
+		fprintf(f_scenes, "\t&XG_SCN_%s,\n", scene_names[i]);
+	}
+	fprintf(f_scenes, "};\n\n");
+}
+
+/*
+ * Writes down the animation which shares frames of the original one and draws
+ * them mirrored. It has its own state and work image, so both of them can be
+ * active at the same time.
+ */
+static void
+util_write_mirrored_anim(const anim_t *anim)
+{
+	const anim_t *orig = &animations[anim->mirror_idx];
+	uint32_t n = 0;
+
+	for (uint32_t j = 0; j < orig->paths_n; j++) {
+		n += paths[orig->paths_idx[j]].frames_n;
+	}
+
+	fprintf(f_anim, "const xg_anim_t PROGMEM XG_ANM_%s_%s = { "
+	    ".frames = XG_ANMF_%s_%s, "
+	    ".frames_n = %u, "
+	    ".state = &XG_ANMS_%s_%s, "
+	    ".active = %u, "
+	    ".mirror_x = %d, "
+	    ".flags = XG_DRAW_HFLIP, ",
+	    scene_name, anim->name,
+	    scene_name, orig->name, n,
+	    scene_name, anim->name, anim->active,
+	    anim->mirror_x
+	);
+	if (ANIM_HAS_DELTAS(anim)) {
+		fprintf(f_anim, ".work = &XG_ANMW_%s_%s, ",
+		    scene_name, anim->name);
+	}
+	fprintf(f_anim, "};\n");
+}
+
+/*
+ * Writes down the work image of the animation with deltas. Data and alpha of
+ * the work image are in RAM of the scene, every frame of the animation is
+ * drawn from it. Descriptor of the work image never changes, so it's in flash.
+ */
+static void
+util_write_work_image(const anim_t *anim)
+{
+	const block_info_t *info = &jobs[anim->delta_idx].info;
+
+	fprintf(f_anim, "const xg_work_t PROGMEM XG_ANMW_%s_%s = {\n",
+	    scene_name, anim->name);
+	fprintf(f_anim, "\t.data = XG_ANMW_DATA_%s_%s,\n", scene_name,
+	    anim->name);
+	fprintf(f_anim, "\t.alpha = XG_ANMW_ALPHA_%s_%s,\n", scene_name,
+	    anim->name);
+	fprintf(f_anim, "\t.width = %u,\n", info->width);
+	fprintf(f_anim, "\t.height = %u,\n", info->height);
+	fprintf(f_anim, "};\n");
+}
+
+/*
+ * Writes down the transition of a frame to the next one: indexes of the next
+ * and the alternative frames, an operation and its threshold (see
+ * xg_anim_frame_t). The chance in percent is scaled to 0..255, so the engine
+ * picks the next frame by a single compare with a random byte.
+ */
+static void
+util_write_frame_jump(const anim_t *anim, const anim_frame_t *frame)
+{
+	uint32_t total = 0, next, threshold;
+	const char *op;
+
+	for (uint32_t j = 0; j < anim->paths_n; j++) {
+		total += paths[anim->paths_idx[j]].frames_n;
+	}
+	next = frame->frame_idx + 1u;
+	next = next >= total ? 0 : next;
+
+	if (frame->alt_path_loops > 0u) {
+		op = "XG_AT_LOOP";
+		threshold = frame->alt_path_loops;
+	} else {
+		op = "XG_AT_CHANCE";
+		threshold = (frame->alt_path_chance * 255u + 50u) / 100u;
+		threshold = threshold > 255u ? 255u : threshold;
+	}
+
+	fprintf(f_anim,
+	    ".next = %u, "
+	    ".alt = %u, "
+	    ".threshold = %u, "
+	    ".op = %s, ",
+	    next, frames[paths[frame->alt_path_idx].frames_idx[0]].frame_idx,
+	    threshold, op);
+}
+
+/* Writes down a frame of the animation with deltas. */
+static void
+util_write_delta_frame(const anim_t *anim, const anim_frame_t *frame)
+{
+	char hasht[HASHT_SZ];
+
+	util_sha1_to_text(jobs[anim->delta_idx].hash, HASH_SZ, hasht,
+	    sizeof(hasht));
+
+	fprintf(f_anim, "\t{ "
+	    ".base_pt = { %d, %d }, ",
+	    anim->origin.x, anim->origin.y);
+	util_write_frame_jump(anim, frame);
+	fprintf(f_anim,
+	    ".delta = XG_DLT_%s_%u, "
+	    ".stay = %u, "
+	    "},\n",
+	    hasht, frame->frame_idx, frame->stay);
+}
+
+static void
+chk_write_scenes_header(layer_ctx_t *ctx)
+{
+	char kbd_cbk_name[256];
+	char script_name[SCENE_MAX_NAME + 16];
+	char vars_name[SCENE_MAX_NAME + 16];
+	scene_layer_t *scn_layer;
+	uint32_t i, cached_n = 0;
+
+	(void) ctx;
+
+	if (f_scenes != NULL) {
+		fprintf(f_scenes, SCENE_COMMENT, scene_name);
+
+		/*
+		 * Iterate over scene layers to write down header files for
+		 * static images and tile maps.
+		 */
+		for (i = 0; i < scene_layers_n; i++) {
+			scn_layer = &scene_layers[i];
+
+			if (scn_layer->obj_type != OT_ANIMATION) {
+				fprintf(f_scenes,
+				    "#include \"xling/scenes/%s.h\"\n",
+				    scn_layer->name);
+			}
+		}
+		fprintf(f_scenes, "\n");
+
+		/* The script runs instead of the keyboard callback. */
+		if (kbd && script_path[0] != '\0') {
+			fprintf(stderr, "xlingc: %s: !kbd() is ignored, the "
+			    "scene has a script\n", scene_name);
+			kbd = 0;
+		}
+
+		/* Declare a keyboard callback function (if needed). */
+		if (kbd) {
+			fprintf(f_scenes,
+			    "void XG_SCNKBD_%s(void *scene_ctx);\n\n",
+			    scene_name
+			);
+		}
+
+		/*
+		 * Write the draw list down: scene layers from the bottom one
+		 * to the top. Static layers at the bottom are cached.
+		 */
+		fprintf(f_scenes, "const xg_draw_op_t PROGMEM XG_SCND_%s[] = "
+		    "{\n", scene_name);
+		for (uint32_t k = 0; k < scene_layers_n; k++) {
+			i = scene_layers_n - 1 - k;
+			scn_layer = &scene_layers[i];
+
+			if (cached_n == k && cached_n < CACHED_MAX &&
+			    scn_layer->obj_type != OT_ANIMATION) {
+				cached_n++;
+			}
+
+			if (scn_layer->obj_type == OT_IMAGE) {
+				fprintf(f_scenes, "\t /* %u */ { "
+				    ".obj = &XG_IMG_%s, "
+				    ".obj_type = XG_OT_IMG, "
+				    ".base_pt = { %d, %d }, "
+				    ".group = %u },\n",
+				    i, scn_layer->name,
+				    scn_layer->base_pt.x,
+				    scn_layer->base_pt.y,
+				    scn_layer->group);
+			} else if (scn_layer->obj_type == OT_TILEMAP) {
+				fprintf(f_scenes, "\t /* %u */ { "
+				    ".obj = &XG_TLM_%s, "
+				    ".obj_type = XG_OT_TILEMAP, "
+				    ".base_pt = { %d, %d }, "
+				    ".group = %u },\n",
+				    i, scn_layer->name,
+				    scn_layer->base_pt.x,
+				    scn_layer->base_pt.y,
+				    scn_layer->group);
+			} else {
+				fprintf(f_scenes, "\t /* %u */ { "
+				    ".obj = &XG_ANM_%s_%s, "
+				    ".obj_type = XG_OT_ANIM, "
+				    ".group = %u },\n",
+				    i, scene_name, scn_layer->name,
+				    scn_layer->group);
+			}
+		}
+		fprintf(f_scenes, "};\n\n");
+
+		/* Write groups of the layers down. */
+		fprintf(f_scenes, "const xg_group_t PROGMEM XG_SCNG_%s[] = {\n",
+		    scene_name);
+		for (i = 0; i < groups_n; i++) {
+			fprintf(f_scenes, "\t /* %u */ { .parallax = %u },",
+			    i, groups[i].parallax);
+			if (groups[i].name[0] != '\0') {
+				fprintf(f_scenes, " /* %s */", groups[i].name);
+			}
+			fprintf(f_scenes, "\n");
+		}
+		fprintf(f_scenes, "};\n\n");
+
+		/* Prepare a name of the keyboard callback function. */
+		snprintf(kbd_cbk_name, sizeof(kbd_cbk_name),
+		    (kbd ? "XG_SCNKBD_%s" : "%s"),
+		    (kbd ? scene_name : "NULL"));
+
+		/* Write the bytecode of the scene down. */
+		snprintf(script_name, sizeof(script_name), "NULL");
+		snprintf(vars_name, sizeof(vars_name), "NULL");
+		if (script_path[0] != '\0') {
+			scr_write(f_scenes, scene_name, &script);
+			snprintf(script_name, sizeof(script_name),
+			    "XG_SCNS_%s", scene_name);
+			if (script.vars_n > 0) {
+				snprintf(vars_name, sizeof(vars_name),
+				    "XG_SCNV_%s", scene_name);
+			}
+		}
+
+		/*
+		 * Offsets of the groups and the pan are in RAM of the scene
+		 * (see util_write_scene_ram()).
+		 */
+		fprintf(f_scenes, "const xg_scene_t PROGMEM XG_SCN_%s = {\n"
+		    "\t.ops = XG_SCND_%s,\n"
+		    "\t.groups = XG_SCNG_%s,\n"
+		    "\t.offsets = XG_SCNO_%s,\n"
+		    "\t.pan = &XG_SCNP_%s,\n"
+		    "\t.ops_n = %u,\n"
+		    "\t.cached_n = %u,\n"
+		    "\t.groups_n = %u,\n"
+		    "\t.kbd_cbk = %s,\n"
+		    "\t.script = %s,\n"
+		    "\t.vars = %s,\n"
+		    "};\n\n",
+		    scene_name,
+		    scene_name,
+		    scene_name,
+		    scene_name,
+		    scene_name,
+		    scene_layers_n,
+		    cached_n,
+		    groups_n,
+		    kbd_cbk_name,
+		    script_name,
+		    vars_name
+		);
+
+		/* Remember the scene to put it into the registry. */
+		snprintf(scene_names[scenes_n++], sizeof(scene_names[0]),
+		    "%s", scene_name);
+	}
+}
+
+/*
+ * Derives a name of the scene from the manifest file name, i.e.
+ * "dir/peasant_house.xlm" is "peasant_house". Remembers directory of the
+ * manifest to look for the layer images there.
+ */
+static int
+util_scene_name(const char *manifest, char *name, size_t sz)
+{
+	const char *base = strrchr(manifest, '/');
+	size_t len;
+	char *pos;
+
+	base = (base == NULL) ? manifest : (base + 1);
+	len = (size_t)(base - manifest);
+	if (len >= sizeof(scene_dir)) {
+		return (1);
+	}
+	memcpy(scene_dir, manifest, len);
+	scene_dir[len] = '\0';
+
+	snprintf(name, sz, "%s", base);
+
+	/* Get rid of the manifest file extension. */
+	pos = strchr(name, '.');
+	if (pos != NULL) {
+		(*pos) = '\0';
+	}
+
+	/* Scene name is a part of the C identifiers. */
+	for (pos = name; (*pos) != '\0'; pos++) {
+		if (!isalnum((unsigned char)(*pos)) && (*pos) != '_') {
+			return (1);
+		}
+	}
+
+	return (name[0] == '\0');
+}
+
+/*
+ * Checks whether the other animation is a horizontal mirror of the given one:
+ * frames and their links are the same, positions and pixels of the frames are
+ * mirrored about the same vertical line.
+ */
+static int
+util_is_mirrored_anim(const anim_t *anim, const anim_t *other,
+    int32_t *mirror_x)
+{
+	const anim_path_t *path, *opath;
+	const anim_frame_t *frame, *oframe, *alt, *oalt;
+	const block_info_t *info, *oinfo;
+	image_t img, oimg;
+	int32_t m = 0;
+	int rc = (anim->paths_n == other->paths_n);
+
+	/* Compare the frames first, it's cheap. */
+	for (uint32_t j = 0; rc && j < anim->paths_n; j++) {
+		path = &paths[anim->paths_idx[j]];
+		opath = &paths[other->paths_idx[j]];
+		rc = (path->frames_n == opath->frames_n);
+
+		for (uint32_t k = 0; rc && k < path->frames_n; k++) {
+			frame = &frames[path->frames_idx[k]];
+			oframe = &frames[opath->frames_idx[k]];
+			info = &jobs[frame->job_idx].info;
+			oinfo = &jobs[oframe->job_idx].info;
+			alt = &frames[paths[frame->alt_path_idx].frames_idx[0]];
+			oalt = &frames[paths[oframe->alt_path_idx]
+			    .frames_idx[0]];
+
+			if (j == 0 && k == 0) {
+				m = frame->base_pt.x + oframe->base_pt.x +
+				    (int32_t) info->width;
+			}
+			rc = (info->width == oinfo->width &&
+			    info->height == oinfo->height &&
+			    frame->base_pt.y == oframe->base_pt.y &&
+			    (frame->base_pt.x + oframe->base_pt.x +
+			    (int32_t) info->width) == m &&
+			    frame->stay == oframe->stay &&
+			    frame->alt_path_chance == oframe->alt_path_chance &&
+			    frame->alt_path_loops == oframe->alt_path_loops &&
+			    alt->frame_idx == oalt->frame_idx);
+		}
+	}
+
+	/* Compare pixels of the frames. */
+	for (uint32_t j = 0; rc && j < anim->paths_n; j++) {
+		path = &paths[anim->paths_idx[j]];
+		opath = &paths[other->paths_idx[j]];
+
+		for (uint32_t k = 0; rc && k < path->frames_n; k++) {
+			frame = &frames[path->frames_idx[k]];
+			oframe = &frames[opath->frames_idx[k]];
+
+			memset(&img, 0, sizeof(img));
+			memset(&oimg, 0, sizeof(oimg));
+			rc = (util_pack_frame(frame, &img) == 0 &&
+			    util_pack_frame(oframe, &oimg) == 0 &&
+			    img_is_mirror(&img, &oimg));
+			img_free(&img);
+			img_free(&oimg);
+		}
+	}
+
+	if (rc) {
+		(*mirror_x) = m;
+	}
+
+	return (rc);
+}
+
+/* Decodes and packs the cropped image of the animation frame. */
+static int
+util_pack_frame(const anim_frame_t *frame, image_t *img)
+{
+	bitmap_t bmp;
+	block_info_t info;
+	int rc;
+
+	memset(&bmp, 0, sizeof(bmp));
+	rc = img_load_png(jobs[frame->job_idx].srcs[0].path, &bmp);
+	if (rc == 0) {
+		img_crop(&bmp, &info);
+		rc = img_pack(&bmp, img);
+	}
+	img_free_bitmap(&bmp);
+
+	return (rc);
+}
@@ -0,0 +1,538 @@
+/*-
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * This file is part of xlingc, a standalone asset compiler to generate header
+ * files with graphics for Xling, a tamagotchi-like toy.
+ *
+ * Copyright (c) 2020 Dmitry Salychev
+ *
+ * Xling firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Xling firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+/*
+ * Scene scripts and their compilation into the bytecode of the scene (see
+ * XG_SC_* in "xling/graphics.h").
+ *
+ * A script describes behaviour of the scene instead of the XG_SCNKBD_*
+ * callback. It's a text file given by the "script <file>" line of the scene
+ * manifest. Animations are referred by their names (see the !anim() tag), so
+ * the script doesn't depend on indexes of the scene layers. Each line is one
+ * of:
+ *
+ *	var <name> <value>		Variable of the scene (0..255) with an
+ *					initial value. Variables are declared
+ *					before the handlers.
+ *	on <event>			Handler of the keyboard event, e.g.
+ *	...				"on left_pressed" is run every frame
+ *	end				while XM_BTN_LEFT_PRESSED is the last
+ *					event received.
+ *
+ * and the statements of the handlers are:
+ *
+ *	show <anim> ...			Activate or deactivate animations.
+ *	hide <anim> ...
+ *	move <anim> <dx> <dy>		Move the group of the animation.
+ *	pan <dx> <dy>			Scroll the scene.
+ *	walk <anim> <dx> <left> <right>	Move the group of the animation by dx
+ *					while the first frame of the animation
+ *					is within (left, right) of the screen,
+ *					scroll the scene by -dx otherwise.
+ *	chance <anim> <mask>		Flip chances of the frames in the mask
+ *					(see alt_flip of xg_anim_state_t).
+ *	set <var> <value>		Set a variable.
+ *	mode scene|speech [<trans>]	Set mode of the scene. The speech
+ *					turns its page, it's left after the
+ *					last one by the transition: wipe,
+ *					slide, dissolve (by default) or fade.
+ *	say "<text>" ...		Say one of the phrases at random.
+ *	if <var> <value>		Run the statements if the variable or
+ *	if mode scene|speech		the mode of the scene has the value.
+ *	else
+ *	end
+ *
+ * Empty lines and lines starting with '#' are ignored. Events, modes and
+ * operations are written down by their names, so the bytecode stays valid if
+ * their values are changed in the firmware.
+ */
+
+#include "xlingc.h"
+
+#define MAX_TOKENS		(16u)
+#define MAX_LINE		(512u)
+#define LINE_WIDTH		(72u) /* Of the bytecode, without the tab. */
+
+/* Block of the script which is closed by "end". */
+typedef struct block_t {
+	uint32_t	 skip;		/* Offset of the skip operand. */
+	int		 is_handler;
+	int		 has_else;
+} block_t;
+
+typedef struct parser_t {
+	const char	*path;
+	const script_layer_t *layers;
+	uint32_t	 layers_n;
+	script_t	*scr;
+	char		 vars[SCRIPT_MAX_VARS][SCRIPT_MAX_NAME];
+	block_t		 blocks[SCRIPT_MAX_DEPTH];
+	uint32_t	 depth;
+	uint32_t	 line_n;
+} parser_t;
+
+static const char *events[] = {
+	"left_released",	"XM_BTN_LEFT_RELEASED",
+	"left_pressed",		"XM_BTN_LEFT_PRESSED",
+	"left_hold",		"XM_BTN_LEFT_HOLD",
+	"center_released",	"XM_BTN_CENTER_RELEASED",
+	"center_pressed",	"XM_BTN_CENTER_PRESSED",
+	"center_hold",		"XM_BTN_CENTER_HOLD",
+	"right_released",	"XM_BTN_RIGHT_RELEASED",
+	"right_pressed",	"XM_BTN_RIGHT_PRESSED",
+	"right_hold",		"XM_BTN_RIGHT_HOLD",
+	"left_dblpressed",	"XM_BTN_LEFT_DBLPRESSED",
+	"center_dblpressed",	"XM_BTN_CENTER_DBLPRESSED",
+	"right_dblpressed",	"XM_BTN_RIGHT_DBLPRESSED",
+	NULL,			NULL,
+};
+
+static const char *modes[] = {
+	"scene",		"XG_SM_SCENE",
+	"speech",		"XG_SM_SPEECH",
+	NULL,			NULL,
+};
+
+static const char *transitions[] = {
+	"wipe",			"XG_TR_WIPE",
+	"slide",		"XG_TR_SLIDE",
+	"dissolve",		"XG_TR_DISSOLVE",
+	"fade",			"XG_TR_FADE",
+	NULL,			NULL,
+};
+
+static int	parse_line(parser_t *p, char *line);
+static int	parse_stmt(parser_t *p, char **tok, uint32_t tok_n);
+static int	tokenize(char *line, char **tok, uint32_t *tok_n);
+static int	emit(parser_t *p, uint32_t byte, const char *sym);
+static int	emit_num(parser_t *p, const char *s, long min, long max);
+static int	emit_num16(parser_t *p, const char *s, long bias, long min,
+		    long max);
+static int	find_anim(parser_t *p, const char *name);
+static int	find_var(parser_t *p, const char *name);
+static const char *find_sym(const char **table, const char *name);
+static int	error(parser_t *p, const char *msg);
+
+int
+scr_compile(const char *path, const script_layer_t *layers, uint32_t layers_n,
+    script_t *scr)
+{
+	char line[MAX_LINE];
+	parser_t p;
+	FILE *f;
+	int rc = 0;
+
+	memset(&p, 0, sizeof(p));
+	memset(scr, 0, sizeof(*scr));
+	p.path = path;
+	p.layers = layers;
+	p.layers_n = layers_n;
+	p.scr = scr;
+
+	f = fopen(path, "r");
+	if (f == NULL) {
+		fprintf(stderr, "xlingc: can't open %s\n", path);
+		return (1);
+	}
+
+	/* Number of the variables, it's patched by every "var". */
+	rc = emit(&p, 0, NULL);
+
+	while (rc == 0 && fgets(line, sizeof(line), f) != NULL) {
+		p.line_n++;
+		line[strcspn(line, "\r\n")] = '\0';
+		rc = parse_line(&p, line);
+	}
+	if (rc == 0 && p.depth != 0) {
+		rc = error(&p, "missing \"end\"");
+	}
+
+	/* End of the handlers. */
+	if (rc == 0) {
+		rc = emit(&p, 0, NULL);
+	}
+	fclose(f);
+
+	return (rc);
+}
+
+/* Writes the bytecode down as XG_SCNS_<scene>, a line per handler. */
+void
+scr_write(FILE *f, const char *scene, const script_t *scr)
+{
+	char byte[SCRIPT_MAX_NAME];
+	uint32_t col = 0, len;
+
+	fprintf(f, "const uint8_t PROGMEM XG_SCNS_%s[] = {", scene);
+	for (uint32_t i = 0; i < scr->size; i++) {
+		if (scr->sym[i] != NULL) {
+			snprintf(byte, sizeof(byte), "%s,", scr->sym[i]);
+		} else {
+			snprintf(byte, sizeof(byte), "0x%02x,", scr->code[i]);
+		}
+		len = (uint32_t) strlen(byte);
+
+		if (i == 0 || col + len + 1u > LINE_WIDTH ||
+		    strncmp(byte, "XM_BTN_", 7) == 0) {
+			fprintf(f, "\n\t%s", byte);
+			col = len;
+		} else {
+			fprintf(f, " %s", byte);
+			col += len + 1u;
+		}
+	}
+	fprintf(f, "\n};\n\n");
+}
+
+static int
+parse_line(parser_t *p, char *line)
+{
+	char *tok[MAX_TOKENS];
+	uint32_t tok_n, idx;
+	block_t *blk;
+	const char *sym;
+	int rc;
+
+	rc = tokenize(line, tok, &tok_n);
+	if (rc != 0) {
+		return (error(p, "bad line"));
+	}
+	if (tok_n == 0 || tok[0][0] == '#') {
+		return (0);
+	}
+
+	if (IS_SAME_NAME(tok[0], "var")) {
+		if (tok_n != 3 || p->depth != 0 || p->scr->size != 1u +
+		    p->scr->vars_n) {
+			return (error(p, "bad \"var\""));
+		}
+		if (p->scr->vars_n == SCRIPT_MAX_VARS ||
+		    find_var(p, tok[1]) >= 0) {
+			return (error(p, "too many or duplicate variables"));
+		}
+		snprintf(p->vars[p->scr->vars_n], SCRIPT_MAX_NAME, "%s",
+		    tok[1]);
+		p->scr->vars_n++;
+		p->scr->code[0] = (uint8_t) p->scr->vars_n;
+		return (emit_num(p, tok[2], 0, 255));
+	}
+
+	if (IS_SAME_NAME(tok[0], "on")) {
+		sym = (tok_n == 2) ? find_sym(events, tok[1]) : NULL;
+		if (sym == NULL || p->depth != 0) {
+			return (error(p, "bad \"on\""));
+		}
+		blk = &p->blocks[p->depth++];
+		blk->is_handler = 1;
+		blk->has_else = 0;
+		blk->skip = p->scr->size + 1u;
+		rc = emit(p, 0, sym);
+		rc |= emit(p, 0, NULL);
+		return (rc);
+	}
+
+	if (IS_SAME_NAME(tok[0], "end")) {
+		if (tok_n != 1 || p->depth == 0) {
+			return (error(p, "unexpected \"end\""));
+		}
+		blk = &p->blocks[--p->depth];
+		idx = blk->skip;
+		if (p->scr->size - idx - 1u > 255u) {
+			return (error(p, blk->is_handler ? "handler is too long"
+			    : "block is too long"));
+		}
+		p->scr->code[idx] = (uint8_t)(p->scr->size - idx - 1u);
+		return (0);
+	}
+
+	if (p->depth == 0) {
+		return (error(p, "statement outside of a handler"));
+	}
+
+	return (parse_stmt(p, tok, tok_n));
+}
+
+static int
+parse_stmt(parser_t *p, char **tok, uint32_t tok_n)
+{
+	const char *sym;
+	block_t *blk;
+	uint32_t idx;
+	int anim, var, rc = 0;
+
+	if (IS_SAME_NAME(tok[0], "show") || IS_SAME_NAME(tok[0], "hide")) {
+		if (tok_n < 2) {
+			return (error(p, "no animations"));
+		}
+		for (uint32_t i = 1; rc == 0 && i < tok_n; i++) {
+			anim = find_anim(p, tok[i]);
+			if (anim < 0) {
+				return (1);
+			}
+			rc = emit(p, 0, "XG_SC_ACTIVE");
+			rc |= emit(p, p->layers[anim].idx, NULL);
+			rc |= emit(p, IS_SAME_NAME(tok[0], "show"), NULL);
+		}
+	} else if (IS_SAME_NAME(tok[0], "move") && tok_n == 4) {
+		if ((anim = find_anim(p, tok[1])) < 0) {
+			return (1);
+		}
+		rc = emit(p, 0, "XG_SC_MOVE");
+		rc |= emit(p, p->layers[anim].group, NULL);
+		rc |= emit_num(p, tok[2], -128, 127);
+		rc |= emit_num(p, tok[3], -128, 127);
+	} else if (IS_SAME_NAME(tok[0], "pan") && tok_n == 3) {
+		rc = emit(p, 0, "XG_SC_PAN");
+		rc |= emit_num(p, tok[1], -128, 127);
+		rc |= emit_num(p, tok[2], -128, 127);
+	} else if (IS_SAME_NAME(tok[0], "walk") && tok_n == 5) {
+		/* Borders of the screen are turned into the group offsets. */
+		if ((anim = find_anim(p, tok[1])) < 0) {
+			return (1);
+		}
+		rc = emit(p, 0, "XG_SC_WALK");
+		rc |= emit(p, p->layers[anim].group, NULL);
+		rc |= emit_num(p, tok[2], -128, 127);
+		for (uint32_t i = 3; rc == 0 && i < 5; i++) {
+			rc |= emit_num16(p, tok[i], (long) p->layers[anim].x,
+			    INT16_MIN, INT16_MAX);
+		}
+	} else if (IS_SAME_NAME(tok[0], "chance") && tok_n == 3) {
+		if ((anim = find_anim(p, tok[1])) < 0) {
+			return (1);
+		}
+		rc = emit(p, 0, "XG_SC_CHANCE");
+		rc |= emit(p, p->layers[anim].idx, NULL);
+		rc |= emit_num16(p, tok[2], 0, 0, UINT16_MAX);
+	} else if (IS_SAME_NAME(tok[0], "set") && tok_n == 3) {
+		if ((var = find_var(p, tok[1])) < 0) {
+			return (error(p, "unknown variable"));
+		}
+		rc = emit(p, 0, "XG_SC_SET");
+		rc |= emit(p, (uint32_t) var, NULL);
+		rc |= emit_num(p, tok[2], 0, 255);
+	} else if (IS_SAME_NAME(tok[0], "mode") &&
+	    (tok_n == 2 || tok_n == 3)) {
+		if ((sym = find_sym(modes, tok[1])) == NULL) {
+			return (error(p, "unknown mode"));
+		}
+		rc = emit(p, 0, "XG_SC_MODE");
+		rc |= emit(p, 0, sym);
+		sym = find_sym(transitions, (tok_n == 3) ? tok[2] : "dissolve");
+		if (sym == NULL) {
+			return (error(p, "unknown transition"));
+		}
+		rc |= emit(p, 0, sym);
+	} else if (IS_SAME_NAME(tok[0], "say") && tok_n >= 2) {
+		rc = emit(p, 0, "XG_SC_SAY");
+		rc |= emit(p, tok_n - 1u, NULL);
+		for (uint32_t i = 1; rc == 0 && i < tok_n; i++) {
+			if (tok[i][0] != '"') {
+				return (error(p, "phrase isn't quoted"));
+			}
+			for (const char *c = &tok[i][1]; rc == 0 && *c != '\0';
+			    c++) {
+				rc = emit(p, (uint8_t)(*c), NULL);
+			}
+			rc |= emit(p, 0, NULL);
+		}
+	} else if (IS_SAME_NAME(tok[0], "if") && tok_n == 3) {
+		if (p->depth == SCRIPT_MAX_DEPTH) {
+			return (error(p, "too deep"));
+		}
+		if (IS_SAME_NAME(tok[1], "mode")) {
+			if ((sym = find_sym(modes, tok[2])) == NULL) {
+				return (error(p, "unknown mode"));
+			}
+			rc = emit(p, 0, "XG_SC_IFMODE");
+			rc |= emit(p, 0, sym);
+		} else {
+			if ((var = find_var(p, tok[1])) < 0) {
+				return (error(p, "unknown variable"));
+			}
+			rc = emit(p, 0, "XG_SC_IFVAR");
+			rc |= emit(p, (uint32_t) var, NULL);
+			rc |= emit_num(p, tok[2], 0, 255);
+		}
+		blk = &p->blocks[p->depth++];
+		blk->is_handler = 0;
+		blk->has_else = 0;
+		blk->skip = p->scr->size;
+		rc |= emit(p, 0, NULL);
+	} else if (IS_SAME_NAME(tok[0], "else") && tok_n == 1) {
+		blk = &p->blocks[p->depth - 1u];
+		if (blk->is_handler || blk->has_else) {
+			return (error(p, "unexpected \"else\""));
+		}
+		blk->has_else = 1;
+		/* Jump over the "else" part, the "if" part skips to it. */
+		rc = emit(p, 0, "XG_SC_JUMP");
+		rc |= emit(p, 0, NULL);
+		idx = blk->skip;
+		if (p->scr->size - idx - 1u > 255u) {
+			return (error(p, "block is too long"));
+		}
+		p->scr->code[idx] = (uint8_t)(p->scr->size - idx - 1u);
+		blk->skip = p->scr->size - 1u;
+	} else {
+		rc = error(p, "bad statement");
+	}
+
+	return (rc);
+}
+
+/*
+ * Splits the line into tokens by spaces. Quoted phrase is a single token
+ * which starts with the quote, the closing quote is dropped.
+ */
+static int
+tokenize(char *line, char **tok, uint32_t *tok_n)
+{
+	char *c = line;
+
+	*tok_n = 0;
+	while (*c != '\0') {
+		while (isspace((unsigned char)(*c))) {
+			*(c++) = '\0';
+		}
+		if (*c == '\0') {
+			break;
+		}
+		if (*tok_n == MAX_TOKENS) {
+			return (1);
+		}
+		tok[(*tok_n)++] = c;
+
+		if (*c == '"') {
+			c = strchr(c + 1, '"');
+			if (c == NULL) {
+				return (1);
+			}
+			*(c++) = '\0';
+		} else {
+			while (*c != '\0' && !isspace((unsigned char)(*c))) {
+				c++;
+			}
+		}
+	}
+
+	return (0);
+}
+
+static int
+emit(parser_t *p, uint32_t byte, const char *sym)
+{
+	if (p->scr->size == SCRIPT_MAX_SIZE) {
+		return (error(p, "script is too large"));
+	}
+	p->scr->code[p->scr->size] = (uint8_t) byte;
+	p->scr->sym[p->scr->size] = sym;
+	p->scr->size++;
+
+	return (0);
+}
+
+static int
+emit_num(parser_t *p, const char *s, long min, long max)
+{
+	char *end;
+	long val = strtol(s, &end, 0);
+
+	if (end == s || *end != '\0' || val < min || val > max) {
+		return (error(p, "bad number"));
+	}
+
+	return (emit(p, (uint32_t) val & 0xFFu, NULL));
+}
+
+/*
+ * Emits a 16-bit operand (little-endian), the bias is subtracted from the
+ * number before its range is checked.
+ */
+static int
+emit_num16(parser_t *p, const char *s, long bias, long min, long max)
+{
+	char *end;
+	long val = strtol(s, &end, 0);
+
+	if (*end == '\0') {
+		val -= bias;
+	}
+	if (end == s || *end != '\0' || val < min || val > max) {
+		return (error(p, "bad number"));
+	}
+
+	return (emit(p, (uint32_t) val & 0xFFu, NULL) |
+	    emit(p, ((uint32_t) val >> 8) & 0xFFu, NULL));
+}
+
+static int
+find_anim(parser_t *p, const char *name)
+{
+	for (uint32_t i = 0; i < p->layers_n; i++) {
+		if (IS_SAME_NAME(p->layers[i].name, name) &&
+		    p->layers[i].idx <= 255u) {
+			return ((int) i);
+		}
+	}
+	fprintf(stderr, "xlingc: %s:%u: unknown animation \"%s\" (or its "
+	    "layer is above 255)\n", p->path, p->line_n, name);
+
+	return (-1);
+}
+
+static int
+find_var(parser_t *p, const char *name)
+{
+	for (uint32_t i = 0; i < p->scr->vars_n; i++) {
+		if (IS_SAME_NAME(p->vars[i], name)) {
+			return ((int) i);
+		}
+	}
+
+	return (-1);
+}
+
+static const char *
+find_sym(const char **table, const char *name)
+{
+	for (uint32_t i = 0; table[i] != NULL; i += 2) {
+		if (IS_SAME_NAME(table[i], name)) {
+			return (table[i + 1]);
+		}
+	}
+
+	return (NULL);
+}
+
+static int
+error(parser_t *p, const char *msg)
+{
+	fprintf(stderr, "xlingc: %s:%u: %s\n", p->path, p->line_n, msg);
+
+	return (1);
+}
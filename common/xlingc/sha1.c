@@ -0,0 +1,150 @@
+/*-
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * This file is part of xlingc, a standalone asset compiler to generate header
+ * files with graphics for Xling, a tamagotchi-like toy.
+ *
+ * Copyright (c) 2020 Dmitry Salychev
+ *
+ * Xling firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Xling firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * SHA-1 hash (FIPS 180-1) to name the generated images after their pixels.
+ *
+ * NOTE: It's implemented here to keep xlingc dependent on libpng only. The
+ *       hash isn't used for any security-related purposes.
+ */
+
+#include "xlingc.h"
+
+#define ROL(v, n)	((uint32_t)(((v) << (n)) | ((v) >> (32 - (n)))))
+
+static void	sha1_block(sha1_ctx_t *ctx, const uint8_t *blk);
+
+void
+sha1_init(sha1_ctx_t *ctx)
+{
+	ctx->state[0] = 0x67452301u;
+	ctx->state[1] = 0xEFCDAB89u;
+	ctx->state[2] = 0x98BADCFEu;
+	ctx->state[3] = 0x10325476u;
+	ctx->state[4] = 0xC3D2E1F0u;
+	ctx->length = 0;
+	ctx->block_len = 0;
+}
+
+void
+sha1_update(sha1_ctx_t *ctx, const void *data, size_t len)
+{
+	const uint8_t *p = (const uint8_t *) data;
+	size_t n;
+
+	ctx->length += (uint64_t) len;
+
+	while (len > 0) {
+		n = sizeof(ctx->block) - ctx->block_len;
+		n = (n > len) ? len : n;
+
+		memcpy(&ctx->block[ctx->block_len], p, n);
+		ctx->block_len += (uint32_t) n;
+		p += n;
+		len -= n;
+
+		if (ctx->block_len == sizeof(ctx->block)) {
+			sha1_block(ctx, ctx->block);
+			ctx->block_len = 0;
+		}
+	}
+}
+
+void
+sha1_final(sha1_ctx_t *ctx, uint8_t *hash)
+{
+	const uint64_t bits = ctx->length * 8u;
+	const uint8_t pad = 0x80;
+	const uint8_t zero = 0x00;
+	uint8_t len_be[8];
+
+	for (uint32_t i = 0; i < 8; i++) {
+		len_be[i] = (uint8_t)(bits >> (56 - (i * 8)));
+	}
+
+	sha1_update(ctx, &pad, 1);
+	while (ctx->block_len != 56) {
+		sha1_update(ctx, &zero, 1);
+	}
+	sha1_update(ctx, len_be, sizeof(len_be));
+
+	for (uint32_t i = 0; i < 5; i++) {
+		hash[(i * 4) + 0] = (uint8_t)(ctx->state[i] >> 24);
+		hash[(i * 4) + 1] = (uint8_t)(ctx->state[i] >> 16);
+		hash[(i * 4) + 2] = (uint8_t)(ctx->state[i] >> 8);
+		hash[(i * 4) + 3] = (uint8_t)(ctx->state[i]);
+	}
+}
+
+static void
+sha1_block(sha1_ctx_t *ctx, const uint8_t *blk)
+{
+	uint32_t w[80];
+	uint32_t a, b, c, d, e, f, k, t;
+
+	for (uint32_t i = 0; i < 16; i++) {
+		w[i] = ((uint32_t) blk[(i * 4) + 0] << 24) |
+		    ((uint32_t) blk[(i * 4) + 1] << 16) |
+		    ((uint32_t) blk[(i * 4) + 2] << 8) |
+		    ((uint32_t) blk[(i * 4) + 3]);
+	}
+	for (uint32_t i = 16; i < 80; i++) {
+		w[i] = ROL(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+	}
+
+	a = ctx->state[0];
+	b = ctx->state[1];
+	c = ctx->state[2];
+	d = ctx->state[3];
+	e = ctx->state[4];
+
+	for (uint32_t i = 0; i < 80; i++) {
+		if (i < 20) {
+			f = (b & c) | ((~b) & d);
+			k = 0x5A827999u;
+		} else if (i < 40) {
+			f = b ^ c ^ d;
+			k = 0x6ED9EBA1u;
+		} else if (i < 60) {
+			f = (b & c) | (b & d) | (c & d);
+			k = 0x8F1BBCDCu;
+		} else {
+			f = b ^ c ^ d;
+			k = 0xCA62C1D6u;
+		}
+
+		t = ROL(a, 5) + f + e + k + w[i];
+		e = d;
+		d = c;
+		c = ROL(b, 30);
+		b = a;
+		a = t;
+	}
+
+	ctx->state[0] += a;
+	ctx->state[1] += b;
+	ctx->state[2] += c;
+	ctx->state[3] += d;
+	ctx->state[4] += e;
+}
@@ -0,0 +1,142 @@
+/*-
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * This file is part of xlingc, a standalone asset compiler to generate header
+ * files with graphics for Xling, a tamagotchi-like toy.
+ *
+ * Copyright (c) 2020 Dmitry Salychev
+ *
+ * Xling firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Xling firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * Entry point of xlingc.
+ *
+ * Usage:
+ *
+ *	xlingc [-Bv] [-j jobs] [-o output_dir] scene.xlm ...
+ *	xlingc [-v] [-c chars] [-o output_dir] -f font.xml [source.c ...]
+ *
+ * Every scene manifest given on the command line is compiled into the
+ * "scenes.h" and "anim.h" headers in the output directory (the current one
+ * by default), images of the layers are written next to them as <SHA-1>.h
+ * and <SHA-1>_a.h. It's the same set of files the xlingtool plug-in exports
+ * for all of the images open in GIMP.
+ *
+ * Images converted by the previous runs are cached in the output directory
+ * (see cache.c) and converted again only if their pixels have been changed.
+ * Headers are rewritten only if their content differs. Use -B to ignore the
+ * cache and convert everything from scratch.
+ *
+ * Images of a scene are converted by a pool of workers, one per CPU unless
+ * limited by -j. Generated headers don't depend on the number of workers.
+ *
+ * A font is compiled instead of the scenes if -f is given (see font.c): only
+ * glyphs of the characters used by the string literals of the C sources and
+ * the ones given by -c are written into <font name>.h.
+ */
+
+#include "xlingc.h"
+
+static void	usage(void) __attribute__((noreturn));
+
+int
+main(int argc, char *argv[])
+{
+	const char *font = NULL, *chars = "";
+	xc_config_t cfg = {
+		.out_dir = ".",
+		.verbose = 0,
+		.rebuild = 0,
+		.jobs = 1,
+	};
+	long ncpu;
+	int ch, rc = 0;
+
+	/* Convert images by as many workers as there are CPUs by default. */
+	ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	if (ncpu > 0) {
+		cfg.jobs = (ncpu < XC_MAX_JOBS) ? (uint32_t) ncpu : XC_MAX_JOBS;
+	}
+
+	while ((ch = getopt(argc, argv, "Bc:f:j:o:v")) != -1) {
+		switch (ch) {
+		case 'B':
+			cfg.rebuild = 1;
+			break;
+		case 'c':
+			chars = optarg;
+			break;
+		case 'f':
+			font = optarg;
+			break;
+		case 'j':
+			ch = atoi(optarg);
+			if (ch < 1 || ch > (int) XC_MAX_JOBS) {
+				usage();
+			}
+			cfg.jobs = (uint32_t) ch;
+			break;
+		case 'o':
+			cfg.out_dir = optarg;
+			break;
+		case 'v':
+			cfg.verbose = 1;
+			break;
+		default:
+			usage();
+		}
+	}
+	argc -= optind;
+	argv += optind;
+
+	if (font != NULL) {
+		rc = fnt_compile(&cfg, font, chars, argv, argc);
+		return (rc == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+	if (argc < 1) {
+		usage();
+	}
+
+	rc = cache_load(&cfg);
+	rc |= scn_open_headers(&cfg);
+
+	/* Compile all of the scenes given on the command line. */
+	for (int i = 0; rc == 0 && i < argc; i++) {
+		if (cfg.verbose) {
+			printf("Exporting: %s\n", argv[i]);
+		}
+		rc = scn_compile(&cfg, argv[i]);
+	}
+
+	rc |= scn_close_headers();
+	rc |= cache_save(&cfg);
+
+	return (rc == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: xlingc [-Bv] [-j jobs] [-o output_dir] "
+	    "scene.xlm ...\n"
+	    "       xlingc [-v] [-c chars] [-o output_dir] -f font.xml "
+	    "[source.c ...]\n");
+	exit(EXIT_FAILURE);
+}
@@ -0,0 +1,326 @@
+/*-
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * This file is part of xlingc, a standalone asset compiler to generate header
+ * files with graphics for Xling, a tamagotchi-like toy.
+ *
+ * Copyright (c) 2020 Dmitry Salychev
+ *
+ * Xling firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Xling firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef XLINGC_H_
+#define XLINGC_H_ 1
+
+/*
+ * Types, limits and functions shared between the modules of xlingc.
+ *
+ * xlingc does the same job as the xlingtool plug-in for GIMP, but without
+ * GIMP and LCD Image Converter: layers are read from PNG files listed in a
+ * scene manifest, converted into the page-major monochrome format of the
+ * SH1106 display in-process and written down as header files together with
+ * the scene and animation headers.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+/******************************************************************************
+ * Configuration of the animations.
+ ******************************************************************************/
+#define ANIM_MAX_NAME		(64u)  /* Max. length of the animation name */
+#define ANIM_MAX		(128u) /* Max. # of animations per scene. */
+#define ANIM_MAX_PATHS		(16u)  /* Max. # of paths per animation. */
+#define ANIM_MAX_FRAMES		(64u)  /* Max. # of frames per path */
+#define ANIM_TAG_FORMAT		"!anim(%63[a-zA-Z0-9]%63[#,]%63[a-zA-Z0-9])"
+#define ANIM_TAG_PARTS		(3)    /* # of the animation tag parts */
+#define ANIM_GO_TAG_FORMAT	"!go(%63[a-zA-Z0-9]%63[#,]%d%1[%])"
+#define ANIM_GO_TAG_PARTS	(4)
+#define ANIM_STAY_TAG_FORMAT	"!stay(%d)"
+#define ANIM_STAY_TAG_PARTS	(1)
+#define ANIM_LOOP_TAG_FORMAT	"!loop(%63[a-zA-Z0-9]%63[#,]%d)"
+#define ANIM_LOOP_TAG_PARTS	(3)
+#define ANIM_MAX_LOOPS		(255u) /* Max. count of the !loop tag. */
+#define FLAT_TAG_FORMAT		"!flat(%63[a-zA-Z0-9])"
+#define FLAT_TAG_PARTS		(1)
+#define TILES_TAG		"!tiles()"
+#define PARALLAX_TAG_FORMAT	"!parallax(%d%1[%])"
+#define PARALLAX_TAG_PARTS	(2)
+
+/******************************************************************************
+ * Basic configuration.
+ ******************************************************************************/
+#define HASH_SZ			(20u)
+#define HASHT_SZ		((2 * HASH_SZ) + 1) /* 2 chars/byte + '\0' */
+#define LAYER_MAX_NAME		(128u)
+#define LAYERS_MAX		(2 * ANIM_MAX * ANIM_MAX_PATHS * ANIM_MAX_FRAMES)
+#define SCENE_MAX_NAME		(64u)
+#define SCENES_MAX		(64u) /* Max. # of scenes in the registry. */
+#define PATH_MAX_LEN		(1024u)
+#define PHEIGHT			(8u) /* Height of the display page, in pixels. */
+#define XC_MAX_JOBS		(64u) /* Max. # of the conversion workers. */
+#define DELTA_MAX_RAM		(256u) /* Max. RAM for the delta frames. */
+#define DELTA_MAX_SPAN		(255u) /* Max. length of the delta span. */
+#define TILE_WIDTH		(8u) /* Width of the tile, in pixels. */
+#define TILES_MAX		(256u) /* Max. # of tiles per tile map. */
+#define GROUPS_MAX		(255u) /* Max. # of layer groups per scene. */
+#define PARALLAX_ONE		(64u) /* Parallax of 100%, see XG_PX_ONE. */
+#define PARALLAX_MAX		(398) /* Max. parallax, in percent. */
+#define CACHED_MAX		(64u) /* Max. # of cached layers per scene. */
+#define FONT_MAX_NAME		(64u)
+#define FONT_MAX_WIDTH		(255u) /* Max. width of the glyph, in pixels. */
+#define FONT_MAX_HEIGHT		(24u) /* Max. height of the glyph, in pixels. */
+#define FONT_MAX_SIZE		(65535u) /* Max. size of the glyph bitmaps. */
+#define SCRIPT_MAX_SIZE		(2048u) /* Max. size of the bytecode. */
+#define SCRIPT_MAX_VARS		(16u) /* Max. # of the variables. */
+#define SCRIPT_MAX_NAME		(32u)
+#define SCRIPT_MAX_DEPTH	(8u) /* Max. depth of the nested blocks. */
+
+/* Threshold to convert luminance and alpha into a single bit. */
+#define MONO_EDGE		(128u)
+
+/*
+ * Version of the converter. Bump it every time the generated headers are
+ * changed to invalidate the images cached by the previous versions.
+ */
+#define CONVERTER_VERSION	"xlingc-7"
+
+/*
+ * Runs of the alpha channel, the same as XG_AR_* of "xling/graphics.h": kind
+ * of the run in two most significant bits and length minus one in the rest.
+ */
+#define ALPHA_RUN_TRANSPARENT	(0x00u)
+#define ALPHA_RUN_OPAQUE	(0x40u)
+#define ALPHA_RUN_MASK		(0x80u)
+#define ALPHA_RUN_MAX_LEN	(64u)
+
+/* Flag of the key frame delta, the same as XG_DF_KEY of "xling/graphics.h". */
+#define DELTA_KEY		(0x01u)
+
+#define IS_SAME_NAME(name1, name2)	(strcmp((name1), (name2)) == 0)
+#define IS_NOT_SAME_NAME(name1, name2)	(strcmp((name1), (name2)) != 0)
+
+/******************************************************************************
+ * Types.
+ ******************************************************************************/
+typedef struct point_t {
+	int32_t		 x;
+	int32_t		 y;
+} point_t;
+
+/* Layer pixels as 8-bit RGBA quadruples, row by row. */
+typedef struct bitmap_t {
+	uint8_t		*px;
+	uint32_t	 width;
+	uint32_t	 height;
+	int		 has_alpha;
+} bitmap_t;
+
+/*
+ * Monochrome image in the page-major format of the SH1106 display.
+ *
+ * Every byte describes a column of 8 pixels of a page (the least significant
+ * bit is the top pixel), pages follow one after another from the top to the
+ * bottom of the image. Alpha channel (if any) has exactly the same layout
+ * until it's encoded into runs by img_encode_alpha().
+ */
+typedef struct image_t {
+	uint8_t		*data;
+	uint8_t		*alpha;
+	uint32_t	 width;
+	uint32_t	 height;
+	uint32_t	 size;		/* Size of the data array, in bytes. */
+	uint32_t	 alpha_size;	/* Size of the alpha array, in bytes. */
+	int		 alpha_runs;	/* Alpha is encoded into runs. */
+} image_t;
+
+/* Delta of an animation frame, see XG_DF_KEY in "xling/graphics.h". */
+typedef struct delta_t {
+	uint8_t		*data;
+	uint32_t	 size;
+} delta_t;
+
+/*
+ * Tile map, see xg_tilemap_t in "xling/graphics.h". Every tile is TILE_WIDTH
+ * bytes of a single page, the map is a tile index for every tile of the image
+ * row by row.
+ */
+typedef struct tilemap_t {
+	uint8_t		*tiles;
+	uint32_t	 tiles_n;
+	uint8_t		*map;
+	uint32_t	 width;		/* In tiles. */
+	uint32_t	 height;	/* In tiles. */
+} tilemap_t;
+
+/* Properties of the converted image which matter for the scene headers. */
+typedef struct block_info_t {
+	point_t		 offset;	/* Top-left corner left by auto-crop. */
+	uint32_t	 width;
+	uint32_t	 height;
+	uint32_t	 saved;		/* Bytes of flash saved. */
+} block_info_t;
+
+/* Glyph of the font packed at its real height (see font.c). */
+typedef struct glyph_t {
+	uint32_t	 code;
+	uint32_t	 width;
+	uint32_t	 height;
+	uint32_t	 offset;	/* Offset of the bitmap, in bytes. */
+} glyph_t;
+
+typedef struct font_t {
+	char		 name[FONT_MAX_NAME];
+	glyph_t		*glyphs;	/* Sorted by their codes. */
+	uint32_t	 glyphs_n;
+	uint32_t	 total_n;	/* # of glyphs in the original font. */
+	uint8_t		*bitmaps;
+	uint32_t	 size;		/* Size of the bitmaps, in bytes. */
+} font_t;
+
+/* Animation of the scene a script refers to (see script.c). */
+typedef struct script_layer_t {
+	const char	*name;		/* Name of the animation. */
+	uint32_t	 idx;		/* Index of the scene layer. */
+	uint8_t		 group;
+	int32_t		 x;		/* Left side of the first frame. */
+} script_layer_t;
+
+/* Bytecode of the scene, see XG_SC_* in "xling/graphics.h". */
+typedef struct script_t {
+	uint8_t		 code[SCRIPT_MAX_SIZE];
+	const char	*sym[SCRIPT_MAX_SIZE]; /* Names of the bytes or NULL. */
+	uint32_t	 size;
+	uint32_t	 vars_n;
+} script_t;
+
+/* Options of the compiler. */
+typedef struct xc_config_t {
+	const char	*out_dir;	/* Directory for the generated headers. */
+	int		 verbose;	/* Print scene layers and animations. */
+	int		 rebuild;	/* Ignore the cache of the previous runs. */
+	uint32_t	 jobs;		/* # of the conversion workers. */
+} xc_config_t;
+
+/* PNG file with pixels of a layer (see convert.c). */
+typedef struct conv_src_t {
+	char		 path[PATH_MAX_LEN];
+	point_t		 pt;		/* Position within the image. */
+	uint8_t		 hash[HASH_SZ];	/* SHA-1 of the pixels. */
+	bitmap_t	 bmp;
+	int		 hashed;	/* Hash is known, e.g. from the cache. */
+	int		 decoded;	/* PNG file has been decoded. */
+	int		 key;		/* Key frame of the delta job. */
+} conv_src_t;
+
+/*
+ * Conversion of a single image (see convert.c). Image is composed of one or
+ * more PNG files, the first one is on top of the others.
+ *
+ * Delta job converts frames of an animation instead, one PNG file per frame
+ * in the order of the frames. See conv_do_delta() for details.
+ */
+typedef struct conv_job_t {
+	conv_src_t	*srcs;
+	uint32_t	 srcs_n;
+	uint8_t		 hash[HASH_SZ]; /* SHA-1 of the image. */
+	uint8_t		 shift;		/* Rows to shift the image down by. */
+	int		 delta;		/* Delta job. */
+	int		 tiles;		/* Slice the image into a tile map. */
+	block_info_t	 info;
+	int		 converted;	/* Headers have been written. */
+	int		 error;
+} conv_job_t;
+
+/* File in the output directory which is written only if it's changed. */
+typedef struct out_file_t {
+	FILE		*f;
+	char		*buf;
+	size_t		 len;
+	int		 verbose;
+	char		 path[PATH_MAX_LEN];
+} out_file_t;
+
+typedef struct sha1_ctx_t {
+	uint32_t	 state[5];
+	uint64_t	 length;
+	uint8_t		 block[64];
+	uint32_t	 block_len;
+} sha1_ctx_t;
+
+/******************************************************************************
+ * Interface of the modules.
+ ******************************************************************************/
+/* sha1.c */
+void	 sha1_init(sha1_ctx_t *ctx);
+void	 sha1_update(sha1_ctx_t *ctx, const void *data, size_t len);
+void	 sha1_final(sha1_ctx_t *ctx, uint8_t *hash);
+
+/* image.c */
+int	 img_load_png(const char *path, bitmap_t *bmp);
+int	 img_load_png_mem(const char *name, const uint8_t *buf, size_t len,
+	     bitmap_t *bmp);
+void	 img_free_bitmap(bitmap_t *bmp);
+void	 img_calc_sha1(const bitmap_t *bmp, uint8_t *hash);
+void	 img_crop(bitmap_t *bmp, block_info_t *info);
+int	 img_compose(const conv_src_t *srcs, uint32_t srcs_n, bitmap_t *bmp);
+int	 img_shift(bitmap_t *bmp, uint32_t shift, block_info_t *info);
+int	 img_pack(const bitmap_t *bmp, image_t *img);
+int	 img_encode_alpha(image_t *img);
+int	 img_slice_tiles(const image_t *img, tilemap_t *tm);
+void	 img_free_tiles(tilemap_t *tm);
+int	 img_is_mirror(const image_t *img, const image_t *other);
+void	 img_free(image_t *img);
+
+/* output.c */
+char	*util_sha1_to_text(const uint8_t *hash, uint32_t hash_sz, char *hasht,
+	     uint32_t hasht_sz);
+int	 out_open(const xc_config_t *cfg, const char *name, out_file_t *of);
+int	 out_close(out_file_t *of);
+int	 out_write_image(const xc_config_t *cfg, const char *name,
+	     const image_t *img);
+int	 out_write_deltas(const xc_config_t *cfg, const char *name,
+	     const delta_t *deltas, uint32_t deltas_n);
+int	 out_write_tilemap(const xc_config_t *cfg, const char *name,
+	     const tilemap_t *tm);
+int	 out_write_font(const xc_config_t *cfg, const font_t *font);
+
+/* cache.c */
+int	 cache_load(const xc_config_t *cfg);
+int	 cache_save(const xc_config_t *cfg);
+int	 cache_lookup_file(const char *path, uint8_t *hash);
+void	 cache_store_file(const char *path, const uint8_t *hash);
+int	 cache_is_block_fresh(const xc_config_t *cfg, const uint8_t *hash,
+	     block_info_t *info);
+void	 cache_store_block(const xc_config_t *cfg, const uint8_t *hash,
+	     const block_info_t *info);
+
+/* convert.c */
+int	 conv_run(const xc_config_t *cfg, conv_job_t *jobs, uint32_t jobs_n);
+void	 conv_reset(void);
+
+/* font.c */
+int	 fnt_compile(const xc_config_t *cfg, const char *path,
+	     const char *chars, char *const *srcs, int srcs_n);
+
+/* script.c */
+int	 scr_compile(const char *path, const script_layer_t *layers,
+	     uint32_t layers_n, script_t *scr);
+void	 scr_write(FILE *f, const char *scene, const script_t *scr);
+
+/* scene.c */
+int	 scn_open_headers(const xc_config_t *cfg);
+int	 scn_compile(const xc_config_t *cfg, const char *manifest);
+int	 scn_close_headers(void);
+
+#endif /* XLINGC_H_ */
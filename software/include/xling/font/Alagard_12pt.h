@@ -1,261 +1,199 @@
-/*-
- * SPDX-License-Identifier: GPL-3.0-or-later
- *
- * This file is part of a firmware for Xling, a tamagotchi-like toy.
- *
- * Copyright (c) 2020 Dmitry Salychev
- *
- * Xling firmware is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License as published by
- * the Free Software Foundation, either version 3 of the License, or
- * (at your option) any later version.
- *
- * Xling firmware is distributed in the hope that it will be useful,
- * but WITHOUT ANY WARRANTY; without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- * GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License
- * along with this program.  If not, see <https://www.gnu.org/licenses/>.
- */
-#ifndef XG_FONT_Alagard_12pt_H_
-#define XG_FONT_Alagard_12pt_H_ 1
-
-#include <stdint.h>
-#include <avr/pgmspace.h>
-
-/*
- * This file with bitmap font has been generated for Xling,
- * a tamagotchi-like toy, by LCD Image Converter.
- *
- * Data type: font
- * Filename: Alagard_12pt
- *
- * Family: Alagard
- * Size: 12
- * Style: Medium
- * Antialiasing: no
- * Type: proportional
- * Encoding: ASMO-708
- * Unicode BOM: no
- *
- * Preset name: Xling_SH1106_display_preset
- * Data block size: 8 bit(s), uint8_t
- * RLE compression: no
- * Conversion type: Monochrome, Diffuse Dither 128
- * Bits per pixel: 1
- * Bands used: yes
- * Band width: 8
- * Main scan direction: left_to_right
- * Line scan direction: forward
- * Inverse colors: no
- */
-
-/* Xling graphics headers. */
-#include "xling/graphics.h"
-
-/* Glyphs bitmap */
-static const uint8_t PROGMEM XG_FONT_Alagard_12pt_bitmaps[] = {
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x04, 0xde, 0xdf, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x02, 0x0f, 0x07, 0x00, 0x0f, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x24, 0xfe, 0x7f, 0x24, 0xfe, 0x7f, 0x24, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x48, 0x9c, 0xf2, 0xbf, 0xe6, 0x4c, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
-	0x86, 0x4f, 0x29, 0x73, 0xce, 0x94, 0xf2, 0x61, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x66, 0xff, 0x99, 0xb3, 0x7e, 0xe0, 0x98, 0x48, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x02, 0x0f, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x7c, 0xfe, 0x81, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x02, 0x81, 0x7e, 0x3c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x14, 0x0f, 0x0e, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x10, 0x10, 0x7c, 0x7e, 0x10, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x00, 0x80, 0x00, 0x05, 0x07, 0x00,
-	0x10, 0x10, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x00, 0x80, 0x00, 0x00, 0x01, 0x00,
-	0x00, 0x80, 0x80, 0x40, 0x30, 0x10, 0x08, 0x06, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x3c, 0x7e, 0xd1, 0x8b, 0xfe, 0x7c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x84, 0xfe, 0xff, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0xc6, 0xe3, 0xd1, 0xcf, 0x46, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x44, 0xc2, 0x83, 0x93, 0xfe, 0x6c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x38, 0x34, 0x32, 0xff, 0xff, 0x30, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0xdf, 0xcf, 0x85, 0x8d, 0x79, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x7c, 0xfe, 0xd1, 0x89, 0x9b, 0x73, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x06, 0x03, 0xf3, 0xfb, 0x47, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x66, 0xf7, 0xc9, 0x91, 0xff, 0x66, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0xcc, 0xde, 0x99, 0x91, 0x73, 0x3e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x00, 0x48, 0x00, 0x00, 0x00, 0x00,
-	0x00, 0xc8, 0x00, 0x01, 0x00, 0x00,
-	0x60, 0xd0, 0x88, 0x04, 0x00, 0x00, 0x00, 0x01, 0x01, 0x00,
-	0x00, 0x90, 0x90, 0x90, 0x90, 0x90, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x00, 0x8c, 0x98, 0x50, 0x30, 0x00, 0x01, 0x00, 0x00, 0x00,
-	0x08, 0x86, 0xc6, 0x2e, 0x1c, 0x00, 0x00, 0x01, 0x01, 0x00, 0x00, 0x00,
-	0xf0, 0xfc, 0x92, 0xd2, 0x3a, 0xf2, 0xf6, 0xfe, 0x78, 0x00, 0x03, 0x07, 0x04, 0x05, 0x05, 0x05, 0x05, 0x04, 0x02, 0x00,
-	0xfc, 0xfe, 0x21, 0x13, 0xfe, 0xfc, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x44, 0xfe, 0x81, 0x99, 0xbf, 0xf6, 0x64, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x7c, 0xfe, 0xc1, 0x81, 0x82, 0x43, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x02, 0xff, 0xff, 0x81, 0x43, 0x3e, 0x1c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x02, 0x7f, 0xff, 0xc9, 0x8b, 0x82, 0x41, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x02, 0xff, 0xff, 0x49, 0x0b, 0x02, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x7c, 0xfe, 0xc3, 0x81, 0x93, 0x72, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x04, 0xfe, 0xff, 0x10, 0x10, 0xfe, 0xff, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x04, 0xfe, 0xff, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x04, 0xfe, 0xff, 0x00, 0x02, 0x01, 0x00, 0x00,
-	0x04, 0xfe, 0xff, 0x48, 0x1c, 0xf7, 0xe3, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x04, 0xfe, 0xff, 0x80, 0x80, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x04, 0xfe, 0xff, 0x44, 0x02, 0xff, 0xff, 0x44, 0x02, 0xff, 0xff, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x04, 0xfe, 0xff, 0x4c, 0x18, 0xfe, 0xff, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x3c, 0x7e, 0xc1, 0x83, 0xfe, 0x7c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x04, 0xfe, 0xff, 0x52, 0x11, 0x0f, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x3c, 0x7e, 0xc1, 0x83, 0xfe, 0x7c, 0x80, 0x00, 0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x00, 0x00,
-	0x04, 0xfe, 0xff, 0x52, 0x11, 0xfb, 0xe6, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x64, 0xce, 0x99, 0x9b, 0xf2, 0x63, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x02, 0x01, 0x7d, 0xff, 0xc1, 0x82, 0x43, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x04, 0x7e, 0xff, 0xc0, 0x84, 0xfe, 0xff, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x04, 0x3e, 0x7f, 0xe0, 0xc0, 0x7e, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x04, 0x7e, 0xff, 0x40, 0xf8, 0xfc, 0x80, 0x7e, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x44, 0xc6, 0xef, 0x1c, 0x38, 0xf6, 0xe7, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x04, 0x0e, 0x1f, 0xf8, 0xf0, 0x4e, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x46, 0xe3, 0xdb, 0xdb, 0xc7, 0x62, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0xff, 0xff, 0x01, 0x00, 0x03, 0x03, 0x02, 0x00,
-	0x03, 0x06, 0x0c, 0x18, 0x30, 0x60, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x01, 0xff, 0xff, 0x00, 0x02, 0x03, 0x03, 0x00,
-	0x10, 0x0c, 0x00, 0x06, 0x1e, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00,
-	0x00, 0x02, 0x06, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x48, 0xe4, 0x94, 0xfc, 0xf8, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x04, 0xfe, 0xff, 0x90, 0x88, 0x78, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x30, 0x78, 0xc4, 0x88, 0x4c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x78, 0x88, 0x92, 0xff, 0xff, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x70, 0xf8, 0xa4, 0x9c, 0x48, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x10, 0xfe, 0xff, 0x51, 0x12, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x38, 0x44, 0x48, 0xfc, 0xfc, 0x08, 0x00, 0x03, 0x03, 0x02, 0x01, 0x00, 0x00, 0x00,
-	0x04, 0xfe, 0xff, 0x10, 0xf8, 0xf0, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x00, 0xf4, 0xfa, 0x40, 0x00, 0x00, 0x00, 0x00,
-	0x20, 0xf4, 0xfa, 0x00, 0x04, 0x03, 0x01, 0x00,
-	0x04, 0xfe, 0xff, 0x10, 0xfc, 0xec, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x04, 0xfe, 0xff, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x10, 0xf8, 0xfc, 0x10, 0xf8, 0xfc, 0x10, 0xf8, 0xfc, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x10, 0xf8, 0xfc, 0x08, 0xfc, 0xfc, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x30, 0x78, 0xc4, 0x8c, 0x78, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x20, 0xf0, 0xf8, 0xc4, 0x8c, 0x78, 0x30, 0x00, 0x00, 0x07, 0x07, 0x02, 0x00, 0x00, 0x00, 0x00,
-	0x30, 0x78, 0xc4, 0x8c, 0xf8, 0xfc, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0x07, 0x02, 0x00,
-	0x10, 0xf8, 0xfc, 0x90, 0x08, 0x18, 0x00, 0x00, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00,
-	0x48, 0xdc, 0xb4, 0xec, 0x48, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x14, 0xfe, 0xff, 0x90, 0x50, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x10, 0x78, 0xfc, 0x80, 0x40, 0xf8, 0xfc, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x10, 0x78, 0xfc, 0xc0, 0x80, 0x78, 0x3c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x10, 0x78, 0xfc, 0x80, 0x70, 0x78, 0x80, 0x78, 0x3c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x68, 0xcc, 0x5c, 0x30, 0x68, 0xc4, 0x4c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x10, 0x78, 0xfc, 0x80, 0xf8, 0xfc, 0x00, 0x03, 0x06, 0x04, 0x04, 0x03, 0x01, 0x00,
-	0x90, 0xc8, 0xac, 0x9c, 0x48, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-	0x40, 0xfc, 0x02, 0x00, 0x00, 0x07, 0x04, 0x00,
-	0x00, 0xfc, 0xfe, 0x00, 0x00, 0x07, 0x03, 0x00,
-	0x06, 0xfe, 0x40, 0x00, 0x04, 0x07, 0x00, 0x00,
-	0x40, 0x30, 0x70, 0xe0, 0xc0, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-};
-
-/* Glyphs */
-static const xg_glyph_t XG_FONT_Alagard_12pt_glyphs[] = {
-	{ .code=0x20, .data=&XG_FONT_Alagard_12pt_bitmaps[0], .width=4, .height=9, .data_size=8, },	/* ' ' */
-	{ .code=0x21, .data=&XG_FONT_Alagard_12pt_bitmaps[8], .width=5, .height=9, .data_size=8, },	/* '!' */
-	{ .code=0x22, .data=&XG_FONT_Alagard_12pt_bitmaps[18], .width=7, .height=9, .data_size=8, },	/* '\"' */
-	{ .code=0x23, .data=&XG_FONT_Alagard_12pt_bitmaps[32], .width=8, .height=9, .data_size=8, },	/* '#' */
-	{ .code=0x24, .data=&XG_FONT_Alagard_12pt_bitmaps[48], .width=7, .height=9, .data_size=8, },	/* '$' */
-	{ .code=0x25, .data=&XG_FONT_Alagard_12pt_bitmaps[62], .width=9, .height=9, .data_size=8, },	/* '%' */
-	{ .code=0x26, .data=&XG_FONT_Alagard_12pt_bitmaps[80], .width=9, .height=9, .data_size=8, },	/* '&' */
-	{ .code=0x27, .data=&XG_FONT_Alagard_12pt_bitmaps[98], .width=4, .height=9, .data_size=8, },	/* '\'' */
-	{ .code=0x28, .data=&XG_FONT_Alagard_12pt_bitmaps[106], .width=5, .height=9, .data_size=8, },	/* '(' */
-	{ .code=0x29, .data=&XG_FONT_Alagard_12pt_bitmaps[116], .width=5, .height=9, .data_size=8, },	/* ')' */
-	{ .code=0x2a, .data=&XG_FONT_Alagard_12pt_bitmaps[126], .width=5, .height=9, .data_size=8, },	/* '*' */
-	{ .code=0x2b, .data=&XG_FONT_Alagard_12pt_bitmaps[136], .width=7, .height=9, .data_size=8, },	/* '+' */
-	{ .code=0x2c, .data=&XG_FONT_Alagard_12pt_bitmaps[150], .width=3, .height=12, .data_size=8, },	/* ',' */
-	{ .code=0x2d, .data=&XG_FONT_Alagard_12pt_bitmaps[156], .width=4, .height=9, .data_size=8, },	/* '-' */
-	{ .code=0x2e, .data=&XG_FONT_Alagard_12pt_bitmaps[164], .width=3, .height=12, .data_size=8, },	/* '.' */
-	{ .code=0x2f, .data=&XG_FONT_Alagard_12pt_bitmaps[170], .width=9, .height=12, .data_size=8, },	/* '/' */
-	{ .code=0x30, .data=&XG_FONT_Alagard_12pt_bitmaps[188], .width=7, .height=9, .data_size=8, },	/* '0' */
-	{ .code=0x31, .data=&XG_FONT_Alagard_12pt_bitmaps[202], .width=5, .height=9, .data_size=8, },	/* '1' */
-	{ .code=0x32, .data=&XG_FONT_Alagard_12pt_bitmaps[212], .width=6, .height=9, .data_size=8, },	/* '2' */
-	{ .code=0x33, .data=&XG_FONT_Alagard_12pt_bitmaps[224], .width=7, .height=9, .data_size=8, },	/* '3' */
-	{ .code=0x34, .data=&XG_FONT_Alagard_12pt_bitmaps[238], .width=8, .height=9, .data_size=8, },	/* '4' */
-	{ .code=0x35, .data=&XG_FONT_Alagard_12pt_bitmaps[254], .width=6, .height=9, .data_size=8, },	/* '5' */
-	{ .code=0x36, .data=&XG_FONT_Alagard_12pt_bitmaps[266], .width=7, .height=9, .data_size=8, },	/* '6' */
-	{ .code=0x37, .data=&XG_FONT_Alagard_12pt_bitmaps[280], .width=7, .height=9, .data_size=8, },	/* '7' */
-	{ .code=0x38, .data=&XG_FONT_Alagard_12pt_bitmaps[294], .width=7, .height=9, .data_size=8, },	/* '8' */
-	{ .code=0x39, .data=&XG_FONT_Alagard_12pt_bitmaps[308], .width=7, .height=9, .data_size=8, },	/* '9' */
-	{ .code=0x3a, .data=&XG_FONT_Alagard_12pt_bitmaps[322], .width=3, .height=9, .data_size=8, },	/* ':' */
-	{ .code=0x3b, .data=&XG_FONT_Alagard_12pt_bitmaps[328], .width=3, .height=9, .data_size=8, },	/* ';' */
-	{ .code=0x3c, .data=&XG_FONT_Alagard_12pt_bitmaps[334], .width=5, .height=12, .data_size=8, },	/* '<' */
-	{ .code=0x3d, .data=&XG_FONT_Alagard_12pt_bitmaps[344], .width=7, .height=12, .data_size=8, },	/* '=' */
-	{ .code=0x3e, .data=&XG_FONT_Alagard_12pt_bitmaps[358], .width=5, .height=12, .data_size=8, },	/* '>' */
-	{ .code=0x3f, .data=&XG_FONT_Alagard_12pt_bitmaps[368], .width=6, .height=12, .data_size=8, },	/* '?' */
-	{ .code=0x40, .data=&XG_FONT_Alagard_12pt_bitmaps[380], .width=10, .height=12, .data_size=8, },	/* '\@' */
-	{ .code=0x41, .data=&XG_FONT_Alagard_12pt_bitmaps[400], .width=8, .height=9, .data_size=8, },	/* 'A' */
-	{ .code=0x42, .data=&XG_FONT_Alagard_12pt_bitmaps[416], .width=8, .height=9, .data_size=8, },	/* 'B' */
-	{ .code=0x43, .data=&XG_FONT_Alagard_12pt_bitmaps[432], .width=7, .height=9, .data_size=8, },	/* 'C' */
-	{ .code=0x44, .data=&XG_FONT_Alagard_12pt_bitmaps[446], .width=8, .height=9, .data_size=8, },	/* 'D' */
-	{ .code=0x45, .data=&XG_FONT_Alagard_12pt_bitmaps[462], .width=8, .height=9, .data_size=8, },	/* 'E' */
-	{ .code=0x46, .data=&XG_FONT_Alagard_12pt_bitmaps[478], .width=8, .height=9, .data_size=8, },	/* 'F' */
-	{ .code=0x47, .data=&XG_FONT_Alagard_12pt_bitmaps[494], .width=8, .height=9, .data_size=8, },	/* 'G' */
-	{ .code=0x48, .data=&XG_FONT_Alagard_12pt_bitmaps[510], .width=9, .height=9, .data_size=8, },	/* 'H' */
-	{ .code=0x49, .data=&XG_FONT_Alagard_12pt_bitmaps[528], .width=5, .height=9, .data_size=8, },	/* 'I' */
-	{ .code=0x4a, .data=&XG_FONT_Alagard_12pt_bitmaps[538], .width=4, .height=11, .data_size=8, },	/* 'J' */
-	{ .code=0x4b, .data=&XG_FONT_Alagard_12pt_bitmaps[546], .width=9, .height=9, .data_size=8, },	/* 'K' */
-	{ .code=0x4c, .data=&XG_FONT_Alagard_12pt_bitmaps[564], .width=7, .height=9, .data_size=8, },	/* 'L' */
-	{ .code=0x4d, .data=&XG_FONT_Alagard_12pt_bitmaps[578], .width=13, .height=9, .data_size=8, },	/* 'M' */
-	{ .code=0x4e, .data=&XG_FONT_Alagard_12pt_bitmaps[604], .width=9, .height=9, .data_size=8, },	/* 'N' */
-	{ .code=0x4f, .data=&XG_FONT_Alagard_12pt_bitmaps[622], .width=7, .height=9, .data_size=8, },	/* 'O' */
-	{ .code=0x50, .data=&XG_FONT_Alagard_12pt_bitmaps[636], .width=8, .height=9, .data_size=8, },	/* 'P' */
-	{ .code=0x51, .data=&XG_FONT_Alagard_12pt_bitmaps[652], .width=8, .height=10, .data_size=8, },	/* 'Q' */
-	{ .code=0x52, .data=&XG_FONT_Alagard_12pt_bitmaps[668], .width=9, .height=9, .data_size=8, },	/* 'R' */
-	{ .code=0x53, .data=&XG_FONT_Alagard_12pt_bitmaps[686], .width=7, .height=9, .data_size=8, },	/* 'S' */
-	{ .code=0x54, .data=&XG_FONT_Alagard_12pt_bitmaps[700], .width=8, .height=9, .data_size=8, },	/* 'T' */
-	{ .code=0x55, .data=&XG_FONT_Alagard_12pt_bitmaps[716], .width=9, .height=9, .data_size=8, },	/* 'U' */
-	{ .code=0x56, .data=&XG_FONT_Alagard_12pt_bitmaps[734], .width=8, .height=9, .data_size=8, },	/* 'V' */
-	{ .code=0x57, .data=&XG_FONT_Alagard_12pt_bitmaps[750], .width=10, .height=9, .data_size=8, },	/* 'W' */
-	{ .code=0x58, .data=&XG_FONT_Alagard_12pt_bitmaps[770], .width=9, .height=9, .data_size=8, },	/* 'X' */
-	{ .code=0x59, .data=&XG_FONT_Alagard_12pt_bitmaps[788], .width=8, .height=9, .data_size=8, },	/* 'Y' */
-	{ .code=0x5a, .data=&XG_FONT_Alagard_12pt_bitmaps[804], .width=7, .height=9, .data_size=8, },	/* 'Z' */
-	{ .code=0x5b, .data=&XG_FONT_Alagard_12pt_bitmaps[818], .width=4, .height=11, .data_size=8, },	/* '[' */
-	{ .code=0x5c, .data=&XG_FONT_Alagard_12pt_bitmaps[826], .width=8, .height=9, .data_size=8, },	/* '\' */
-	{ .code=0x5d, .data=&XG_FONT_Alagard_12pt_bitmaps[842], .width=4, .height=11, .data_size=8, },	/* ']' */
-	{ .code=0x5e, .data=&XG_FONT_Alagard_12pt_bitmaps[850], .width=7, .height=12, .data_size=8, },	/* '^' */
-	{ .code=0x5f, .data=&XG_FONT_Alagard_12pt_bitmaps[864], .width=8, .height=12, .data_size=8, },	/* '_' */
-	{ .code=0x60, .data=&XG_FONT_Alagard_12pt_bitmaps[880], .width=5, .height=12, .data_size=8, },	/* '`' */
-	{ .code=0x61, .data=&XG_FONT_Alagard_12pt_bitmaps[890], .width=7, .height=9, .data_size=8, },	/* 'a' */
-	{ .code=0x62, .data=&XG_FONT_Alagard_12pt_bitmaps[904], .width=7, .height=9, .data_size=8, },	/* 'b' */
-	{ .code=0x63, .data=&XG_FONT_Alagard_12pt_bitmaps[918], .width=6, .height=9, .data_size=8, },	/* 'c' */
-	{ .code=0x64, .data=&XG_FONT_Alagard_12pt_bitmaps[930], .width=7, .height=9, .data_size=8, },	/* 'd' */
-	{ .code=0x65, .data=&XG_FONT_Alagard_12pt_bitmaps[944], .width=6, .height=9, .data_size=8, },	/* 'e' */
-	{ .code=0x66, .data=&XG_FONT_Alagard_12pt_bitmaps[956], .width=7, .height=9, .data_size=8, },	/* 'f' */
-	{ .code=0x67, .data=&XG_FONT_Alagard_12pt_bitmaps[970], .width=7, .height=11, .data_size=8, },	/* 'g' */
-	{ .code=0x68, .data=&XG_FONT_Alagard_12pt_bitmaps[984], .width=8, .height=9, .data_size=8, },	/* 'h' */
-	{ .code=0x69, .data=&XG_FONT_Alagard_12pt_bitmaps[1000], .width=4, .height=9, .data_size=8, },	/* 'i' */
-	{ .code=0x6a, .data=&XG_FONT_Alagard_12pt_bitmaps[1008], .width=4, .height=11, .data_size=8, },	/* 'j' */
-	{ .code=0x6b, .data=&XG_FONT_Alagard_12pt_bitmaps[1016], .width=8, .height=9, .data_size=8, },	/* 'k' */
-	{ .code=0x6c, .data=&XG_FONT_Alagard_12pt_bitmaps[1032], .width=5, .height=9, .data_size=8, },	/* 'l' */
-	{ .code=0x6d, .data=&XG_FONT_Alagard_12pt_bitmaps[1042], .width=11, .height=9, .data_size=8, },	/* 'm' */
-	{ .code=0x6e, .data=&XG_FONT_Alagard_12pt_bitmaps[1064], .width=8, .height=9, .data_size=8, },	/* 'n' */
-	{ .code=0x6f, .data=&XG_FONT_Alagard_12pt_bitmaps[1080], .width=7, .height=9, .data_size=8, },	/* 'o' */
-	{ .code=0x70, .data=&XG_FONT_Alagard_12pt_bitmaps[1094], .width=8, .height=11, .data_size=8, },	/* 'p' */
-	{ .code=0x71, .data=&XG_FONT_Alagard_12pt_bitmaps[1110], .width=8, .height=11, .data_size=8, },	/* 'q' */
-	{ .code=0x72, .data=&XG_FONT_Alagard_12pt_bitmaps[1126], .width=7, .height=9, .data_size=8, },	/* 'r' */
-	{ .code=0x73, .data=&XG_FONT_Alagard_12pt_bitmaps[1140], .width=6, .height=9, .data_size=8, },	/* 's' */
-	{ .code=0x74, .data=&XG_FONT_Alagard_12pt_bitmaps[1152], .width=6, .height=9, .data_size=8, },	/* 't' */
-	{ .code=0x75, .data=&XG_FONT_Alagard_12pt_bitmaps[1164], .width=9, .height=9, .data_size=8, },	/* 'u' */
-	{ .code=0x76, .data=&XG_FONT_Alagard_12pt_bitmaps[1182], .width=8, .height=9, .data_size=8, },	/* 'v' */
-	{ .code=0x77, .data=&XG_FONT_Alagard_12pt_bitmaps[1198], .width=10, .height=9, .data_size=8, },	/* 'w' */
-	{ .code=0x78, .data=&XG_FONT_Alagard_12pt_bitmaps[1218], .width=8, .height=9, .data_size=8, },	/* 'x' */
-	{ .code=0x79, .data=&XG_FONT_Alagard_12pt_bitmaps[1234], .width=7, .height=11, .data_size=8, },	/* 'y' */
-	{ .code=0x7a, .data=&XG_FONT_Alagard_12pt_bitmaps[1248], .width=6, .height=9, .data_size=8, },	/* 'z' */
-	{ .code=0x7b, .data=&XG_FONT_Alagard_12pt_bitmaps[1260], .width=4, .height=12, .data_size=8, },	/* '{' */
-	{ .code=0x7c, .data=&XG_FONT_Alagard_12pt_bitmaps[1268], .width=4, .height=12, .data_size=8, },	/* '|' */
-	{ .code=0x7d, .data=&XG_FONT_Alagard_12pt_bitmaps[1276], .width=4, .height=12, .data_size=8, },	/* '}' */
-	{ .code=0x7e, .data=&XG_FONT_Alagard_12pt_bitmaps[1284], .width=7, .height=12, .data_size=8, },	/* '~' */
-};
-
-/* Font */
-const xg_font_t XG_FONT_Alagard_12pt = {
-	.length = 95,
-	.glyphs = XG_FONT_Alagard_12pt_glyphs,
-};
-
-#endif /* XG_FONT_Alagard_12pt_H_ */
+/*-
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * This file is part of a firmware for Xling, a tamagotchi-like toy.
+ *
+ * Copyright (c) 2020 Dmitry Salychev
+ *
+ * Xling firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Xling firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef XG_FONT_Alagard_12pt_H_
+#define XG_FONT_Alagard_12pt_H_ 1
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+/*
+ * This file with bitmap font has been generated for Xling,
+ * a tamagotchi-like toy, by xlingc.
+ *
+ * Filename: Alagard_12pt
+ * Glyphs: 95 of 95
+ */
+
+/* Xling graphics header */
+#include "xling/graphics.h"
+
+/* Glyphs bitmap */
+static const __memx uint8_t XG_FONT_Alagard_12pt_bitmaps[803] = {
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0xbc, 0x7d, 0x03, 0x02, 0x00, 0x02, 0x1e, 0x1c, 0x00, 0xf0,
+	0xe0, 0x00, 0x00, 0x24, 0xfc, 0xfd, 0x21, 0xe1, 0xef, 0x0f, 0x09, 0x00, 0x48, 0x38, 0xc9, 0xff,
+	0x65, 0x8e, 0x09, 0x00, 0x86, 0x9e, 0xa4, 0x98, 0xe3, 0x8c, 0x92, 0xbc, 0x30, 0x00, 0x00, 0x66,
+	0xfe, 0x65, 0x9a, 0xe5, 0x07, 0x1c, 0x26, 0x24, 0x00, 0x00, 0x02, 0x1e, 0x1c, 0x00, 0x00, 0x7c,
+	0xfc, 0x05, 0x1a, 0x00, 0x00, 0x02, 0x02, 0xf9, 0xe1, 0x01, 0x00, 0x14, 0x1e, 0x38, 0xa0, 0x00,
+	0x00, 0x10, 0x20, 0xf0, 0xf1, 0x03, 0x01, 0x02, 0x00, 0x00, 0x05, 0x78, 0x00, 0x00, 0x10, 0x20,
+	0x40, 0x00, 0x00, 0x00, 0x00, 0x18, 0x00, 0x00, 0x00, 0x00, 0x18, 0x80, 0x00, 0x04, 0x30, 0x00,
+	0x01, 0x08, 0x60, 0x00, 0x00, 0x00, 0x3c, 0xfc, 0x44, 0x5b, 0xe4, 0x8f, 0x0f, 0x00, 0x84, 0xfc,
+	0xfd, 0x03, 0x04, 0x00, 0xc6, 0xc6, 0x45, 0x7b, 0x66, 0x04, 0x00, 0x44, 0x84, 0x0d, 0x9a, 0xe4,
+	0x8f, 0x0d, 0x00, 0x38, 0x68, 0xc8, 0xf8, 0xf7, 0x0f, 0x06, 0x04, 0x00, 0xdf, 0x9e, 0x15, 0x6a,
+	0x94, 0x07, 0x00, 0x7c, 0xfc, 0x45, 0x4b, 0xb4, 0x69, 0x0e, 0x00, 0x06, 0x06, 0xcc, 0xdb, 0x77,
+	0x64, 0x00, 0x00, 0x66, 0xee, 0x25, 0x8b, 0xf4, 0xcf, 0x0c, 0x00, 0xcc, 0xbc, 0x65, 0x8a, 0x34,
+	0xc7, 0x07, 0x00, 0x00, 0x90, 0x00, 0x00, 0x00, 0x91, 0x01, 0x00, 0x60, 0x00, 0x0d, 0x88, 0x41,
+	0x10, 0x00, 0x00, 0x00, 0x00, 0x09, 0x90, 0x00, 0x09, 0x90, 0x00, 0x09, 0x00, 0x00, 0x00, 0xc0,
+	0x18, 0x98, 0x00, 0x05, 0x30, 0x00, 0x08, 0x60, 0x18, 0xc6, 0xe1, 0x02, 0x1c, 0x00, 0x00, 0xf0,
+	0xc3, 0x7f, 0x92, 0x24, 0x5d, 0x3a, 0x25, 0x5f, 0xf6, 0xe5, 0x4f, 0x78, 0x02, 0x00, 0xfc, 0xfc,
+	0x85, 0x98, 0xe0, 0x8f, 0x1f, 0x10, 0x00, 0x44, 0xfc, 0x05, 0xca, 0xf4, 0xcb, 0x1e, 0x19, 0x00,
+	0x7c, 0xfc, 0x05, 0x0b, 0x24, 0x68, 0x08, 0x00, 0x02, 0xfe, 0xfd, 0x0b, 0x34, 0xc4, 0x07, 0x07,
+	0x00, 0x02, 0xfe, 0xfc, 0x4b, 0xb6, 0x48, 0x50, 0x10, 0x00, 0x02, 0xfe, 0xfd, 0x4b, 0xb2, 0x40,
+	0x40, 0x00, 0x00, 0x7c, 0xfc, 0x0d, 0x0b, 0x34, 0x49, 0x0e, 0x0c, 0x00, 0x04, 0xfc, 0xfd, 0x83,
+	0x00, 0xc1, 0xdf, 0x3f, 0x20, 0x00, 0x00, 0x04, 0xfc, 0xfd, 0x03, 0x02, 0x00, 0x04, 0xf2, 0xcf,
+	0x3f, 0x00, 0x00, 0x04, 0xfc, 0xfd, 0x43, 0xc2, 0xe1, 0xde, 0x38, 0x20, 0x00, 0x00, 0x04, 0xfc,
+	0xfd, 0x03, 0x04, 0x08, 0x08, 0x00, 0x04, 0xfc, 0xfd, 0x23, 0x22, 0xe0, 0xdf, 0x3f, 0x22, 0x02,
+	0xfe, 0xfd, 0x03, 0x02, 0x00, 0x04, 0xfc, 0xfd, 0x63, 0x82, 0xc1, 0xdf, 0x3f, 0x20, 0x00, 0x00,
+	0x3c, 0xfc, 0x04, 0x1b, 0xe4, 0x8f, 0x0f, 0x00, 0x04, 0xfc, 0xfd, 0x93, 0x12, 0xe1, 0x81, 0x01,
+	0x00, 0x3c, 0xf8, 0x11, 0xcc, 0x60, 0xfe, 0xf1, 0x05, 0x08, 0x00, 0x04, 0xfc, 0xfd, 0x93, 0x12,
+	0x61, 0x9f, 0x39, 0x20, 0x00, 0x00, 0x64, 0x9c, 0x65, 0xda, 0x24, 0x6f, 0x0c, 0x00, 0x02, 0x02,
+	0xf4, 0xf9, 0x17, 0x4c, 0xd0, 0x10, 0x00, 0x04, 0xfc, 0xfc, 0x03, 0x46, 0xc8, 0xdf, 0x3f, 0x20,
+	0x00, 0x00, 0x04, 0x7c, 0xfc, 0x01, 0x07, 0xcc, 0xcf, 0x0f, 0x00, 0x04, 0xfc, 0xfc, 0x03, 0x82,
+	0x8f, 0x1f, 0x20, 0x3f, 0x3f, 0x00, 0x00, 0x44, 0x8c, 0xbd, 0xe3, 0x80, 0xc3, 0xde, 0x39, 0x20,
+	0x00, 0x00, 0x04, 0x1c, 0x7c, 0xc0, 0x07, 0xcf, 0xc9, 0x01, 0x00, 0x46, 0xc6, 0x6d, 0xdb, 0x76,
+	0x4c, 0x0c, 0x00, 0xff, 0xfb, 0x5f, 0x80, 0x00, 0x00, 0x03, 0x0c, 0x30, 0xc0, 0x00, 0x03, 0x0c,
+	0x30, 0x00, 0x01, 0xfa, 0xdf, 0xff, 0x00, 0x00, 0x10, 0xc0, 0x00, 0x00, 0x60, 0x00, 0x1e, 0x80,
+	0x01, 0x00, 0x00, 0x00, 0x01, 0x10, 0x00, 0x01, 0x10, 0x00, 0x01, 0x10, 0x00, 0x01, 0x00, 0x00,
+	0x20, 0x00, 0x06, 0x60, 0x00, 0x00, 0x00, 0x48, 0xc8, 0x51, 0xe2, 0x87, 0x0f, 0x08, 0x00, 0x04,
+	0xfc, 0xfd, 0x83, 0x84, 0x08, 0x0f, 0x00, 0x30, 0xf0, 0x10, 0x43, 0xc4, 0x04, 0x00, 0x78, 0x10,
+	0x49, 0xfa, 0xf7, 0x0f, 0x08, 0x00, 0x70, 0xf0, 0x91, 0xe2, 0x84, 0x04, 0x00, 0x10, 0xfc, 0xfd,
+	0x8b, 0x22, 0x61, 0x00, 0x00, 0x38, 0x23, 0x1a, 0x92, 0xf8, 0xc3, 0x0f, 0x04, 0x00, 0x00, 0x04,
+	0xfc, 0xfd, 0x83, 0x80, 0x0f, 0x1e, 0x10, 0x00, 0x00, 0xe8, 0xe9, 0x03, 0x02, 0x20, 0xa4, 0x9f,
+	0x7e, 0x00, 0x00, 0x04, 0xfc, 0xfd, 0x83, 0xc0, 0x8f, 0x1d, 0x10, 0x00, 0x04, 0xfc, 0xfd, 0x03,
+	0x02, 0x00, 0x10, 0xf0, 0xf1, 0x83, 0x80, 0x8f, 0x1f, 0x04, 0x7c, 0xfc, 0x80, 0x00, 0x00, 0x10,
+	0xf0, 0xf1, 0x43, 0xc0, 0x8f, 0x1f, 0x10, 0x00, 0x30, 0xf0, 0x10, 0x63, 0x84, 0x07, 0x06, 0x00,
+	0x20, 0x80, 0x3f, 0xfe, 0x89, 0xc5, 0x08, 0x3c, 0xc0, 0x00, 0x00, 0x30, 0xc0, 0x03, 0x31, 0x18,
+	0x81, 0x7f, 0xfe, 0x03, 0x08, 0x00, 0x10, 0xf0, 0xf3, 0x87, 0x84, 0x00, 0x03, 0x00, 0x48, 0xb8,
+	0xd1, 0x62, 0x87, 0x04, 0x00, 0x14, 0xfc, 0xfd, 0x83, 0x04, 0x05, 0x00, 0x10, 0xf0, 0xf0, 0x03,
+	0x04, 0x04, 0x1f, 0x3f, 0x20, 0x00, 0x00, 0x10, 0xf0, 0xf0, 0x03, 0x06, 0x08, 0x0f, 0x0f, 0x00,
+	0x10, 0xf0, 0xf0, 0x03, 0x04, 0x07, 0x0f, 0x20, 0x3c, 0x3c, 0x00, 0x00, 0x68, 0x98, 0x71, 0x81,
+	0x81, 0x86, 0x18, 0x13, 0x00, 0x10, 0xc3, 0x33, 0x3f, 0x01, 0x89, 0x3f, 0xfe, 0x00, 0x00, 0x90,
+	0x90, 0xb1, 0xe2, 0x84, 0x04, 0x00, 0x40, 0xc0, 0x7f, 0x02, 0x04, 0x00, 0x00, 0xc0, 0x7f, 0xfe,
+	0x03, 0x00, 0x06, 0xe4, 0x7f, 0x40, 0x00, 0x00, 0x40, 0x00, 0x03, 0x70, 0x00, 0x0e, 0xc0, 0x00,
+	0x02, 0x00, 0x00,
+};
+
+/* Glyphs */
+static const xg_glyph_t PROGMEM XG_FONT_Alagard_12pt_glyphs[95] = {
+	{ .offset = 0, .code = 0x20, .width = 4, .height = 9, },	/* ' ' */
+	{ .offset = 5, .code = 0x21, .width = 5, .height = 9, },	/* '!' */
+	{ .offset = 11, .code = 0x22, .width = 7, .height = 9, },	/* '"' */
+	{ .offset = 19, .code = 0x23, .width = 8, .height = 9, },	/* '#' */
+	{ .offset = 28, .code = 0x24, .width = 7, .height = 9, },	/* '$' */
+	{ .offset = 36, .code = 0x25, .width = 9, .height = 9, },	/* '%' */
+	{ .offset = 47, .code = 0x26, .width = 9, .height = 9, },	/* '&' */
+	{ .offset = 58, .code = 0x27, .width = 4, .height = 9, },	/* '\'' */
+	{ .offset = 63, .code = 0x28, .width = 5, .height = 9, },	/* '(' */
+	{ .offset = 69, .code = 0x29, .width = 5, .height = 9, },	/* ')' */
+	{ .offset = 75, .code = 0x2a, .width = 5, .height = 9, },	/* '*' */
+	{ .offset = 81, .code = 0x2b, .width = 7, .height = 9, },	/* '+' */
+	{ .offset = 89, .code = 0x2c, .width = 3, .height = 12, },	/* ',' */
+	{ .offset = 94, .code = 0x2d, .width = 4, .height = 9, },	/* '-' */
+	{ .offset = 99, .code = 0x2e, .width = 3, .height = 12, },	/* '.' */
+	{ .offset = 104, .code = 0x2f, .width = 9, .height = 12, },	/* '/' */
+	{ .offset = 118, .code = 0x30, .width = 7, .height = 9, },	/* '0' */
+	{ .offset = 126, .code = 0x31, .width = 5, .height = 9, },	/* '1' */
+	{ .offset = 132, .code = 0x32, .width = 6, .height = 9, },	/* '2' */
+	{ .offset = 139, .code = 0x33, .width = 7, .height = 9, },	/* '3' */
+	{ .offset = 147, .code = 0x34, .width = 8, .height = 9, },	/* '4' */
+	{ .offset = 156, .code = 0x35, .width = 6, .height = 9, },	/* '5' */
+	{ .offset = 163, .code = 0x36, .width = 7, .height = 9, },	/* '6' */
+	{ .offset = 171, .code = 0x37, .width = 7, .height = 9, },	/* '7' */
+	{ .offset = 179, .code = 0x38, .width = 7, .height = 9, },	/* '8' */
+	{ .offset = 187, .code = 0x39, .width = 7, .height = 9, },	/* '9' */
+	{ .offset = 195, .code = 0x3a, .width = 3, .height = 9, },	/* ':' */
+	{ .offset = 199, .code = 0x3b, .width = 3, .height = 9, },	/* ';' */
+	{ .offset = 203, .code = 0x3c, .width = 5, .height = 12, },	/* '<' */
+	{ .offset = 211, .code = 0x3d, .width = 7, .height = 12, },	/* '=' */
+	{ .offset = 222, .code = 0x3e, .width = 5, .height = 12, },	/* '>' */
+	{ .offset = 230, .code = 0x3f, .width = 6, .height = 12, },	/* '?' */
+	{ .offset = 239, .code = 0x40, .width = 10, .height = 12, },	/* '@' */
+	{ .offset = 254, .code = 0x41, .width = 8, .height = 9, },	/* 'A' */
+	{ .offset = 263, .code = 0x42, .width = 8, .height = 9, },	/* 'B' */
+	{ .offset = 272, .code = 0x43, .width = 7, .height = 9, },	/* 'C' */
+	{ .offset = 280, .code = 0x44, .width = 8, .height = 9, },	/* 'D' */
+	{ .offset = 289, .code = 0x45, .width = 8, .height = 9, },	/* 'E' */
+	{ .offset = 298, .code = 0x46, .width = 8, .height = 9, },	/* 'F' */
+	{ .offset = 307, .code = 0x47, .width = 8, .height = 9, },	/* 'G' */
+	{ .offset = 316, .code = 0x48, .width = 9, .height = 9, },	/* 'H' */
+	{ .offset = 327, .code = 0x49, .width = 5, .height = 9, },	/* 'I' */
+	{ .offset = 333, .code = 0x4a, .width = 4, .height = 11, },	/* 'J' */
+	{ .offset = 339, .code = 0x4b, .width = 9, .height = 9, },	/* 'K' */
+	{ .offset = 350, .code = 0x4c, .width = 7, .height = 9, },	/* 'L' */
+	{ .offset = 358, .code = 0x4d, .width = 13, .height = 9, },	/* 'M' */
+	{ .offset = 373, .code = 0x4e, .width = 9, .height = 9, },	/* 'N' */
+	{ .offset = 384, .code = 0x4f, .width = 7, .height = 9, },	/* 'O' */
+	{ .offset = 392, .code = 0x50, .width = 8, .height = 9, },	/* 'P' */
+	{ .offset = 401, .code = 0x51, .width = 8, .height = 10, },	/* 'Q' */
+	{ .offset = 411, .code = 0x52, .width = 9, .height = 9, },	/* 'R' */
+	{ .offset = 422, .code = 0x53, .width = 7, .height = 9, },	/* 'S' */
+	{ .offset = 430, .code = 0x54, .width = 8, .height = 9, },	/* 'T' */
+	{ .offset = 439, .code = 0x55, .width = 9, .height = 9, },	/* 'U' */
+	{ .offset = 450, .code = 0x56, .width = 8, .height = 9, },	/* 'V' */
+	{ .offset = 459, .code = 0x57, .width = 10, .height = 9, },	/* 'W' */
+	{ .offset = 471, .code = 0x58, .width = 9, .height = 9, },	/* 'X' */
+	{ .offset = 482, .code = 0x59, .width = 8, .height = 9, },	/* 'Y' */
+	{ .offset = 491, .code = 0x5a, .width = 7, .height = 9, },	/* 'Z' */
+	{ .offset = 499, .code = 0x5b, .width = 4, .height = 11, },	/* '[' */
+	{ .offset = 505, .code = 0x5c, .width = 8, .height = 9, },	/* '\\' */
+	{ .offset = 514, .code = 0x5d, .width = 4, .height = 11, },	/* ']' */
+	{ .offset = 520, .code = 0x5e, .width = 7, .height = 12, },	/* '^' */
+	{ .offset = 531, .code = 0x5f, .width = 8, .height = 12, },	/* '_' */
+	{ .offset = 543, .code = 0x60, .width = 5, .height = 12, },	/* '`' */
+	{ .offset = 551, .code = 0x61, .width = 7, .height = 9, },	/* 'a' */
+	{ .offset = 559, .code = 0x62, .width = 7, .height = 9, },	/* 'b' */
+	{ .offset = 567, .code = 0x63, .width = 6, .height = 9, },	/* 'c' */
+	{ .offset = 574, .code = 0x64, .width = 7, .height = 9, },	/* 'd' */
+	{ .offset = 582, .code = 0x65, .width = 6, .height = 9, },	/* 'e' */
+	{ .offset = 589, .code = 0x66, .width = 7, .height = 9, },	/* 'f' */
+	{ .offset = 597, .code = 0x67, .width = 7, .height = 11, },	/* 'g' */
+	{ .offset = 607, .code = 0x68, .width = 8, .height = 9, },	/* 'h' */
+	{ .offset = 616, .code = 0x69, .width = 4, .height = 9, },	/* 'i' */
+	{ .offset = 621, .code = 0x6a, .width = 4, .height = 11, },	/* 'j' */
+	{ .offset = 627, .code = 0x6b, .width = 8, .height = 9, },	/* 'k' */
+	{ .offset = 636, .code = 0x6c, .width = 5, .height = 9, },	/* 'l' */
+	{ .offset = 642, .code = 0x6d, .width = 11, .height = 9, },	/* 'm' */
+	{ .offset = 655, .code = 0x6e, .width = 8, .height = 9, },	/* 'n' */
+	{ .offset = 664, .code = 0x6f, .width = 7, .height = 9, },	/* 'o' */
+	{ .offset = 672, .code = 0x70, .width = 8, .height = 11, },	/* 'p' */
+	{ .offset = 683, .code = 0x71, .width = 8, .height = 11, },	/* 'q' */
+	{ .offset = 694, .code = 0x72, .width = 7, .height = 9, },	/* 'r' */
+	{ .offset = 702, .code = 0x73, .width = 6, .height = 9, },	/* 's' */
+	{ .offset = 709, .code = 0x74, .width = 6, .height = 9, },	/* 't' */
+	{ .offset = 716, .code = 0x75, .width = 9, .height = 9, },	/* 'u' */
+	{ .offset = 727, .code = 0x76, .width = 8, .height = 9, },	/* 'v' */
+	{ .offset = 736, .code = 0x77, .width = 10, .height = 9, },	/* 'w' */
+	{ .offset = 748, .code = 0x78, .width = 8, .height = 9, },	/* 'x' */
+	{ .offset = 757, .code = 0x79, .width = 7, .height = 11, },	/* 'y' */
+	{ .offset = 767, .code = 0x7a, .width = 6, .height = 9, },	/* 'z' */
+	{ .offset = 774, .code = 0x7b, .width = 4, .height = 12, },	/* '{' */
+	{ .offset = 780, .code = 0x7c, .width = 4, .height = 12, },	/* '|' */
+	{ .offset = 786, .code = 0x7d, .width = 4, .height = 12, },	/* '}' */
+	{ .offset = 792, .code = 0x7e, .width = 7, .height = 12, },	/* '~' */
+};
+
+/* Font */
+const xg_font_t XG_FONT_Alagard_12pt = {
+	.glyphs = XG_FONT_Alagard_12pt_glyphs,
+	.bitmaps = XG_FONT_Alagard_12pt_bitmaps,
+	.length = 95,
+};
+
+#endif /* XG_FONT_Alagard_12pt_H_ */
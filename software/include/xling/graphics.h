@@ -39,11 +39,13 @@ typedef void (*xg_cbk_t)(void *scene_ctx);
 typedef enum xg_object_t {
 	XG_OT_IMG,
 	XG_OT_ANIM,
+	XG_OT_TILEMAP,
 } xg_object_t;
 
 typedef enum xg_scene_mode_t {
 	XG_SM_SCENE = 0,
 	XG_SM_SPEECH,
+	XG_SM_TRANSITION,
 } xg_scene_mode_t;
 
 typedef enum xg_speech_mode_t {
@@ -52,16 +54,51 @@ typedef enum xg_speech_mode_t {
 	XG_SPM_PAUSE
 } xg_speech_mode_t;
 
+/*
+ * Fill modes of the primitives (see xg_fill_rect()): pixels are set, cleared
+ * or inverted.
+ */
+typedef enum xg_fill_t {
+	XG_FILL_SET = 0,
+	XG_FILL_CLEAR,
+	XG_FILL_XOR
+} xg_fill_t;
+
 typedef struct xg_point_t {
 	int16_t			 x;
 	int16_t			 y;
 } xg_point_t;
 
-typedef struct xg_layer_t {
+/*
+ * Operation of the scene draw list, i.e. a layer of the scene. Draw list is
+ * generated by the exporters in the drawing order and executed by
+ * xg_draw_scene() as is.
+ */
+typedef struct xg_draw_op_t {
+	const void		*obj;
 	xg_point_t		 base_pt;
-	void			*obj;
-	xg_object_t		 obj_type;
-} xg_layer_t;
+	uint8_t			 obj_type; /* See xg_object_t. */
+	uint8_t			 group; /* Index of the group of the layer. */
+} xg_draw_op_t;
+
+/*
+ * Group of layers.
+ *
+ * Layers of a group are moved together by a single offset of the group and
+ * scrolled together with the scene according to the parallax factor of the
+ * group, i.e. every layer is drawn at:
+ *
+ *     base_pt + offset of the group + pan of the scene * parallax / XG_PX_ONE
+ *
+ * Group with parallax of XG_PX_ONE is scrolled with the scene, the one with
+ * zero parallax stays where its offset says (e.g. a character). Layers which
+ * aren't in any group are in the first one.
+ */
+#define XG_PX_ONE		(64u) /* Parallax factor of 1.0 */
+
+typedef struct xg_group_t {
+	uint8_t			 parallax; /* In 1/XG_PX_ONE units. */
+} xg_group_t;
 
 /*
  * Scene represents a full state of the display at the given moment
@@ -75,23 +112,154 @@ typedef struct xg_layer_t {
  * layer in Xling scene. Several GIMP layers can form a single
  * layer with an animation, for example.
  *
- * layers
+ * ops
+ *
+ *     Pointer to the draw list of the scene: Xling objects (images,
+ *     animations, etc.) which compose the scene. Each operation is a single
+ *     layer (like layers organized in GIMP). The first one is the bottom
+ *     layer, the last one is the top one, i.e. layer i of the xg_get_*()
+ *     functions (0 is the top layer) is operation ops_n - 1 - i.
+ *
+ * groups
+ *
+ *     Pointer to an array of groups of the layers (see xg_group_t).
+ *
+ * offsets
+ *
+ *     Pointer to an array in RAM with an offset of every group. All of the
+ *     layers of a group (and all frames of its animations) are moved by
+ *     changing the offset of the group.
+ *
+ * pan
+ *
+ *     Pointer to a point in RAM the scene is scrolled by. Every group is
+ *     scrolled according to its parallax factor.
+ *
+ * ops_n
+ *
+ *     Number of operations (layers).
+ *
+ * cached_n
+ *
+ *     Number of the static operations (images and tile maps) at the start of
+ *     the draw list, at most XG_CACHED_MAX. They're drawn once into the cache
+ *     canvas (see xg_cache_canvas()) and restored from it while their groups
+ *     stay where they are.
+ *
+ * groups_n
+ *
+ *     Number of groups.
+ *
+ * kbd_cbk
+ *
+ *     Keyboard callback of the scene (XG_SCNKBD_*) or NULL.
+ *
+ * script
+ *
+ *     Bytecode of the scene in flash (see XG_SC_*) or NULL.
+ *
+ * vars
  *
- *     Pointer to an array of Xling objects (images, animations, etc.)
- *     which compose the scene. Each layer represents a single image
- *     (like layers organized in GIMP). The first one is the top layer,
- *     the last one is the bottom one.
+ *     Pointer to an array in RAM with variables of the script.
  *
- * layers_n
+ * Scene and its draw list, groups, animations, frames and images are in flash
+ * and never change, they're read by xg_get_*() functions. Only the offsets of
+ * the groups, the pan of the scene and states of the animations (see
+ * xg_anim_state_t) are in RAM.
+ */
+#define XG_CACHED_MAX		(64u)
+
+/*
+ * Bytecode of the scene.
+ *
+ * Behaviour of the scene is compiled by xlingc from a script (see
+ * common/xlingc/script.c) instead of the XG_SCNKBD_* callback written in C.
+ * Bytecode starts with the number of variables and their initial values,
+ * handlers of the keyboard events follow: an event (xm_btn_state_t), length
+ * of the handler and its operations. Zero event ends the list. Handler of
+ * the last received event is run by xg_run_script() every frame.
  *
- *     Number of layers.
+ * NOTE: Handlers are level-triggered like the XG_SCNKBD_* callbacks: the
+ *       handler of XM_BTN_LEFT_PRESSED runs every frame until the button is
+ *       released, which is how the walking is made. A one-shot action (e.g.
+ *       XG_SC_SAY) is latched by a variable: XG_SC_IFVAR and XG_SC_SET in
+ *       the handler of the press, reset in the handler of the release.
+ *       A scene with the bytecode has no callback, the display task runs
+ *       one of them only.
+ *
+ * Operations and their operands (bytes, 16-bit ones are little-endian):
+ *
+ *	XG_SC_ACTIVE	layer, active	Set the active flag of the animation.
+ *	XG_SC_MOVE	group, dx, dy	Move the group.
+ *	XG_SC_PAN	dx, dy		Scroll the scene.
+ *	XG_SC_WALK	group, dx,	Move the group by dx if its offset is
+ *			lo:16, hi:16	within (lo, hi), scroll the scene by -dx
+ *					otherwise.
+ *	XG_SC_CHANCE	layer, mask:16	Set alt_flip of the animation.
+ *	XG_SC_SET	var, value	Set a variable.
+ *	XG_SC_IFVAR	var, value, n	Skip n bytes unless the variable has
+ *					the value.
+ *	XG_SC_IFMODE	mode, n		Skip n bytes unless the scene is in
+ *					the mode (xg_scene_mode_t).
+ *	XG_SC_JUMP	n		Skip n bytes.
+ *	XG_SC_MODE	mode, trans	Set mode of the scene. The speech
+ *					turns its page, it's left by the
+ *					transition trans (xg_trans_t) after
+ *					the last one.
+ *	XG_SC_SAY	n, text...	Say one of n NUL-terminated phrases at
+ *					random (XG_SM_SPEECH).
+ *
+ * dx and dy are signed. Layers are the same as of xg_get_anim_state().
  */
+#define XG_SC_ACTIVE		(0x01u)
+#define XG_SC_MOVE		(0x02u)
+#define XG_SC_PAN		(0x03u)
+#define XG_SC_WALK		(0x04u)
+#define XG_SC_CHANCE		(0x05u)
+#define XG_SC_SET		(0x06u)
+#define XG_SC_IFVAR		(0x07u)
+#define XG_SC_IFMODE		(0x08u)
+#define XG_SC_JUMP		(0x09u)
+#define XG_SC_MODE		(0x0Au)
+#define XG_SC_SAY		(0x0Bu)
+
 typedef struct xg_scene_t {
-	xg_layer_t		*layers;
-	const uint16_t		 layers_n;
+	const xg_draw_op_t	*ops;
+	const xg_group_t	*groups;
+	xg_point_t		*offsets;
+	xg_point_t		*pan;
+	uint16_t		 ops_n;
+	uint8_t			 cached_n;
+	uint8_t			 groups_n;
 	xg_cbk_t		 kbd_cbk;
+	const uint8_t		*script;
+	uint8_t			*vars;
 } xg_scene_t;
 
+/*
+ * Address of the asset data in flash.
+ *
+ * Data of images, tile maps, deltas and font bitmaps is large, so exporters
+ * put it into the __memx address space. Compiler places such data into the
+ * .progmemx sections, which the linker script puts after the code and
+ * the PROGMEM data, i.e. it might be anywhere in the 128 KiB of flash. Assets
+ * are addressed by 24-bit pointers and read with pgm_read_byte_far().
+ * Descriptors of the assets (images, layers, animations, etc.) are small and
+ * stay in PROGMEM below 64 KiB.
+ */
+typedef const __memx uint8_t	*xg_addr_t;
+
+/*
+ * NUL-terminated text in flash, e.g. a phrase of the speech. It's addressed
+ * like the assets (see xg_addr_t) and read by characters as it's drawn, so
+ * the text is never copied into RAM. Tables of such strings are kept in
+ * PROGMEM and read by xg_get_str():
+ *
+ *	static const __memx char hello[] = "Hello!";
+ *	static const xg_str_t PROGMEM phrases[] = { hello, ... };
+ */
+typedef const __memx char	*xg_str_t;
+
 typedef struct xg_canvas_t {
 	uint8_t			*data;
 	uint16_t		 width;
@@ -99,14 +267,107 @@ typedef struct xg_canvas_t {
 	uint16_t		 data_size;
 } xg_canvas_t;
 
+/*
+ * Layout of the image alpha channel.
+ *
+ * XG_AT_PLANE
+ *
+ *     A mask byte for every data byte of the image (bit is set for an opaque
+ *     pixel). It's what the LCD Image Converter generates.
+ *
+ * XG_AT_RUNS
+ *
+ *     Each page of the image is described by runs of the columns. Every run
+ *     starts with a byte: kind of the run in two most significant bits and
+ *     length of the run minus one in the rest of them. Runs of the masked
+ *     columns are followed by their mask bytes. Data bytes under the
+ *     transparent columns are never read.
+ *
+ * Alpha channel of the fully opaque image is dropped, i.e. alpha is NULL.
+ */
+typedef enum xg_alpha_t {
+	XG_AT_PLANE = 0,
+	XG_AT_RUNS
+} xg_alpha_t;
+
+#define XG_AR_TRANSPARENT	(0x00u)	/* Transparent columns. */
+#define XG_AR_OPAQUE		(0x40u)	/* Opaque columns. */
+#define XG_AR_MASK		(0x80u)	/* Masked columns. */
+#define XG_AR_KIND(b)		((b) & 0xC0u)
+#define XG_AR_LEN(b)		((uint16_t)(((b) & 0x3Fu) + 1u))
+#define XG_AR_MAX_LEN		(64u)
+
+/*
+ * Flags of xg_draw_pf(). Besides the mirroring they select how pixels of the
+ * image are blended with the canvas under the alpha channel (XG_DRAW_BLEND).
+ */
+#define XG_DRAW_HFLIP		(0x01u) /* Mirror the image horizontally. */
+#define XG_DRAW_REPLACE		(0x00u) /* Put pixels of the image. */
+#define XG_DRAW_OR		(0x02u) /* Set pixels set in the image. */
+#define XG_DRAW_CLEAR		(0x04u) /* Clear pixels set in the image. */
+#define XG_DRAW_XOR		(0x06u) /* Invert pixels set in the image. */
+#define XG_DRAW_INVERT		(0x08u) /* Put inverted pixels of the image. */
+#define XG_DRAW_BLEND(f)	((uint8_t)((f) & 0x0Eu))
+
 typedef struct xg_image_t {
-	const uint8_t		*data;
-	const uint8_t		*alpha;
+	xg_addr_t		 data;
+	xg_addr_t		 alpha;
 	uint16_t		 width;
 	uint16_t		 height;
 	uint16_t		 data_size;
+	uint8_t			 alpha_type; /* See xg_alpha_t. */
+	uint8_t			 in_ram; /* Data and alpha are in RAM. */
 } xg_image_t;
 
+/*
+ * Tile map.
+ *
+ * Opaque background which is composed of 8x8 tiles, i.e. every tile is 8 bytes
+ * of a single display page. Tile set is de-duplicated by xlingc, the map
+ * is a row of tile indexes for every page of the background. Both of them are
+ * in flash. Tile map is copied right into the pages of the canvas when it's
+ * at the top of a display page, it's shifted byte by byte otherwise. It's
+ * scrolled horizontally by moving its layer to any x coordinate.
+ */
+#define XG_TILE_WIDTH		(8u) /* px */
+
+typedef struct xg_tilemap_t {
+	xg_addr_t		 tiles;
+	xg_addr_t		 map;
+	uint16_t		 width; /* in tiles */
+	uint16_t		 height; /* in tiles */
+} xg_tilemap_t;
+
+/*
+ * Delta of an animation frame.
+ *
+ * Frames of an animation might be stored as changes to the previous frame of
+ * the same path instead of complete images. The first byte of the delta is a
+ * set of flags, spans of the changed bytes follow it:
+ *
+ *     <length> <offset, 2 bytes LE> <data bytes> <alpha bytes>
+ *
+ * where offset is an index of the first changed byte in the data (and alpha)
+ * of the work image of the animation. A span of zero length ends the delta.
+ * Work image is cleared before applying a delta of the key frame, i.e. the
+ * first frame of a path.
+ */
+#define XG_DF_KEY		(0x01u) /* Delta of the key frame. */
+#define XG_AW_NONE		(0xFFFFu) /* Work image is empty. */
+
+/*
+ * Operations of the animation frames, i.e. how the frame which follows the
+ * current one is chosen:
+ *
+ *	XG_AT_CHANCE	Go to the alt frame if a random byte (0..254) is less
+ *			than the threshold, to the next frame otherwise. So the
+ *			threshold of 0 never goes to alt, 255 always does.
+ *	XG_AT_LOOP	Go to the alt frame threshold times in a row, then go
+ *			to the next frame.
+ */
+#define XG_AT_CHANCE		(0x00u)
+#define XG_AT_LOOP		(0x01u)
+
 /*
  * A single animation frame.
  *
@@ -116,63 +377,241 @@ typedef struct xg_image_t {
  *  2. A point to start painting this frame from (in relative coordinates
  *     which start from the layer's base point);
  *  3. Number of frame update cycles to stay at the screen;
- *  4. Frames counter to understand when to switch to the next animation frame.
+ *  4. A transition to the frame which follows this one: indexes of the next
+ *     and the alternative frames, an operation (XG_AT_*) and its threshold,
+ *     all of them precomputed by the exporter.
  */
 typedef struct xg_anim_frame_t {
 	xg_point_t		 base_pt;
-	const xg_image_t	*img;
+	const xg_image_t	*img; /* NULL for a frame with delta. */
+	xg_addr_t		 delta; /* Delta in flash or NULL. */
+	uint16_t		 next;
 	uint16_t		 alt;
-	uint16_t		 alt_chance;
 	uint16_t		 stay;
+	uint8_t			 threshold;
+	uint8_t			 op;
 } xg_anim_frame_t;
 
-typedef struct xg_anim_t {
-	xg_anim_frame_t		*frames;
-	const uint16_t		 frames_n;
+/*
+ * State of an animation, the only part of it in RAM.
+ *
+ * Frames with deltas are drawn from the work image: delta of the frame is
+ * applied to the work image with the previous frame of the path. work_idx is
+ * an index of the frame in the work image (XG_AW_NONE if there is none).
+ *
+ * Bit i of alt_flip inverts the chance of the frame i to go to its
+ * alternative frame, i.e. 100% becomes 0% and vice versa. Only the first
+ * XG_AF_FRAMES frames can be flipped, XG_AT_LOOP frames are never flipped.
+ * loop_cnt counts the jumps of the current XG_AT_LOOP frame.
+ */
+#define XG_AF_FRAMES		(16u)
+
+typedef struct xg_anim_state_t {
 	uint16_t		 frame_idx;
 	uint16_t		 stay_cnt;
+	uint16_t		 work_idx;
+	uint16_t		 alt_flip;
 	uint8_t			 active;
-} xg_anim_t;
+	uint8_t			 loop_cnt;
+} xg_anim_state_t;
 
-typedef struct xg_glyph_t {
-	uint32_t		 code;
-	const uint8_t		*data;
+/*
+ * Work image of an animation: descriptor is in flash, but its data and alpha
+ * plane are in RAM. Data size is always 8 bits.
+ */
+typedef struct xg_work_t {
+	uint8_t			*data;
+	uint8_t			*alpha;
 	uint16_t		 width;
 	uint16_t		 height;
-	uint16_t		 data_size;
+} xg_work_t;
+
+/*
+ * Animation. Work image is used by the frames with deltas only.
+ *
+ * Animation with XG_DRAW_HFLIP in flags is a mirrored copy of another one: it
+ * shares frames of the original animation and draws them mirrored about
+ * mirror_x, i.e. a pixel of the frame at x is drawn at mirror_x - 1 - x.
+ */
+typedef struct xg_anim_t {
+	const xg_anim_frame_t	*frames;
+	const xg_work_t		*work;
+	xg_anim_state_t		*state;
+	uint16_t		 frames_n;
+	uint8_t			 active; /* Initial state->active. */
+	int16_t			 mirror_x;
+	uint8_t			 flags; /* Flags of xg_draw_pf(). */
+} xg_anim_t;
+
+/*
+ * Glyph of the bitmap font.
+ *
+ * Glyph bitmap is packed at the real height of the glyph: columns follow one
+ * after another from the left to the right, every column takes exactly height
+ * bits and its top pixel is the least significant one. Bitmap of a glyph
+ * starts at the byte boundary. Glyphs are drawn as opaque rectangles.
+ */
+#define XG_GLYPH_MAX_HEIGHT	(24u)
+
+typedef struct xg_glyph_t {
+	uint16_t		 offset; /* Offset in the bitmaps, in bytes. */
+	uint8_t			 code;
+	uint8_t			 width;
+	uint8_t			 height;
 } xg_glyph_t;
 
+/*
+ * Bitmap font. Both glyph table (sorted by the codes) and bitmaps are in
+ * flash, glyphs of the characters which aren't used by the firmware might be
+ * missing (see font.c of xlingc).
+ */
 typedef struct xg_font_t {
-	uint32_t		 length;
 	const xg_glyph_t	*glyphs;
+	xg_addr_t		 bitmaps;
+	uint16_t		 length;
 } xg_font_t;
 
+/*
+ * Text to be drawn by xg_print() or xg_draw_speech(). It's either a string in
+ * flash (str) or a formatted text in the RAM buffer (text) if str is NULL.
+ *
+ * Speech is drawn by pages which fit the canvas. Line breaks of the current
+ * page are found once by xg_say() or xg_next_page() and drawn_len moves from
+ * one break to another (see xg_draw_speech()).
+ */
+#define XG_SPEECH_LINES		(8u) /* Lines of a page at most. */
+
+/*
+ * Cache of the rendered text (see xg_print_cached()). configXG_TEXT_CACHE_SZ
+ * bytes of RAM are split between the slots equally, every slot keeps text
+ * which takes a half of the slot at most (the rest is its mask). Zero turns
+ * the cache off (by default), xg_print_cached() is xg_print() in this case.
+ */
+#ifndef configXG_TEXT_CACHE_SZ
+#define configXG_TEXT_CACHE_SZ	(0)
+#endif
+#define XG_TEXT_CACHE_SLOTS	(4u)
+
 typedef struct xg_text_t {
 	xg_point_t		 drawn_pt;
 	const xg_font_t		*font;
 	char			*text;
 	size_t			 text_sz;
+	xg_str_t		 str;
 	size_t			 drawn_len;
+	size_t			 breaks[XG_SPEECH_LINES]; /* Ends of lines. */
+	uint8_t			 lines_n; /* Lines of the page. */
+	uint8_t			 line; /* Line being drawn. */
 	uint8_t			 skip_cycles;
 } xg_text_t;
 
+/*
+ * Formatting of the numbers.
+ *
+ * xg_format() fills the text buffer by a template in flash: "%u" is replaced
+ * by the next argument, "%Nu" aligns it to the right of N (1-5) characters,
+ * "%%" is a percent sign, e.g. "%3u%%" or "%u ms". Digits are found by
+ * subtraction of the powers of ten, vfprintf() of the libc isn't linked.
+ *
+ * xg_print_uint() draws the digits without any text at all: glyphs of the
+ * digits are looked up once per font and kept in RAM.
+ */
+#define XG_UINT_DIGITS		(5u) /* Digits of UINT16_MAX. */
+#define XG_UINT_BUFSZ		(XG_UINT_DIGITS + 1u)
+
+/*
+ * Scene manager.
+ *
+ * Exported scenes are listed in a registry in flash (XG_SCENES, generated by
+ * xlingc). They share RAM, so only the current scene has a state: it's
+ * initialized by xg_enter_scene() and taken by the next scene on exit.
+ *
+ * xg_switch_scene() enters the scene and draws its static background (cached
+ * operations of the draw list) right into the cache canvas. Then the next
+ * XG_SM_TRANSITION frames slide the cached background in from the right over
+ * the last frame of the previous scene, XG_TR_STEP columns per frame (see
+ * xg_draw_transition()). The scene is drawn as usual after that with the
+ * background already cached. None of these steps takes longer than drawing
+ * a frame of the scene.
+ *
+ * NOTE: Transitions end on the cached background only. Animations and the
+ *       other operations of the draw list which aren't cached appear at once
+ *       in the first frame of the scene after the transition.
+ *
+ * xg_start_transition() goes to the cached background of the current scene
+ * the same way, e.g. at the end of the speech (XG_SC_MODE of the script or
+ * XG_TR_FADE in the XG_SCNKBD_* callbacks). Transitions (xg_trans_t) are
+ * made of page operations between the canvas and the cache canvas, the fade
+ * only ramps the contrast of the display (the contrast of the context, it's
+ * sent to the display by the display task) and swaps the canvas at the
+ * darkest step.
+ */
+#define XG_TR_STEP		(16u) /* px */
+#define XG_TR_DITHER_STEP	(2u) /* Levels of the 4x4 dither per frame. */
+#define XG_TR_FADE_STEPS	(6u) /* Frames to fade out and fade in. */
+#define XG_CONTRAST		(0x75u) /* Contrast of the display. */
+
+typedef enum xg_trans_t {
+	XG_TR_WIPE = 0,		/* Wipe from the left to the right. */
+	XG_TR_SLIDE,		/* Slide in from the right. */
+	XG_TR_DISSOLVE,		/* Dissolve by the ordered dither. */
+	XG_TR_FADE		/* Fade out and in by the contrast. */
+} xg_trans_t;
+
 /* Scene context. */
 typedef struct xg_scene_ctx_t {
-	xg_scene_t		*scene;
+	const xg_scene_t * const *scenes; /* Registry of the scenes. */
+	uint16_t		 scenes_n;
+	uint16_t		 scene_idx;
+	uint16_t		 trans_step; /* Progress of the transition. */
+	uint8_t			 trans; /* See xg_trans_t. */
+	uint8_t			 contrast;
+	const xg_scene_t	*scene;
 	xg_canvas_t		*canvas;
 	xg_text_t		*text;
 	uint16_t		 frame_delay;
 	uint16_t		 bat_lvl;
 	uint16_t		 bat_stat;
-	xm_btn_state_t		 btn_stat;
+	xm_btn_state_t		 btn_stat; /* XM_BTN_NONE in a new scene. */
 	xg_scene_mode_t		 scene_mode;
 } xg_scene_ctx_t;
 
 /* Xling graphics API */
 int	xg_print(xg_canvas_t *canvas, const xg_text_t *text, xg_point_t p);
+int	xg_print_cached(xg_canvas_t *canvas, const xg_text_t *text,
+    xg_point_t p);
 int	xg_draw_speech(xg_canvas_t *canvas, xg_text_t *text);
-int	xg_draw_pf(xg_canvas_t *canvas, const xg_image_t *image, xg_point_t p);
+int	xg_next_page(xg_canvas_t *canvas, xg_text_t *text);
+int	xg_print_uint(xg_canvas_t *canvas, const xg_text_t *text,
+    xg_point_t p, uint16_t val, uint8_t width);
+size_t	xg_fmt_uint(char *buf, uint16_t val, uint8_t width);
+int	xg_format(xg_text_t *text, xg_str_t tmpl, const uint16_t *args);
+int	xg_draw_pf(xg_canvas_t *canvas, const xg_image_t *image, xg_point_t p,
+    uint8_t flags);
+int	xg_draw_tilemap(xg_canvas_t *canvas, const xg_tilemap_t *tm,
+    xg_point_t p);
+int	xg_fill_rect(xg_canvas_t *canvas, xg_point_t p, uint16_t w, uint16_t h,
+    xg_fill_t mode);
+int	xg_hline(xg_canvas_t *canvas, xg_point_t p, uint16_t w,
+    xg_fill_t mode);
+int	xg_vline(xg_canvas_t *canvas, xg_point_t p, uint16_t h,
+    xg_fill_t mode);
+int	xg_frame(xg_canvas_t *canvas, xg_point_t p, uint16_t w, uint16_t h,
+    xg_fill_t mode);
+int	xg_invert_rect(xg_canvas_t *canvas, xg_point_t p, uint16_t w,
+    uint16_t h);
 int	xg_draw_scene(xg_canvas_t *canvas, const xg_scene_t *scene);
+void	xg_get_scene(const xg_scene_t *scene, xg_scene_t *buf);
+void	xg_enter_scene(const xg_scene_t *scene);
+int	xg_switch_scene(xg_scene_ctx_t *ctx, uint16_t idx);
+int	xg_start_transition(xg_scene_ctx_t *ctx, xg_trans_t trans);
+int	xg_draw_transition(xg_canvas_t *canvas, xg_scene_ctx_t *ctx);
+void	xg_run_script(xg_scene_ctx_t *ctx);
+void	xg_say(xg_scene_ctx_t *ctx, xg_str_t str);
+xg_str_t	xg_get_str(const xg_str_t *table, uint16_t idx);
+xg_anim_state_t	*xg_get_anim_state(const xg_scene_t *scene, uint16_t layer);
+int	xg_get_anim_frame(const xg_scene_t *scene, uint16_t layer,
+    uint16_t frame, xg_anim_frame_t *buf);
 int	xg_cache_canvas(xg_canvas_t *canvas);
 void	xg_transfer_canvas(MSIM_SH1106_t *display, const xg_canvas_t *canvas);
 
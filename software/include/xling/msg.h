@@ -49,6 +49,7 @@ typedef struct xm_msg_t {
 
 /* State of a button. */
 typedef enum xm_btn_state_t {
+	XM_BTN_NONE = 0,	/* No events since the scene is entered. */
 	XM_BTN_LEFT_RELEASED = 75,
 	XM_BTN_LEFT_PRESSED,
 	XM_BTN_LEFT_HOLD,
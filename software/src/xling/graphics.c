@@ -28,142 +28,346 @@
 #define CHAR_WIDTH		3 /* bits */
 #define PHEIGHT			8 /* bits */
 #define PAGES			8 /* in graphic RAM */
-#define MAX_CACHED_LAYERS	64
 #define SPEECH_DELAY_CYCLES	(1u)
 #define LINE_HEIGHT		(12u) /* px */
 #define NOT(u8)			((uint8_t)(~(u8)))
 #define PGM(a)			((uint8_t)(pgm_read_byte_far((a))))
+#define PGM_ADDR(a)		((uint_farptr_t)(uintptr_t)(a))
+#define ASSET_ADDR(a)		((uint_farptr_t)(a)) /* 24-bit, see xg_addr_t */
+#define RAM_PTR(a)		((const uint8_t *)(a))
+#define IMG(i, a)		((i)->in_ram ? *RAM_PTR(a) : PGM(ASSET_ADDR(a)))
+#define SC(a)			PGM(PGM_ADDR(a)) /* Byte of the bytecode. */
+#define SC16(a)			((int16_t)(SC(a) | (SC((a) + 1) << 8)))
+#define FAR_STR(a)		((xg_str_t) PGM_ADDR(a)) /* PROGMEM text. */
+#define TEXT_SLOT_SZ		(configXG_TEXT_CACHE_SZ / XG_TEXT_CACHE_SLOTS)
 
-typedef enum {
-	CACHE_INVALID = 0,
-	CACHE_VALID
-} cache_state_e;
+#if configXG_TEXT_CACHE_SZ > 0
+/*
+ * Slot of the text cache. Its data holds pages of the rendered text followed
+ * by the same number of mask bytes, i.e. rows covered by the glyphs.
+ */
+struct text_slot {
+	const xg_font_t		*font; /* NULL if the slot is free. */
+	uint32_t		 hash;
+	uint16_t		 width;
+	uint8_t			 shift; /* Vertical alignment of the text. */
+	uint8_t			 pages;
+	uint8_t			 used; /* Tick of the last use. */
+	uint8_t			 data[TEXT_SLOT_SZ];
+};
+#endif
 
-static void	get_img_byte(const xg_image_t * const image,
-    const uint32_t idx, uint8_t *data, uint8_t *alpha);
+static void	put_img_byte(xg_canvas_t *canvas, int16_t page, uint16_t col,
+    uint8_t shift, uint8_t data, uint8_t mask);
 static void	copy_canvas(xg_canvas_t *dest, const xg_canvas_t *src);
-
-/*
- * Calculates an auxiliary point with non-negative coordinates (__x, __y) which
- * will be used as a new top-left corner to draw a visible part of the orignal
- * image only. In addition, offset (__idx) in the image data array, (__width)
- * and (__height) of the new image will be provided.
- */
-#define CALC_AUX_POINT(__pt, __image, __x, __y, __idx, __width, __height) do { \
-	const uint16_t __off = (uint16_t)abs((__pt)->y % PHEIGHT);	\
-	int16_t __sw = (int16_t)(__image)->width; /* signed width */	\
-	int16_t __sh = (int16_t)(__image)->height; /* signed height */	\
-	int16_t __sx, __sy; /* signed coordinates */			\
-									\
-	(__x) = ((__pt)->x < 0) ? 0u : (uint16_t)(__pt)->x;		\
-	(__y) = ((__pt)->y < 0) ? (__off != 0u && abs((__pt)->y) < __sh) \
-	    ? (uint16_t)(PHEIGHT - __off) : 0u				\
-	    : (uint16_t)(__pt)->y;					\
-	__sx = (int16_t)(__x);						\
-	__sy = (int16_t)(__y);						\
-									\
-	(__idx) = ((__pt)->x >= 0 && (__pt)->y >= 0) ? 0u		\
-	    : (uint16_t)((((__sy - (__pt)->y) / PHEIGHT) * __sw) +	\
-		((__pt)->x < 0 ? abs((__pt)->x) : 0));			\
-									\
-	(__width)  = (__sw - (__sx - (__pt)->x)) < 0 ? 0u		\
-	    : (uint16_t)(__sw - (__sx - (__pt)->x));			\
-	(__height) = (__sh - (__sy - (__pt)->y)) < 0 ? 0u		\
-	    : (uint16_t)(__sh - (__sy - (__pt)->y));			\
-} while (0)
+static int16_t	clamp_coord(int32_t v);
+static void	draw_op(xg_canvas_t *canvas, const xg_draw_op_t *op,
+    xg_point_t off);
+static void	draw_anim(xg_canvas_t *canvas, const xg_anim_t *anim,
+    xg_point_t off);
+static uint8_t	anim_next_rnd(void);
+static int	is_cached(const xg_scene_t *scene, const xg_scene_t *scn);
+static void	cache_ops(const xg_scene_t *scene, const xg_scene_t *scn);
+static xg_point_t	get_group_offset(const xg_scene_t *scn, uint8_t group);
+static const xg_image_t	*get_frame_img(const xg_anim_t *anim,
+    const xg_anim_frame_t *frame, xg_image_t *buf);
+static xg_addr_t	get_frame_delta(const xg_anim_t *anim, uint16_t idx);
+static void	apply_delta(const xg_work_t *work, xg_addr_t delta);
+static void	run_handler(xg_scene_ctx_t *ctx, const xg_scene_t *scn,
+    const uint8_t *pc, const uint8_t *end);
+static const uint8_t	*say(xg_scene_ctx_t *ctx, const uint8_t *pc);
+static char	get_char(const xg_text_t *text, size_t i);
+static void	layout_page(const xg_canvas_t *canvas, xg_text_t *text);
+static uint8_t	get_digits(uint16_t val, uint8_t *digits);
+static int	get_glyph(const xg_font_t *font, char c, xg_glyph_t *glyph);
+static int	draw_glyph(xg_canvas_t *canvas, const xg_font_t *font,
+    const xg_glyph_t *glyph, xg_point_t pt);
+#if configXG_TEXT_CACHE_SZ > 0
+static struct text_slot	*render_text(const xg_text_t *text,
+    uint32_t hash, uint8_t shift);
+static void	blit_text(xg_canvas_t *canvas, const struct text_slot *slot,
+    int16_t x, int16_t top_page);
+#endif
 
 static xg_canvas_t *cache_canvas = NULL;
-static xg_point_t cache_pts[MAX_CACHED_LAYERS];
-static uint8_t cached_layers = 0;
-static cache_state_e cache_state = CACHE_INVALID;
+static const xg_scene_t *cache_scene = NULL; /* Scene in the cache. */
+static xg_point_t cache_pts[XG_CACHED_MAX];
+static uint16_t anim_rnd = 1u; /* State of the animations' generator. */
+static const xg_font_t *digits_font = NULL; /* Font of the digits' glyphs. */
+static xg_glyph_t digits_glyphs[10];
+static const uint16_t PROGMEM POW10[XG_UINT_DIGITS - 1u] = {
+	10000u, 1000u, 100u, 10u
+};
+/* Ordered dither 4x4 by the columns, see xg_draw_transition(). */
+static const uint8_t PROGMEM DITHER[4][4] = {
+	{ 0, 12, 3, 15 }, { 8, 4, 11, 7 }, { 2, 14, 1, 13 }, { 10, 6, 9, 5 }
+};
+#if configXG_TEXT_CACHE_SZ > 0
+static struct text_slot text_slots[XG_TEXT_CACHE_SLOTS];
+static uint8_t text_tick = 0;
+#endif
 
 /* Prints text on the canvas at the given coordinates. */
 int
 xg_print(xg_canvas_t *canvas, const xg_text_t *text, xg_point_t pt)
 {
-	const size_t len = strlen(text->text);
 	const xg_font_t *font = text->font;
-	xg_image_t glyph;
-	int glyph_idx, rc;
+	xg_glyph_t glyph;
+	char c;
+	int rc = 0;
 
 	/* Draw characters on the canvas. */
-	for (uint32_t i = 0; i < len; i++) {
-		/* Obtain an index of the current glyph. */
-		glyph_idx = text->text[i] - 0x20;
-
+	for (size_t i = 0; (c = get_char(text, i)) != '\0'; i++) {
 		/* Obtain the current glyph. */
-		glyph.alpha = NULL;
-		glyph.data = font->glyphs[glyph_idx].data;
-		glyph.width = font->glyphs[glyph_idx].width;
-		glyph.height = font->glyphs[glyph_idx].height;
-		glyph.data_size = font->glyphs[glyph_idx].data_size;
+		if (get_glyph(font, c, &glyph) != 0) {
+			/* Skip characters missing in the font. */
+			continue;
+		}
 
 		/* Draw the glyph. */
-		rc = xg_draw_pf(canvas, &glyph, pt);
+		rc = draw_glyph(canvas, font, &glyph, pt);
 		if (rc != 0) {
 			break;
 		}
 
 		/* Move the text cursor forward. */
-		pt.x += glyph.width > INT16_MAX ? 0 : (int16_t) glyph.width;
+		pt.x += glyph.width;
 	}
 
 	return rc;
 }
 
+/*
+ * Draws the next character of the speech, one per SPEECH_DELAY_CYCLES + 1
+ * calls. Lines of the page are broken by the table of layout_page(), so no
+ * character is measured twice. Returns XG_SPM_PAUSE when the page is full
+ * and the rest of the text is waiting for xg_next_page(), XG_SPM_STOP at the
+ * end of the text and XG_SPM_MORE otherwise.
+ */
 int
 xg_draw_speech(xg_canvas_t *canvas, xg_text_t *text)
 {
 	const xg_font_t *font = text->font;
-	const size_t text_len = strlen(text->text);
-	size_t drawn_len = text->drawn_len;
-	xg_point_t drawn_pt = text->drawn_pt;
-	xg_image_t glyph;
-	int glyph_idx;
-	int rc = XG_SPM_MORE;
+	xg_glyph_t glyph;
+	char c;
+
+	if (text->skip_cycles != SPEECH_DELAY_CYCLES) {
+		text->skip_cycles++;
+		return (text->line < text->lines_n) ? XG_SPM_MORE
+		    : ((get_char(text, text->drawn_len) == '\0') ? XG_SPM_STOP
+		    : XG_SPM_PAUSE);
+	}
 
-	if (drawn_len >= text_len) {
-		rc = XG_SPM_STOP;
+	/* Move the cursor to the next line at its break. */
+	while (text->line < text->lines_n &&
+	    text->drawn_len == text->breaks[text->line]) {
+		c = get_char(text, text->drawn_len);
+		if (c == ' ' || c == '\n') {
+			text->drawn_len++;
+		}
+		text->line++;
+		text->drawn_pt.x = 0;
+		text->drawn_pt.y = (int16_t)
+		    (text->drawn_pt.y + (int16_t) LINE_HEIGHT);
 	}
 
-	if (text->skip_cycles == SPEECH_DELAY_CYCLES && rc != XG_SPM_STOP) {
-		text->skip_cycles = 0;
+	if (text->line >= text->lines_n) {
+		return (get_char(text, text->drawn_len) == '\0') ? XG_SPM_STOP
+		    : XG_SPM_PAUSE;
+	}
 
-		/* Obtain an index of the current glyph. */
-		glyph_idx = text->text[drawn_len] - 0x20;
+	text->skip_cycles = 0;
+	c = get_char(text, text->drawn_len++);
 
-		/* Obtain the current glyph. */
-		glyph.alpha = NULL;
-		glyph.data = font->glyphs[glyph_idx].data;
-		glyph.width = font->glyphs[glyph_idx].width;
-		glyph.height = font->glyphs[glyph_idx].height;
-		glyph.data_size = font->glyphs[glyph_idx].data_size;
+	/* Draw the glyph, skip the missing ones and spaces out of the line. */
+	if (get_glyph(font, c, &glyph) == 0 &&
+	    text->drawn_pt.x + glyph.width <= (int16_t) canvas->width) {
+		draw_glyph(canvas, font, &glyph, text->drawn_pt);
+		text->drawn_pt.x = (int16_t)(text->drawn_pt.x + glyph.width);
+	}
+
+	return XG_SPM_MORE;
+}
+
+/*
+ * Turns the page of the paused speech: text of the previous page is cleared
+ * and the next one is laid out. Returns 1 if there's no more text.
+ */
+int
+xg_next_page(xg_canvas_t *canvas, xg_text_t *text)
+{
+	const uint16_t pages = (uint16_t)
+	    ((text->lines_n * LINE_HEIGHT + PHEIGHT - 1u) / PHEIGHT);
+
+	if (text->line < text->lines_n ||
+	    get_char(text, text->drawn_len) == '\0') {
+		return 1;
+	}
+
+	memset(canvas->data, 0x00, (size_t)(pages * canvas->width));
+	layout_page(canvas, text);
+
+	return 0;
+}
+
+/*
+ * Prints text on the canvas like xg_print() does, but the rendered text is
+ * kept in the cache (see XG_TEXT_CACHE_SLOTS). Text is looked up by a hash of
+ * its characters, the font and a vertical alignment to the canvas pages, so
+ * the same text drawn at the same rows of the pages is just copied from RAM.
+ * Text which doesn't fit a slot is drawn by xg_print().
+ */
+int
+xg_print_cached(xg_canvas_t *canvas, const xg_text_t *text, xg_point_t pt)
+{
+#if configXG_TEXT_CACHE_SZ > 0
+	const int16_t top_page = (int16_t)((pt.y >= 0) ? (pt.y / PHEIGHT)
+	    : -((PHEIGHT - 1 - pt.y) / PHEIGHT));
+	const uint8_t shift = (uint8_t)(pt.y - (top_page * PHEIGHT));
+	struct text_slot *slot = NULL;
+	uint32_t hash = 2166136261UL; /* FNV-1a */
+	char c;
+
+	for (size_t i = 0; (c = get_char(text, i)) != '\0'; i++) {
+		hash = (hash ^ (uint8_t) c) * 16777619UL;
+	}
 
-		/* Move cursor to a new line if needed. */
-		if (drawn_pt.x + (glyph.width > INT16_MAX
-		    ? 0 : (int16_t) glyph.width) > canvas->width) {
-			drawn_pt.x = 0;
-			drawn_pt.y += LINE_HEIGHT;
+	for (uint8_t i = 0; i < XG_TEXT_CACHE_SLOTS; i++) {
+		if (text_slots[i].font == text->font &&
+		    text_slots[i].hash == hash &&
+		    text_slots[i].shift == shift) {
+			slot = &text_slots[i];
+			break;
 		}
+	}
+	if (slot == NULL) {
+		slot = render_text(text, hash, shift);
+	}
+	if (slot == NULL) {
+		return xg_print(canvas, text, pt);
+	}
 
-		/* Draw the glyph. */
-		rc = xg_draw_pf(canvas, &glyph, drawn_pt);
-		if (rc != 0) {
-			/* break; */
+	slot->used = ++text_tick;
+	blit_text(canvas, slot, pt.x, top_page);
+
+	return 0;
+#else
+	return xg_print(canvas, text, pt);
+#endif
+}
+
+/*
+ * Prints the value on the canvas at the given coordinates, digits are aligned
+ * to the right of the field of the given width. Nothing is drawn in place of
+ * the leading spaces, the cursor is moved by a width of '0' only.
+ */
+int
+xg_print_uint(xg_canvas_t *canvas, const xg_text_t *text, xg_point_t pt,
+    uint16_t val, uint8_t width)
+{
+	const xg_font_t *font = text->font;
+	uint8_t digits[XG_UINT_DIGITS];
+	const uint8_t n = get_digits(val, digits);
+	const xg_glyph_t *glyph;
+	int rc = 0;
+
+	/* Look up glyphs of the digits once. */
+	if (digits_font != font) {
+		for (uint8_t i = 0; i < 10u; i++) {
+			if (get_glyph(font, (char)('0' + i),
+			    &digits_glyphs[i]) != 0) {
+				digits_glyphs[i].width = 0;
+			}
 		}
+		digits_font = font;
+	}
 
-		/* Move the text cursor forward. */
-		drawn_pt.x += glyph.width > INT16_MAX
-		    ? 0 : (int16_t) glyph.width;
-		drawn_len++;
+	for (; width > n; width--) {
+		pt.x += digits_glyphs[0].width;
+	}
 
-		text->drawn_pt = drawn_pt;
-		text->drawn_len = drawn_len;
-	} else if (rc != XG_SPM_STOP) {
-		text->skip_cycles++;
-	} else {
-		/* Nothing to do here. */
+	for (uint8_t i = 0; i < n && rc == 0; i++) {
+		glyph = &digits_glyphs[digits[i]];
+		if (glyph->width != 0u) {
+			rc = draw_glyph(canvas, font, glyph, pt);
+			pt.x += glyph->width;
+		}
+	}
+
+	return rc;
+}
+
+/*
+ * Writes digits of the value aligned to the right of the field of the given
+ * width (up to XG_UINT_DIGITS) by spaces. The buffer takes XG_UINT_BUFSZ
+ * characters at most. Returns a length of the string.
+ */
+size_t
+xg_fmt_uint(char *buf, uint16_t val, uint8_t width)
+{
+	uint8_t digits[XG_UINT_DIGITS];
+	const uint8_t n = get_digits(val, digits);
+	size_t len = 0;
+
+	if (width > XG_UINT_DIGITS) {
+		width = XG_UINT_DIGITS;
+	}
+	for (; width > n; width--) {
+		buf[len++] = ' ';
+	}
+	for (uint8_t i = 0; i < n; i++) {
+		buf[len++] = (char)('0' + digits[i]);
+	}
+	buf[len] = '\0';
+
+	return len;
+}
+
+/*
+ * Formats the text by the template in flash (see XG_UINT_DIGITS). The text is
+ * cut if it doesn't fit the buffer, 1 is returned in this case.
+ */
+int
+xg_format(xg_text_t *text, xg_str_t tmpl, const uint16_t *args)
+{
+	char *buf = text->text;
+	char num[XG_UINT_BUFSZ];
+	size_t len = 0, n;
+	uint8_t width;
+	char c;
+	int rc = 0;
+
+	while ((c = (char) PGM(ASSET_ADDR(tmpl++))) != '\0') {
+		if (c == '%') {
+			c = (char) PGM(ASSET_ADDR(tmpl++));
+			width = 0;
+			if (c >= '1' && c <= '5') {
+				width = (uint8_t)(c - '0');
+				c = (char) PGM(ASSET_ADDR(tmpl++));
+			}
+			if (c == 'u') {
+				n = xg_fmt_uint(num, *args++, width);
+				if (len + n >= text->text_sz) {
+					rc = 1;
+					break;
+				}
+				memcpy(&buf[len], num, n);
+				len += n;
+				continue;
+			} else if (c == '\0') {
+				break;
+			} else {
+				/* "%%" and the unknown ones are copied. */
+			}
+		}
+		if (len + 1u >= text->text_sz) {
+			rc = 1;
+			break;
+		}
+		buf[len++] = c;
 	}
+	buf[len] = '\0';
+	text->str = NULL;
 
 	return rc;
 }
@@ -171,111 +375,423 @@ xg_draw_speech(xg_canvas_t *canvas, xg_text_t *text)
 /*
  * Draws an image on a canvas at the given coordinates.
  *
+ * Image is drawn page by page: every byte of the image page lands on two
+ * canvas pages at most, i.e. the one with the top row of the image page and
+ * the next one if the image isn't aligned to the canvas pages. Columns are
+ * processed by runs of the alpha channel (see xg_alpha_t), neither alpha nor
+ * data bytes are read for the transparent ones. Opaque columns of the image
+ * aligned to the canvas pages are copied as they are: xlingc shifts images of
+ * the static layers to make them aligned.
+ *
+ * Image is mirrored horizontally if XG_DRAW_HFLIP is set in flags: bits of
+ * the page bytes stay as they are, only the order of columns is reversed.
+ *
+ * Blend mode of the flags is switched on once per run of the columns, every
+ * mode has its own loop over the bytes of the run. Only the images put as
+ * they are (XG_DRAW_REPLACE) have the aligned fast path.
+ *
  * NOTE: Image data should be located in the flash memory and will be accessed
  *       by a far (32-bit) pointer. Canvas data will be accessed directly.
  */
 int
-xg_draw_pf(xg_canvas_t *canvas, const xg_image_t *image, xg_point_t pt)
+xg_draw_pf(xg_canvas_t *canvas, const xg_image_t *image, xg_point_t pt,
+    uint8_t flags)
 {
-	uint16_t x, y;
-	uint16_t iw, ih;
-	uint16_t canvas_idx, img_idx;
-	uint8_t top_byte, img_byte, bottom_byte;
-	uint8_t raw_byte = 0, alpha_mask = 0xFF;
-	int rc = 0;
+	const int16_t canvas_pages = (int16_t)(canvas->height / PHEIGHT);
+	const uint16_t pages = (uint16_t)
+	    ((image->height + PHEIGHT - 1) / PHEIGHT);
+	/* Canvas page with the top row of the image and shift (in pixels). */
+	const int16_t top_page = (int16_t)((pt.y >= 0) ? (pt.y / PHEIGHT)
+	    : -((PHEIGHT - 1 - pt.y) / PHEIGHT));
+	const uint8_t shift = (uint8_t)(pt.y - (top_page * PHEIGHT));
+	const uint8_t flip = ((flags & XG_DRAW_HFLIP) != 0u);
+	const uint8_t blend = XG_DRAW_BLEND(flags);
+	const int16_t step = flip ? -1 : 1;
+	xg_addr_t ap = image->alpha;
+	xg_addr_t masks = NULL;
+	uint8_t *dest, *lo, *hi;
+	uint16_t x0, x1, row, col, len, start, end, dcol;
+	uint8_t run, kind = XG_AR_OPAQUE, valid, mask, data;
+	uint8_t inv = 0x00;
+	int16_t page;
+
+	/* Check coordinates. */
+	if (pt.x >= (int16_t) canvas->width ||
+	    pt.y >= (int16_t) canvas->height ||
+	    (pt.x + (int32_t) image->width) <= 0) {
+		return 1;
+	}
+
+	if (blend == XG_DRAW_INVERT) {
+		inv = 0xFF;
+	}
+
+	/* Columns of the image within the canvas. */
+	x0 = (pt.x < 0) ? (uint16_t)(-pt.x) : 0u;
+	x1 = ((pt.x + (int32_t) image->width) > canvas->width)
+	    ? (uint16_t)(canvas->width - pt.x) : image->width;
+	if (flip) {
+		/* Column j of the image is drawn at pt.x + width - 1 - j. */
+		col = x0;
+		x0 = (uint16_t)(image->width - x1);
+		x1 = (uint16_t)(image->width - col);
+	}
+
+	for (uint16_t i = 0; i < pages; i++) {
+		page = (int16_t)(top_page + (int16_t) i);
+		row = (uint16_t)(i * image->width);
+		if (page >= canvas_pages) {
+			/* The rest of the image is below the canvas. */
+			break;
+		}
 
-	CALC_AUX_POINT(&pt, image, x, y, img_idx, iw, ih);
+		/* Rows of the last image page might be partially valid. */
+		valid = ((image->height - (i * PHEIGHT)) >= PHEIGHT) ? 0xFFu
+		    : (uint8_t)((1u << (image->height - (i * PHEIGHT))) - 1u);
 
-	/* Size of the visible image part */
-	iw = ((x + iw) > canvas->width) ? iw - ((x + iw) - canvas->width) : iw;
-	ih = ((y + ih) > canvas->height) ? ih - ((y + ih) - canvas->height) : ih;
+		/* Canvas pages the shifted bytes are split between. */
+		lo = (page >= 0) ? &canvas->data[(uint16_t) page *
+		    canvas->width] : NULL;
+		hi = (shift != 0u && (page + 1) < canvas_pages) ?
+		    &canvas->data[(uint16_t)(page + 1) * canvas->width] : NULL;
 
-	/* Canvas pages to modify */
-	const uint16_t start_page = (y / PHEIGHT) > PAGES ? PAGES : y / PHEIGHT;
-	uint16_t end_page = (y + ih + PHEIGHT - 1) / PHEIGHT;
+		for (col = 0; col < image->width; col = (uint16_t)(col + len)) {
+			/* Obtain the next run of columns. */
+			if (ap == NULL) {
+				kind = XG_AR_OPAQUE;
+				len = image->width;
+			} else if (image->alpha_type == XG_AT_PLANE) {
+				kind = XG_AR_MASK;
+				len = image->width;
+				masks = &ap[row];
+			} else {
+				run = IMG(image, ap);
+				kind = (uint8_t) XG_AR_KIND(run);
+				len = XG_AR_LEN(run);
+				masks = ap + 1;
+				ap = (kind == XG_AR_MASK) ? (masks + len)
+				    : masks;
+			}
+
+			/* Skip invisible parts of the image. */
+			if (kind == XG_AR_TRANSPARENT || page < -1 ||
+			    (page == -1 && shift == 0u)) {
+				continue;
+			}
 
-	/* Shifts (in pixels) */
-	const uint8_t shift = y % PHEIGHT;
-	const uint8_t bottom_shift = (((y + ih) % PHEIGHT) != 0)
-	        ? (uint8_t)(PHEIGHT - ((y + ih) % PHEIGHT)) : 0u;
+			start = (col > x0) ? col : x0;
+			end = ((col + len) < x1) ? (uint16_t)(col + len) : x1;
+			if (kind == XG_AR_OPAQUE && valid == 0xFFu &&
+			    shift == 0u && start < end &&
+			    blend == XG_DRAW_REPLACE) {
+				/* Aligned fast path. */
+				if (flip) {
+					dest = &canvas->data[((uint16_t) page *
+					    canvas->width) + (uint16_t)(pt.x +
+					    (int16_t)(image->width - end))];
+					for (uint16_t j = start; j < end; j++) {
+						dest[end - 1u - j] = IMG(image,
+						    &image->data[row + j]);
+					}
+					continue;
+				}
+				dest = &canvas->data[((uint16_t) page *
+				    canvas->width) + (uint16_t)(pt.x + start)];
+				if (image->in_ram) {
+					memcpy(dest, RAM_PTR(
+					    &image->data[row + start]),
+					    end - start);
+				} else {
+					memcpy_PF(dest, ASSET_ADDR(
+					    &image->data[row + start]),
+					    end - start);
+				}
+				continue;
+			}
+			if (start >= end) {
+				continue;
+			}
 
-	/* Pixel masks */
-	const uint8_t mask = (uint8_t)(0xFFu << shift);
-	const uint8_t bottom_mask = (uint8_t)(0xFFu >> bottom_shift);
-	const uint8_t img_mask = (uint8_t)(mask & bottom_mask);
+			/* Column of the canvas for the first byte. */
+			dcol = (uint16_t)(pt.x + (int16_t)(flip ?
+			    (image->width - 1u - start) : start));
 
-	/* Check indexes of the pages. */
-	if ((start_page > (PAGES - 1)) || (end_page > PAGES)) {
-		end_page = 0;
-		rc = 1;
+			switch (blend) {
+			case XG_DRAW_OR:
+				for (uint16_t j = start; j < end; j++) {
+					mask = (kind != XG_AR_MASK) ? valid :
+					    (uint8_t)(IMG(image,
+					    &masks[j - col]) & valid);
+					data = (uint8_t)(IMG(image,
+					    &image->data[row + j]) & mask);
+					if (lo != NULL) {
+						lo[dcol] |= (uint8_t)
+						    (data << shift);
+					}
+					if (hi != NULL) {
+						hi[dcol] |= (uint8_t)
+						    (data >> (PHEIGHT - shift));
+					}
+					dcol = (uint16_t)(dcol + step);
+				}
+				break;
+			case XG_DRAW_CLEAR:
+				for (uint16_t j = start; j < end; j++) {
+					mask = (kind != XG_AR_MASK) ? valid :
+					    (uint8_t)(IMG(image,
+					    &masks[j - col]) & valid);
+					data = (uint8_t)(IMG(image,
+					    &image->data[row + j]) & mask);
+					if (lo != NULL) {
+						lo[dcol] &= NOT(data << shift);
+					}
+					if (hi != NULL) {
+						hi[dcol] &= NOT(data >>
+						    (PHEIGHT - shift));
+					}
+					dcol = (uint16_t)(dcol + step);
+				}
+				break;
+			case XG_DRAW_XOR:
+				for (uint16_t j = start; j < end; j++) {
+					mask = (kind != XG_AR_MASK) ? valid :
+					    (uint8_t)(IMG(image,
+					    &masks[j - col]) & valid);
+					data = (uint8_t)(IMG(image,
+					    &image->data[row + j]) & mask);
+					if (lo != NULL) {
+						lo[dcol] ^= (uint8_t)
+						    (data << shift);
+					}
+					if (hi != NULL) {
+						hi[dcol] ^= (uint8_t)
+						    (data >> (PHEIGHT - shift));
+					}
+					dcol = (uint16_t)(dcol + step);
+				}
+				break;
+			default:
+				/* Put the bytes, inverted by XG_DRAW_INVERT. */
+				for (uint16_t j = start; j < end; j++) {
+					mask = (kind != XG_AR_MASK) ? valid :
+					    (uint8_t)(IMG(image,
+					    &masks[j - col]) & valid);
+					put_img_byte(canvas, page, dcol, shift,
+					    (uint8_t)(IMG(image,
+					    &image->data[row + j]) ^ inv),
+					    mask);
+					dcol = (uint16_t)(dcol + step);
+				}
+				break;
+			}
+		}
 	}
+
+	return 0;
+}
+
+/*
+ * Draws a tile map on a canvas at the given coordinates.
+ *
+ * Every page of the tile map is emitted as straight copies of the tile
+ * columns: the first and the last tiles might be partially visible (the map
+ * is scrolled by a part of a tile or clipped by the canvas), the ones between
+ * them are copied as whole 8-byte tiles. A map which isn't aligned to the
+ * display pages vertically is put byte by byte and shifted like an image (see
+ * xg_draw_pf()), it's slower but the layer is drawn at any y coordinate.
+ *
+ * NOTE: Tiles and map should be located in the flash memory.
+ */
+int
+xg_draw_tilemap(xg_canvas_t *canvas, const xg_tilemap_t *tm, xg_point_t pt)
+{
+	const int16_t canvas_pages = (int16_t)(canvas->height / PHEIGHT);
+	const int32_t width = (int32_t) tm->width * XG_TILE_WIDTH;
+	const int16_t top_page = (int16_t)((pt.y >= 0) ? (pt.y / PHEIGHT)
+	    : -((PHEIGHT - 1 - pt.y) / PHEIGHT));
+	const uint8_t shift = (uint8_t)(pt.y - (top_page * PHEIGHT));
+	uint16_t x0, x1, col, wx, len;
+	uint8_t *dest;
+	uint8_t tile;
+	int16_t page;
+	uint_farptr_t src;
+
 	/* Check coordinates. */
-	if ((x > (canvas->width - 1)) || (y > (canvas->height - 1))) {
-		end_page = 0;
-		rc = 1;
+	if (pt.x >= (int16_t) canvas->width ||
+	    pt.y >= (int16_t) canvas->height || (pt.x + width) <= 0) {
+		return 1;
 	}
 
-	/* An image drawing loop. */
-	for (uint16_t i = start_page; i < end_page; i++) {
-		/* Calculate index for the current line in canvas. */
-		canvas_idx = (i * canvas->width) + x;
+	/* Columns of the canvas covered by the tile map. */
+	x0 = (pt.x < 0) ? 0u : (uint16_t) pt.x;
+	x1 = ((pt.x + width) > canvas->width)
+	    ? canvas->width : (uint16_t)(pt.x + width);
 
-		/* Draw the current line. */
-		for (uint16_t j = canvas_idx; j < (canvas_idx + iw); j++) {
-			/* Data byte at the "top" of the current one. */
-			if (i == start_page && img_idx < image->width) {
-				top_byte = (canvas->data[j] & NOT(mask));
-			} else {
-				get_img_byte(image, img_idx - image->width,
-				    &raw_byte, &alpha_mask);
-
-				top_byte  = canvas->data[j]
-				    & NOT(mask)
-				    & NOT((alpha_mask >> (PHEIGHT - shift))
-					& NOT(mask));
-				top_byte |= (uint8_t)((raw_byte & alpha_mask)
-				    >> (PHEIGHT - shift));
+	for (uint16_t i = 0; i < tm->height; i++) {
+		page = (int16_t)(top_page + (int16_t) i);
+		if (page < -1 || (page < 0 && shift == 0u)) {
+			continue;
+		} else if (page >= canvas_pages) {
+			/* The rest of the map is below the canvas. */
+			break;
+		}
+
+		if (shift != 0u) {
+			/* Split every byte between two canvas pages. */
+			for (col = x0; col < x1; col++) {
+				wx = (uint16_t)(col - pt.x);
+				tile = PGM(ASSET_ADDR(&tm->map[(i *
+				    tm->width) + (wx / XG_TILE_WIDTH)]));
+				src = ASSET_ADDR(&tm->tiles[(tile *
+				    XG_TILE_WIDTH) + (wx % XG_TILE_WIDTH)]);
+				put_img_byte(canvas, page, col, shift,
+				    PGM(src), 0xFF);
 			}
-			/* Byte with the current image data. */
-			if (i == (end_page - 1)) {
-				/* Image data at the end of the image. */
-				get_img_byte(image, img_idx, &raw_byte,
-				    &alpha_mask);
-
-				img_byte = canvas->data[j]
-				    & mask & NOT((alpha_mask << shift) & mask);
-				img_byte = (uint8_t)(img_byte | ((img_mask != 0)
-				    ? ((raw_byte & alpha_mask) << shift) : 0));
+			continue;
+		}
+
+		dest = &canvas->data[(uint16_t) page * canvas->width];
+
+		for (col = x0; col < x1; col = (uint16_t)(col + len)) {
+			wx = (uint16_t)(col - pt.x);
+			len = (uint16_t)(XG_TILE_WIDTH - (wx % XG_TILE_WIDTH));
+			len = ((col + len) > x1) ? (uint16_t)(x1 - col) : len;
+			tile = PGM(ASSET_ADDR(&tm->map[(i * tm->width) +
+			    (wx / XG_TILE_WIDTH)]));
+			memcpy_PF(&dest[col], ASSET_ADDR(&tm->tiles[(tile *
+			    XG_TILE_WIDTH) + (wx % XG_TILE_WIDTH)]), len);
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Fills a rectangle on the canvas page by page. Whole bytes of the pages
+ * covered by the rectangle entirely are filled at once, the top and the bottom
+ * pages are masked. Returns 1 if the rectangle is out of the canvas.
+ */
+int
+xg_fill_rect(xg_canvas_t *canvas, xg_point_t pt, uint16_t w, uint16_t h,
+    xg_fill_t mode)
+{
+	const int16_t x0 = (pt.x < 0) ? 0 : pt.x;
+	const int16_t y0 = (pt.y < 0) ? 0 : pt.y;
+	int32_t x1 = (int32_t) pt.x + (int32_t) w;
+	int32_t y1 = (int32_t) pt.y + (int32_t) h;
+	int16_t top, bottom;
+	uint16_t n;
+	uint8_t *dest, mask, top_mask, bottom_mask;
+
+	/* Clamp the far corner before it's narrowed. */
+	x1 = (x1 > (int32_t) canvas->width) ? (int32_t) canvas->width : x1;
+	y1 = (y1 > (int32_t) canvas->height) ? (int32_t) canvas->height : y1;
+	if ((int32_t) x0 >= x1 || (int32_t) y0 >= y1) {
+		return 1;
+	}
+	n = (uint16_t)(x1 - x0);
+	top = (int16_t)(y0 / PHEIGHT);
+	bottom = (int16_t)((y1 - 1) / PHEIGHT);
+	top_mask = (uint8_t)(0xFFu << (y0 - (top * PHEIGHT)));
+	bottom_mask = (uint8_t)(0xFFu >> (((bottom + 1) * PHEIGHT) - y1));
+
+	for (int16_t page = top; page <= bottom; page++) {
+		mask = 0xFF;
+		if (page == top) {
+			mask &= top_mask;
+		}
+		if (page == bottom) {
+			mask &= bottom_mask;
+		}
+		dest = &canvas->data[((uint16_t) page * canvas->width) +
+		    (uint16_t) x0];
+
+		switch (mode) {
+		case XG_FILL_SET:
+			if (mask == 0xFFu) {
+				memset(dest, 0xFF, n);
 			} else {
-				/* Image data somewhere before end. */
-				get_img_byte(image, img_idx, &raw_byte,
-				    &alpha_mask);
-
-				img_byte = canvas->data[j]
-				    & mask & NOT((alpha_mask << shift) & mask);
-				img_byte |= (uint8_t)((raw_byte & alpha_mask)
-				    << shift);
+				for (uint16_t i = 0; i < n; i++) {
+					dest[i] |= mask;
+				}
 			}
-			/* Data byte at the "bottom" of the current one. */
-			if (i == (end_page - 1)) {
-				bottom_byte = (uint8_t)
-				    (canvas->data[j] & NOT(bottom_mask));
+			break;
+		case XG_FILL_CLEAR:
+			if (mask == 0xFFu) {
+				memset(dest, 0x00, n);
 			} else {
-				bottom_byte = 0;
+				mask = (uint8_t) ~mask;
+				for (uint16_t i = 0; i < n; i++) {
+					dest[i] &= mask;
+				}
+			}
+			break;
+		case XG_FILL_XOR:
+			for (uint16_t i = 0; i < n; i++) {
+				dest[i] ^= mask;
 			}
+			break;
+		default:
+			/* Shouldn't reach here. */
+			break;
+		}
+	}
+
+	return 0;
+}
+
+/* Draws a horizontal line of the given width. */
+int
+xg_hline(xg_canvas_t *canvas, xg_point_t pt, uint16_t w, xg_fill_t mode)
+{
+	return xg_fill_rect(canvas, pt, w, 1, mode);
+}
+
+/* Draws a vertical line of the given height. */
+int
+xg_vline(xg_canvas_t *canvas, xg_point_t pt, uint16_t h, xg_fill_t mode)
+{
+	return xg_fill_rect(canvas, pt, 1, h, mode);
+}
+
+/*
+ * Draws a frame of the rectangle. Corners are drawn once, so the frame can be
+ * inverted (XG_FILL_XOR) as well.
+ */
+int
+xg_frame(xg_canvas_t *canvas, xg_point_t pt, uint16_t w, uint16_t h,
+    xg_fill_t mode)
+{
+	xg_point_t side = { pt.x, (int16_t)(pt.y + 1) };
+	int rc = 1;
 
-			/* Update byte on the canvas. */
-			canvas->data[j] = top_byte | img_byte | bottom_byte;
+	if (w == 0u || h == 0u) {
+		return rc;
+	}
 
-			/* Increment image index. */
-			img_idx++;
+	rc &= xg_hline(canvas, pt, w, mode);
+	if (h > 1u) {
+		pt.y = clamp_coord((int32_t) pt.y + (int32_t) h - 1);
+		rc &= xg_hline(canvas, pt, w, mode);
+	}
+	if (h > 2u) {
+		rc &= xg_vline(canvas, side, (uint16_t)(h - 2u), mode);
+		if (w > 1u) {
+			side.x = clamp_coord((int32_t) side.x + (int32_t) w - 1);
+			rc &= xg_vline(canvas, side, (uint16_t)(h - 2u), mode);
 		}
-		/* Move to the "next line" on the image. */
-		img_idx += image->width - iw;
 	}
+
 	return rc;
 }
 
+/* Inverts pixels of the rectangle, e.g. a selection of the menu. */
+int
+xg_invert_rect(xg_canvas_t *canvas, xg_point_t pt, uint16_t w, uint16_t h)
+{
+	return xg_fill_rect(canvas, pt, w, h, XG_FILL_XOR);
+}
+
 void
 xg_transfer_canvas(MSIM_SH1106_t *display, const xg_canvas_t *canvas)
 {
@@ -292,141 +808,1047 @@ xg_transfer_canvas(MSIM_SH1106_t *display, const xg_canvas_t *canvas)
 	}
 }
 
+/*
+ * Executes the draw list of the scene. Static operations at the start of it
+ * are restored from the cache canvas, they're drawn into it first if the
+ * cache is empty or any of them has been moved.
+ *
+ * Descriptors of the scene, draw list and animations are read from flash by
+ * far pointers, only offsets of the groups and states of the animations are
+ * changed in RAM.
+ */
 int
 xg_draw_scene(xg_canvas_t *canvas, const xg_scene_t *scene)
 {
-	const xg_layer_t *layer;
-	const xg_anim_frame_t *frames;
-	const xg_anim_frame_t *frame;
-	xg_anim_t *anim;
-	uint16_t rnd;
-	uint16_t cache_idx;
-
-	for (uint16_t i = scene->layers_n; i >= 1; i--) {
-		layer = &scene->layers[i - 1];
-		cache_idx = scene->layers_n - i; /* [0, layers_n - 1] */
-
-		switch (layer->obj_type) {
-		case XG_OT_IMG:
-			if (cache_canvas != NULL &&
-			    cached_layers >= (cache_idx + 1) &&
-			    cache_pts[cache_idx].x == layer->base_pt.x &&
-			    cache_pts[cache_idx].y == layer->base_pt.y) {
-				/* Skip cached layer */
-				continue;
-			} else {
-				xg_draw_pf(canvas, (const xg_image_t *)
-				    layer->obj, layer->base_pt);
-
-				/* Invalidate previously cached canvas */
-				if (cache_state == CACHE_VALID) {
-					cache_state = CACHE_INVALID;
-					cached_layers = 0;
-				}
+	xg_scene_t scn;
+	xg_draw_op_t op;
+	uint16_t i = 0;
 
-				/* Cache this layer */
-				if (cache_canvas != NULL) {
-					cached_layers++;
-					cache_pts[cache_idx] = layer->base_pt;
-				}
-			}
-			break;
-		case XG_OT_ANIM:
-			anim = (xg_anim_t *) layer->obj;
-			frames = (const xg_anim_frame_t *) anim->frames;
-			frame = &frames[anim->frame_idx];
-
-			/* Update cache state */
-			if (cache_canvas != NULL &&
-			    cached_layers == cache_idx &&
-			    cache_state == CACHE_INVALID) {
-				copy_canvas(cache_canvas, canvas);
-				cache_state = CACHE_VALID;
-			}
+	xg_get_scene(scene, &scn);
 
-			/* Restore canvas from cache */
-			if (cache_canvas != NULL &&
-			    cached_layers == cache_idx &&
-			    cache_state == CACHE_VALID) {
-				copy_canvas(canvas, cache_canvas);
-			}
+	if (cache_canvas != NULL && scn.cached_n > 0u) {
+		if (!is_cached(scene, &scn)) {
+			cache_ops(scene, &scn);
+		}
+		copy_canvas(canvas, cache_canvas);
+		i = scn.cached_n;
+	}
 
-			/* Don't draw an inactive animation. */
-			if (anim->active == 0) {
-				break;
-			}
+	for (; i < scn.ops_n; i++) {
+		memcpy_PF(&op, PGM_ADDR(&scn.ops[i]), sizeof(op));
+		draw_op(canvas, &op, get_group_offset(&scn, op.group));
+	}
 
-			/* Draw the current frame. */
-			xg_draw_pf(canvas, frame->img, frame->base_pt);
+	return 0;
+}
 
-			/* Choose the next frame index. */
-			if (anim->stay_cnt == 0u) {
-				if (frame->alt_chance > 0) {
-					rnd = (uint16_t)
-					    (1 + rand() / ((RAND_MAX + 1u) / 100));
+/* Reads the scene descriptor from flash. */
+void
+xg_get_scene(const xg_scene_t *scene, xg_scene_t *buf)
+{
+	memcpy_PF(buf, PGM_ADDR(scene), sizeof(*buf));
+}
 
-					if (rnd <= frame->alt_chance) {
-						anim->frame_idx = frame->alt;
-					} else {
-						anim->frame_idx++;
-					}
-					anim->frame_idx =
-					    anim->frame_idx >= anim->frames_n
-					    ? 0 : anim->frame_idx;
+/*
+ * Initializes RAM of the scene: offsets of the groups, the pan, states of the
+ * animations and variables of the script. Cached background of the previous
+ * scene is dropped.
+ */
+void
+xg_enter_scene(const xg_scene_t *scene)
+{
+	xg_scene_t scn;
+	xg_draw_op_t op;
+	xg_anim_t anim;
 
-					/* Update stay counter. */
-					anim->stay_cnt =
-					    frames[anim->frame_idx].stay;
-				} else {
-					/* No chance to use an alternative frame. */
-					anim->frame_idx++;
-					anim->frame_idx =
-					    anim->frame_idx >= anim->frames_n
-					    ? 0 : anim->frame_idx;
-
-					/* Update stay counter. */
-					anim->stay_cnt =
-					    frames[anim->frame_idx].stay;
-				}
-			} else {
-				anim->stay_cnt--;
-			}
+	xg_get_scene(scene, &scn);
+	memset(scn.offsets, 0, scn.groups_n * sizeof(scn.offsets[0]));
+	memset(scn.pan, 0, sizeof(*scn.pan));
 
-			break;
-		default:
-			/* Other object types can't be painted at the moment. */
-			break;
+	for (uint16_t i = 0; i < scn.ops_n; i++) {
+		memcpy_PF(&op, PGM_ADDR(&scn.ops[i]), sizeof(op));
+		if (op.obj_type != XG_OT_ANIM) {
+			continue;
 		}
+		memcpy_PF(&anim, PGM_ADDR(op.obj), sizeof(anim));
+		anim.state->frame_idx = 0;
+		anim.state->stay_cnt = 0;
+		anim.state->work_idx = XG_AW_NONE;
+		anim.state->alt_flip = 0;
+		anim.state->active = anim.active;
+		anim.state->loop_cnt = 0;
+	}
+	if (scn.script != NULL) {
+		memcpy_PF(scn.vars, PGM_ADDR(scn.script + 1), SC(scn.script));
 	}
 
-	return 0;
+	/* Seed the generator of the animations, it mustn't be zero. */
+	anim_rnd = (uint16_t)((unsigned int) rand() | 1u);
+	cache_scene = NULL;
 }
 
 /*
- * Provides an additional canvas to cache parts of a scene which might not
- * be changed, i.e. static images.
+ * Enters the scene of the registry and starts a transition to it. The scene is
+ * entered immediately if its background can't be cached.
  */
 int
-xg_cache_canvas(xg_canvas_t *canvas)
+xg_switch_scene(xg_scene_ctx_t *ctx, uint16_t idx)
 {
-	cache_canvas = canvas;
-	cached_layers = 0;
+	const xg_scene_t *scene;
+	xg_scene_t scn;
+
+	if (idx >= ctx->scenes_n) {
+		return 1;
+	}
+	memcpy_PF(&scene, PGM_ADDR(&ctx->scenes[idx]), sizeof(scene));
+
+	xg_enter_scene(scene);
+	ctx->scene = scene;
+	ctx->scene_idx = idx;
+	ctx->scene_mode = XG_SM_SCENE;
+	ctx->btn_stat = XM_BTN_NONE; /* Callbacks reset their state. */
+
+	/* Draw static background of the scene into the cache. */
+	xg_get_scene(scene, &scn);
+	if (cache_canvas != NULL && scn.cached_n > 0u) {
+		cache_ops(scene, &scn);
+		xg_start_transition(ctx, XG_TR_SLIDE);
+	}
+
 	return 0;
 }
 
-static void
-get_img_byte(const xg_image_t * const image, const uint32_t idx,
-    uint8_t *data, uint8_t *alpha)
+/*
+ * Starts the transition from the canvas to the cached background of the
+ * scene. The scene is just drawn as usual if its background isn't cached,
+ * 1 is returned in this case.
+ */
+int
+xg_start_transition(xg_scene_ctx_t *ctx, xg_trans_t trans)
 {
-	if (image->alpha == NULL) {
-		/* Simple monochrome image. */
-		(*data) = PGM(&image->data[idx]);
-		(*alpha) = 0xFF;
-	} else {
-		/* Monochrome image with 1-bit alpha channel. */
-		(*data) = PGM(&image->data[idx]);
-		(*alpha) = PGM(&image->alpha[idx]);
+	if (cache_canvas == NULL || cache_scene != ctx->scene) {
+		ctx->scene_mode = XG_SM_SCENE;
+		return 1;
+	}
+
+	ctx->trans = (uint8_t) trans;
+	ctx->trans_step = 0;
+	ctx->scene_mode = XG_SM_TRANSITION;
+
+	return 0;
+}
+
+/*
+ * Makes a step of the transition to the cached background of the scene. None
+ * of the steps takes more than a pass over the canvas.
+ */
+int
+xg_draw_transition(xg_canvas_t *canvas, xg_scene_ctx_t *ctx)
+{
+	const uint16_t pages = (uint16_t)(canvas->height / PHEIGHT);
+	const uint16_t step = ctx->trans_step;
+	uint8_t *dest;
+	const uint8_t *src;
+	uint16_t end;
+	uint8_t done, masks[4];
+
+	if (cache_canvas == NULL || cache_scene != ctx->scene) {
+		ctx->scene_mode = XG_SM_SCENE;
+		ctx->contrast = XG_CONTRAST;
+		return 1;
+	}
+
+	switch (ctx->trans) {
+	case XG_TR_SLIDE:
+		/* Move the canvas to the left, the background follows it. */
+		end = (uint16_t)(step + XG_TR_STEP);
+		end = (end > canvas->width) ? canvas->width : end;
+		for (uint16_t i = 0; i < pages; i++) {
+			dest = &canvas->data[i * canvas->width];
+			memmove(dest, &dest[end - step], canvas->width - end);
+			memcpy(&dest[canvas->width - end],
+			    &cache_canvas->data[i * canvas->width], end);
+		}
+		ctx->trans_step = end;
+		done = (end == canvas->width);
+		break;
+	case XG_TR_DISSOLVE:
+		/* Take pixels of the background under the dither mask. */
+		end = (uint16_t)(step + XG_TR_DITHER_STEP);
+		end = (end > 16u) ? 16u : end;
+		for (uint8_t i = 0; i < 4u; i++) {
+			masks[i] = 0;
+			for (uint8_t j = 0; j < PHEIGHT; j++) {
+				masks[i] |= (uint8_t)((PGM(PGM_ADDR(
+				    &DITHER[i][j % 4u])) < end) << j);
+			}
+		}
+		for (uint16_t i = 0; i < pages; i++) {
+			dest = &canvas->data[i * canvas->width];
+			src = &cache_canvas->data[i * canvas->width];
+			for (uint16_t j = 0; j < canvas->width; j++) {
+				dest[j] = (uint8_t)((dest[j] &
+				    NOT(masks[j % 4u])) |
+				    (src[j] & masks[j % 4u]));
+			}
+		}
+		ctx->trans_step = end;
+		done = (end == 16u);
+		break;
+	case XG_TR_FADE:
+		/* Swap the canvas at the darkest step of the contrast. */
+		if (step < XG_TR_FADE_STEPS) {
+			ctx->contrast = (uint8_t)((XG_CONTRAST *
+			    (XG_TR_FADE_STEPS - 1u - step)) / XG_TR_FADE_STEPS);
+		} else {
+			if (step == XG_TR_FADE_STEPS) {
+				copy_canvas(canvas, cache_canvas);
+			}
+			ctx->contrast = (uint8_t)((XG_CONTRAST *
+			    (step + 1u - XG_TR_FADE_STEPS)) / XG_TR_FADE_STEPS);
+		}
+		ctx->trans_step = (uint16_t)(step + 1u);
+		done = (ctx->trans_step == 2u * XG_TR_FADE_STEPS);
+		break;
+	default:
+		/* Replace the next XG_TR_STEP columns by the background. */
+		end = (uint16_t)(step + XG_TR_STEP);
+		end = (end > canvas->width) ? canvas->width : end;
+		for (uint16_t i = 0; i < pages; i++) {
+			memcpy(&canvas->data[(i * canvas->width) + step],
+			    &cache_canvas->data[(i * canvas->width) + step],
+			    end - step);
+		}
+		ctx->trans_step = end;
+		done = (end == canvas->width);
+		break;
+	}
+
+	if (done != 0u) {
+		ctx->scene_mode = XG_SM_SCENE;
+		ctx->contrast = XG_CONTRAST;
+	}
+
+	return 0;
+}
+
+/*
+ * Runs the handler of the last keyboard event from the bytecode of the scene
+ * (if any). Scripts don't run while the scene is being switched.
+ */
+void
+xg_run_script(xg_scene_ctx_t *ctx)
+{
+	xg_scene_t scn;
+	const uint8_t *pc;
+	uint8_t ev;
+
+	xg_get_scene(ctx->scene, &scn);
+	if (scn.script == NULL || ctx->scene_mode == XG_SM_TRANSITION) {
+		return;
+	}
+
+	/* Skip the variables and look for the handler. */
+	pc = scn.script + 1 + SC(scn.script);
+	while ((ev = SC(pc)) != 0u) {
+		if (ev == (uint8_t) ctx->btn_stat) {
+			run_handler(ctx, &scn, pc + 2, pc + 2 + SC(pc + 1));
+			break;
+		}
+		pc += 2 + SC(pc + 1);
+	}
+}
+
+/* Starts the speech of the text in flash. */
+void
+xg_say(xg_scene_ctx_t *ctx, xg_str_t str)
+{
+	xg_text_t *text = ctx->text;
+
+	text->str = str;
+	text->drawn_len = 0;
+	layout_page(ctx->canvas, text);
+	ctx->scene_mode = XG_SM_SPEECH;
+}
+
+/* Reads a string of the table in PROGMEM. */
+xg_str_t
+xg_get_str(const xg_str_t *table, uint16_t idx)
+{
+	xg_str_t str;
+
+	memcpy_PF(&str, PGM_ADDR(&table[idx]), sizeof(str));
+
+	return str;
+}
+
+/* Provides a state of the animation layer or NULL for the other layers. */
+xg_anim_state_t *
+xg_get_anim_state(const xg_scene_t *scene, uint16_t layer)
+{
+	xg_scene_t scn;
+	xg_draw_op_t op;
+	xg_anim_t anim;
+
+	xg_get_scene(scene, &scn);
+	if (layer >= scn.ops_n) {
+		return NULL;
+	}
+	memcpy_PF(&op, PGM_ADDR(&scn.ops[scn.ops_n - 1u - layer]), sizeof(op));
+	if (op.obj_type != XG_OT_ANIM) {
+		return NULL;
+	}
+	memcpy_PF(&anim, PGM_ADDR(op.obj), sizeof(anim));
+
+	return anim.state;
+}
+
+/*
+ * Reads a frame of the animation layer from flash. Base point of the frame
+ * doesn't include the offset of the layer's group.
+ */
+int
+xg_get_anim_frame(const xg_scene_t *scene, uint16_t layer, uint16_t frame,
+    xg_anim_frame_t *buf)
+{
+	xg_scene_t scn;
+	xg_draw_op_t op;
+	xg_anim_t anim;
+
+	xg_get_scene(scene, &scn);
+	if (layer >= scn.ops_n) {
+		return 1;
+	}
+	memcpy_PF(&op, PGM_ADDR(&scn.ops[scn.ops_n - 1u - layer]), sizeof(op));
+	if (op.obj_type != XG_OT_ANIM) {
+		return 1;
+	}
+	memcpy_PF(&anim, PGM_ADDR(op.obj), sizeof(anim));
+	if (frame >= anim.frames_n) {
+		return 1;
+	}
+	memcpy_PF(buf, PGM_ADDR(&anim.frames[frame]), sizeof(*buf));
+
+	return 0;
+}
+
+/*
+ * Provides an additional canvas to cache parts of a scene which might not
+ * be changed, i.e. static images.
+ */
+int
+xg_cache_canvas(xg_canvas_t *canvas)
+{
+	cache_canvas = canvas;
+	cache_scene = NULL;
+	return 0;
+}
+
+/*
+ * Puts a byte of the image page on the canvas. Only pixels set in the mask are
+ * modified. The byte is split between two canvas pages if it's shifted.
+ */
+static void
+put_img_byte(xg_canvas_t *canvas, int16_t page, uint16_t col, uint8_t shift,
+    uint8_t data, uint8_t mask)
+{
+	uint8_t *dest;
+
+	data &= mask;
+
+	if (page >= 0) {
+		dest = &canvas->data[((uint16_t) page * canvas->width) + col];
+		if (mask == 0xFFu && shift == 0u) {
+			/* Opaque byte aligned to the canvas page. */
+			(*dest) = data;
+			return;
+		}
+		(*dest) = (uint8_t)(((*dest) & NOT(mask << shift)) |
+		    (data << shift));
+	}
+
+	if (shift != 0u &&
+	    ((uint16_t)(page + 1) * PHEIGHT) < canvas->height) {
+		dest = &canvas->data[((uint16_t)(page + 1) * canvas->width) +
+		    col];
+		(*dest) = (uint8_t)(((*dest) & NOT(mask >> (PHEIGHT - shift))) |
+		    (data >> (PHEIGHT - shift)));
+	}
+}
+
+/*
+ * Narrows a coordinate computed in 32 bits. Coordinates beyond the int16_t
+ * range are out of any canvas, they're clamped to stay out of it.
+ */
+static int16_t
+clamp_coord(int32_t v)
+{
+	if (v > INT16_MAX) {
+		return INT16_MAX;
+	} else if (v < INT16_MIN) {
+		return INT16_MIN;
+	}
+
+	return (int16_t) v;
+}
+
+/*
+ * Provides an image of the current animation frame. Deltas of the frames since
+ * the last key frame are applied to the work image if the previous frame of
+ * the path isn't there, i.e. the current one is reached by a jump. Descriptor
+ * of the image is read from flash into the buffer.
+ */
+static const xg_image_t *
+get_frame_img(const xg_anim_t *anim, const xg_anim_frame_t *frame,
+    xg_image_t *buf)
+{
+	xg_anim_state_t *state = anim->state;
+	const uint16_t idx = state->frame_idx;
+	xg_work_t work;
+	uint16_t i = idx;
+
+	if (frame->delta == NULL) {
+		memcpy_PF(buf, PGM_ADDR(frame->img), sizeof(*buf));
+		return buf;
+	}
+	memcpy_PF(&work, PGM_ADDR(anim->work), sizeof(work));
+	buf->data = work.data;
+	buf->alpha = work.alpha;
+	buf->width = work.width;
+	buf->height = work.height;
+	buf->data_size = 8;
+	buf->alpha_type = XG_AT_PLANE;
+	buf->in_ram = 1;
+
+	if (state->work_idx != idx) {
+		if (state->work_idx == XG_AW_NONE ||
+		    (state->work_idx + 1u) != idx) {
+			/* Look for the key frame. */
+			while (i > 0 && (PGM(ASSET_ADDR(get_frame_delta(anim,
+			    i))) & XG_DF_KEY) == 0u) {
+				i--;
+			}
+		}
+		for (; i <= idx; i++) {
+			apply_delta(&work, get_frame_delta(anim, i));
+		}
+		state->work_idx = idx;
+	}
+
+	return buf;
+}
+
+/*
+ * Calculates an offset of the layers of the group: its own offset and the pan
+ * of the scene scaled by the parallax factor of the group.
+ */
+static xg_point_t
+get_group_offset(const xg_scene_t *scn, uint8_t group)
+{
+	xg_point_t off = scn->offsets[group];
+	const uint8_t px = PGM(PGM_ADDR(&scn->groups[group].parallax));
+
+	off.x = (int16_t)(off.x + ((int32_t) scn->pan->x * px) /
+	    (int32_t) XG_PX_ONE);
+	off.y = (int16_t)(off.y + ((int32_t) scn->pan->y * px) /
+	    (int32_t) XG_PX_ONE);
+
+	return off;
+}
+
+/* Reads a pointer to the delta of the animation frame from flash. */
+static xg_addr_t
+get_frame_delta(const xg_anim_t *anim, uint16_t idx)
+{
+	xg_addr_t delta;
+
+	memcpy_PF(&delta, PGM_ADDR(&anim->frames[idx].delta), sizeof(delta));
+
+	return delta;
+}
+
+static void
+apply_delta(const xg_work_t *work, xg_addr_t delta)
+{
+	const uint16_t size = (uint16_t)(work->width *
+	    ((work->height + PHEIGHT - 1) / PHEIGHT));
+	uint8_t *data = work->data;
+	uint8_t *alpha = work->alpha;
+	uint16_t off;
+	uint8_t len;
+
+	if ((PGM(ASSET_ADDR(delta)) & XG_DF_KEY) != 0u) {
+		memset(data, 0, size);
+		memset(alpha, 0, size);
+	}
+	delta++;
+
+	while ((len = PGM(ASSET_ADDR(delta))) != 0u) {
+		off = (uint16_t)(PGM(ASSET_ADDR(delta + 1)) |
+		    (PGM(ASSET_ADDR(delta + 2)) << 8));
+		delta += 3;
+		memcpy_PF(&data[off], ASSET_ADDR(delta), len);
+		delta += len;
+		memcpy_PF(&alpha[off], ASSET_ADDR(delta), len);
+		delta += len;
+	}
+}
+
+/* Reads a character of the text in flash or in the buffer. */
+static char
+get_char(const xg_text_t *text, size_t i)
+{
+	if (text->str != NULL) {
+		return (char) PGM(ASSET_ADDR(text->str + i));
+	}
+
+	return text->text[i];
+}
+
+/*
+ * Breaks the next page of the speech into lines which fit the canvas. Words
+ * are moved to the next line as a whole, only the ones longer than a line are
+ * split. A line ends at a space or '\n' which isn't drawn or right before the
+ * first character of the next line.
+ */
+static void
+layout_page(const xg_canvas_t *canvas, xg_text_t *text)
+{
+	uint16_t lines = canvas->height / LINE_HEIGHT;
+	size_t i = text->drawn_len, brk = 0;
+	uint16_t x = 0, brk_x = 0;
+	xg_glyph_t glyph;
+	uint8_t n = 0, w;
+	char c;
+
+	if (lines > XG_SPEECH_LINES) {
+		lines = XG_SPEECH_LINES;
+	}
+
+	while (n < lines) {
+		c = get_char(text, i);
+		if (c == '\0' || c == '\n') {
+			text->breaks[n++] = i++;
+			x = 0;
+			brk_x = 0;
+			if (c == '\0') {
+				break;
+			}
+			continue;
+		}
+
+		w = (get_glyph(text->font, c, &glyph) == 0) ? glyph.width : 0;
+		if (c == ' ') {
+			/* Remember the last space to break the line there. */
+			brk = i;
+			brk_x = (uint16_t)(x + w);
+		} else if (x + w > canvas->width && x != 0u) {
+			if (brk_x != 0u) {
+				/* Move the word to the next line. */
+				text->breaks[n++] = brk;
+				x = (uint16_t)(x - brk_x);
+				brk_x = 0;
+			} else {
+				/* Split the word as long as a line. */
+				text->breaks[n++] = i;
+				x = 0;
+			}
+			continue;
+		} else {
+			/* Nothing to do here. */
+		}
+		x = (uint16_t)(x + w);
+		i++;
+	}
+
+	text->lines_n = n;
+	text->line = 0;
+	text->drawn_pt.x = 0;
+	text->drawn_pt.y = 0;
+	text->skip_cycles = 0;
+}
+
+#if configXG_TEXT_CACHE_SZ > 0
+/*
+ * Renders text into the free or the least recently used slot of the cache.
+ * Returns NULL if the text doesn't fit a slot.
+ */
+static struct text_slot *
+render_text(const xg_text_t *text, uint32_t hash, uint8_t shift)
+{
+	const xg_font_t *font = text->font;
+	struct text_slot *slot = &text_slots[0];
+	xg_canvas_t canvas;
+	xg_glyph_t glyph;
+	xg_point_t pt = { 0, (int16_t) shift };
+	uint16_t width = 0, sz;
+	uint32_t full;
+	uint8_t height = 0, pages, *mask;
+	char c;
+
+	/* Measure the text. */
+	for (size_t i = 0; (c = get_char(text, i)) != '\0'; i++) {
+		if (get_glyph(font, c, &glyph) == 0) {
+			width = (uint16_t)(width + glyph.width);
+			height = (glyph.height > height) ? glyph.height : height;
+		}
+	}
+	pages = (uint8_t)((shift + height + (PHEIGHT - 1)) / PHEIGHT);
+	sz = (uint16_t)(width * pages);
+	if (width == 0u || height > XG_GLYPH_MAX_HEIGHT ||
+	    2u * sz > TEXT_SLOT_SZ) {
+		return NULL;
+	}
+
+	/* Take a free slot or the one which wasn't used the longest. */
+	for (uint8_t i = 0; i < XG_TEXT_CACHE_SLOTS; i++) {
+		if (text_slots[i].font == NULL) {
+			slot = &text_slots[i];
+			break;
+		} else if ((uint8_t)(text_tick - text_slots[i].used) >
+		    (uint8_t)(text_tick - slot->used)) {
+			slot = &text_slots[i];
+		} else {
+			/* Nothing to do here. */
+		}
+	}
+
+	slot->font = font;
+	slot->hash = hash;
+	slot->width = width;
+	slot->shift = shift;
+	slot->pages = pages;
+
+	/* Draw the glyphs and their rows into the slot. */
+	canvas.data = slot->data;
+	canvas.width = width;
+	canvas.height = (uint16_t)(pages * PHEIGHT);
+	canvas.data_size = PHEIGHT;
+	mask = &slot->data[sz];
+	memset(slot->data, 0x00, 2u * sz);
+
+	for (size_t i = 0; (c = get_char(text, i)) != '\0'; i++) {
+		if (get_glyph(font, c, &glyph) != 0) {
+			continue;
+		}
+		draw_glyph(&canvas, font, &glyph, pt);
+
+		full = (uint32_t)(((1UL << glyph.height) - 1u) << shift);
+		for (uint8_t x = 0; x < glyph.width; x++) {
+			for (uint8_t p = 0; p < pages; p++) {
+				mask[(p * width) + (uint16_t) pt.x + x] |=
+				    (uint8_t)(full >> (p * PHEIGHT));
+			}
+		}
+		pt.x = (int16_t)(pt.x + glyph.width);
+	}
+
+	return slot;
+}
+
+/* Copies the rendered text under its mask to the canvas. */
+static void
+blit_text(xg_canvas_t *canvas, const struct text_slot *slot, int16_t x,
+    int16_t top_page)
+{
+	const int16_t canvas_pages = (int16_t)(canvas->height / PHEIGHT);
+	const uint8_t *data, *mask;
+	uint16_t x0, x1;
+	uint8_t *dest;
+	int16_t page;
+
+	if (x >= (int16_t) canvas->width) {
+		return;
+	}
+
+	/* Columns of the text within the canvas. */
+	x0 = (x < 0) ? (uint16_t)(-x) : 0u;
+	x1 = ((x + (int16_t) slot->width) > (int16_t) canvas->width)
+	    ? (uint16_t)(canvas->width - x) : slot->width;
+
+	for (uint8_t p = 0; p < slot->pages; p++) {
+		page = (int16_t)(top_page + p);
+		if (page >= canvas_pages) {
+			break;
+		} else if (page < 0 || x0 >= x1) {
+			continue;
+		}
+		data = &slot->data[(p * slot->width) + x0];
+		mask = &data[slot->pages * slot->width];
+		dest = &canvas->data[((uint16_t) page * canvas->width) +
+		    (uint16_t)(x + (int16_t) x0)];
+		for (uint16_t i = x0; i < x1; i++) {
+			*dest = (uint8_t)((*dest & ~(*mask++)) | *data++);
+			dest++;
+		}
+	}
+}
+#endif
+
+/*
+ * Splits the value into decimal digits, the most significant one goes first.
+ * Powers of ten are subtracted since there's no hardware division on AVR.
+ * Returns a number of the digits.
+ */
+static uint8_t
+get_digits(uint16_t val, uint8_t *digits)
+{
+	uint16_t pow;
+	uint8_t d, n = 0;
+
+	for (uint8_t i = 0; i < XG_UINT_DIGITS - 1u; i++) {
+		memcpy_PF(&pow, PGM_ADDR(&POW10[i]), sizeof(pow));
+		for (d = 0; val >= pow; d++) {
+			val = (uint16_t)(val - pow);
+		}
+		if (d != 0u || n != 0u) {
+			digits[n++] = d;
+		}
+	}
+	digits[n++] = (uint8_t) val;
+
+	return n;
+}
+
+/* Looks for a glyph of the character in the font by a binary search. */
+static int
+get_glyph(const xg_font_t *font, char c, xg_glyph_t *glyph)
+{
+	uint16_t lo = 0, hi = font->length, mid;
+
+	while (lo < hi) {
+		mid = (uint16_t)((lo + hi) / 2u);
+		memcpy_PF(glyph, PGM_ADDR(&font->glyphs[mid]), sizeof(*glyph));
+		if (glyph->code == (uint8_t) c) {
+			return 0;
+		} else if (glyph->code < (uint8_t) c) {
+			lo = (uint16_t)(mid + 1u);
+		} else {
+			hi = mid;
+		}
+	}
+
+	return 1;
+}
+
+/*
+ * Draws a glyph right from the packed bitmap in flash: bits of a column are
+ * read at once and put on the canvas by bytes of the glyph pages, just like
+ * xg_draw_pf() does with the opaque images.
+ */
+static int
+draw_glyph(xg_canvas_t *canvas, const xg_font_t *font,
+    const xg_glyph_t *glyph, xg_point_t pt)
+{
+	xg_addr_t bmp = &font->bitmaps[glyph->offset];
+	const uint8_t pages = (uint8_t)
+	    ((glyph->height + PHEIGHT - 1) / PHEIGHT);
+	const int16_t canvas_pages = (int16_t)(canvas->height / PHEIGHT);
+	const int16_t top_page = (int16_t)((pt.y >= 0) ? (pt.y / PHEIGHT)
+	    : -((PHEIGHT - 1 - pt.y) / PHEIGHT));
+	const uint8_t shift = (uint8_t)(pt.y - (top_page * PHEIGHT));
+	const uint32_t full = (1UL << glyph->height) - 1u;
+	uint16_t x0, x1, bit;
+	uint32_t bits;
+	uint8_t n, valid;
+	int16_t page;
+
+	/* Check coordinates. */
+	if (pt.x >= (int16_t) canvas->width ||
+	    pt.y >= (int16_t) canvas->height ||
+	    glyph->height > XG_GLYPH_MAX_HEIGHT) {
+		return 1;
+	}
+
+	/* Columns of the glyph within the canvas. */
+	x0 = (pt.x < 0) ? (uint16_t)(-pt.x) : 0u;
+	x1 = ((pt.x + (int16_t) glyph->width) > (int16_t) canvas->width)
+	    ? (uint16_t)(canvas->width - pt.x) : glyph->width;
+
+	for (uint16_t x = x0; x < x1; x++) {
+		/* Read bits of the column. */
+		bit = (uint16_t)(x * glyph->height);
+		n = (uint8_t)(((bit % 8u) + glyph->height + 7u) / 8u);
+		bits = 0;
+		for (uint8_t i = 0; i < n; i++) {
+			bits |= (uint32_t) PGM(ASSET_ADDR(
+			    &bmp[(bit / 8u) + i])) <<
+			    (i * 8u);
+		}
+		bits = (bits >> (bit % 8u)) & full;
+
+		for (uint8_t i = 0; i < pages; i++) {
+			page = (int16_t)(top_page + i);
+			if (page >= canvas_pages) {
+				break;
+			} else if (page < -1 || (page == -1 && shift == 0u)) {
+				continue;
+			}
+			valid = (uint8_t)(full >> (i * PHEIGHT));
+			put_img_byte(canvas, page,
+			    (uint16_t)(pt.x + (int16_t) x), shift,
+			    (uint8_t)(bits >> (i * PHEIGHT)), valid);
+		}
+	}
+
+	return 0;
+}
+
+/* Draws an operation of the draw list, i.e. a layer of the scene. */
+static void
+draw_op(xg_canvas_t *canvas, const xg_draw_op_t *op, xg_point_t off)
+{
+	const xg_point_t pt = {
+		.x = (int16_t)(op->base_pt.x + off.x),
+		.y = (int16_t)(op->base_pt.y + off.y),
+	};
+	xg_image_t img;
+	xg_tilemap_t tm;
+	xg_anim_t anim;
+
+	switch (op->obj_type) {
+	case XG_OT_IMG:
+		memcpy_PF(&img, PGM_ADDR(op->obj), sizeof(img));
+		xg_draw_pf(canvas, &img, pt, 0);
+		break;
+	case XG_OT_TILEMAP:
+		memcpy_PF(&tm, PGM_ADDR(op->obj), sizeof(tm));
+		xg_draw_tilemap(canvas, &tm, pt);
+		break;
+	case XG_OT_ANIM:
+		memcpy_PF(&anim, PGM_ADDR(op->obj), sizeof(anim));
+		draw_anim(canvas, &anim, off);
+		break;
+	default:
+		/* Other object types can't be painted at the moment. */
+		break;
+	}
+}
+
+/*
+ * Draws the current frame of the animation (mirrored one if needed) and
+ * chooses the next one.
+ */
+static void
+draw_anim(xg_canvas_t *canvas, const xg_anim_t *anim, xg_point_t off)
+{
+	xg_anim_state_t *state = anim->state;
+	xg_anim_frame_t frame;
+	xg_image_t img;
+	xg_point_t pt;
+	uint8_t flip;
+
+	/* Don't draw an inactive animation. */
+	if (state->active == 0) {
+		return;
+	}
+	memcpy_PF(&frame, PGM_ADDR(&anim->frames[state->frame_idx]),
+	    sizeof(frame));
+
+	get_frame_img(anim, &frame, &img);
+	pt.x = (int16_t)(frame.base_pt.x + off.x);
+	pt.y = (int16_t)(frame.base_pt.y + off.y);
+	if ((anim->flags & XG_DRAW_HFLIP) != 0u) {
+		pt.x = (int16_t)(anim->mirror_x - frame.base_pt.x -
+		    (int16_t) img.width + off.x);
+	}
+	xg_draw_pf(canvas, &img, pt, anim->flags);
+
+	/* Choose the next frame index. */
+	if (state->stay_cnt == 0u) {
+		if (frame.op == XG_AT_LOOP) {
+			if (state->loop_cnt < frame.threshold) {
+				state->loop_cnt++;
+				state->frame_idx = frame.alt;
+			} else {
+				state->loop_cnt = 0;
+				state->frame_idx = frame.next;
+			}
+		} else {
+			flip = (uint8_t)(state->frame_idx < XG_AF_FRAMES &&
+			    (state->alt_flip & (1u << state->frame_idx)) != 0u);
+			state->frame_idx = ((anim_next_rnd() < frame.threshold)
+			    != flip) ? frame.alt : frame.next;
+		}
+
+		/* Update stay counter. */
+		memcpy_PF(&state->stay_cnt, PGM_ADDR(
+		    &anim->frames[state->frame_idx].stay),
+		    sizeof(state->stay_cnt));
+	} else {
+		state->stay_cnt--;
+	}
+}
+
+/*
+ * Returns a random byte in 0..254 for the XG_AT_CHANCE frames: the threshold
+ * of 255 is always passed. It's a 16-bit xorshift, so it takes a few shifts and
+ * a multiplication instead of the 32-bit rand() and a division.
+ */
+static uint8_t
+anim_next_rnd(void)
+{
+	anim_rnd ^= (uint16_t)(anim_rnd << 7);
+	anim_rnd ^= (uint16_t)(anim_rnd >> 9);
+	anim_rnd ^= (uint16_t)(anim_rnd << 8);
+
+	return (uint8_t)(((anim_rnd >> 8) * 255u) >> 8);
+}
+
+/* Executes operations of the handler in [pc, end). */
+static void
+run_handler(xg_scene_ctx_t *ctx, const xg_scene_t *scn, const uint8_t *pc,
+    const uint8_t *end)
+{
+	xg_anim_state_t *state;
+	xg_point_t *off;
+	int8_t dx;
+
+	while (pc < end) {
+		switch (SC(pc)) {
+		case XG_SC_ACTIVE:
+			state = xg_get_anim_state(ctx->scene, SC(pc + 1));
+			if (state != NULL) {
+				state->active = SC(pc + 2);
+			}
+			pc += 3;
+			break;
+		case XG_SC_MOVE:
+			off = &scn->offsets[SC(pc + 1)];
+			off->x = (int16_t)(off->x + (int8_t) SC(pc + 2));
+			off->y = (int16_t)(off->y + (int8_t) SC(pc + 3));
+			pc += 4;
+			break;
+		case XG_SC_PAN:
+			off = scn->pan;
+			off->x = (int16_t)(off->x + (int8_t) SC(pc + 1));
+			off->y = (int16_t)(off->y + (int8_t) SC(pc + 2));
+			pc += 3;
+			break;
+		case XG_SC_WALK:
+			off = &scn->offsets[SC(pc + 1)];
+			dx = (int8_t) SC(pc + 2);
+			if ((dx < 0 && off->x <= SC16(pc + 3)) ||
+			    (dx > 0 && off->x >= SC16(pc + 5))) {
+				scn->pan->x = (int16_t)(scn->pan->x - dx);
+			} else {
+				off->x = (int16_t)(off->x + dx);
+			}
+			pc += 7;
+			break;
+		case XG_SC_CHANCE:
+			state = xg_get_anim_state(ctx->scene, SC(pc + 1));
+			if (state != NULL) {
+				state->alt_flip = (uint16_t) SC16(pc + 2);
+			}
+			pc += 4;
+			break;
+		case XG_SC_SET:
+			scn->vars[SC(pc + 1)] = SC(pc + 2);
+			pc += 3;
+			break;
+		case XG_SC_IFVAR:
+			pc += 4;
+			if (scn->vars[SC(pc - 3)] != SC(pc - 2)) {
+				pc += SC(pc - 1);
+			}
+			break;
+		case XG_SC_IFMODE:
+			pc += 3;
+			if ((uint8_t) ctx->scene_mode != SC(pc - 2)) {
+				pc += SC(pc - 1);
+			}
+			break;
+		case XG_SC_JUMP:
+			pc += 2 + SC(pc + 1);
+			break;
+		case XG_SC_MODE:
+			if (ctx->scene_mode == XG_SM_SPEECH &&
+			    SC(pc + 1) == (uint8_t) XG_SM_SCENE) {
+				/* Back to the scene after the last page. */
+				if (xg_next_page(ctx->canvas, ctx->text) != 0) {
+					xg_start_transition(ctx,
+					    (xg_trans_t) SC(pc + 2));
+				}
+			} else {
+				ctx->scene_mode = (xg_scene_mode_t) SC(pc + 1);
+			}
+			pc += 3;
+			break;
+		case XG_SC_SAY:
+			pc = say(ctx, pc + 1);
+			break;
+		default:
+			/* Unknown operation, stop the handler. */
+			return;
+		}
+	}
+}
+
+/*
+ * Says one of the phrases at random right from the bytecode. Returns a pointer
+ * to the operation after the phrases.
+ */
+static const uint8_t *
+say(xg_scene_ctx_t *ctx, const uint8_t *pc)
+{
+	const uint8_t n = SC(pc++);
+	const uint8_t pick = (uint8_t)((unsigned int) rand() % n);
+
+	for (uint8_t i = 0; i < n; i++) {
+		if (i == pick) {
+			xg_say(ctx, FAR_STR(pc));
+		}
+		while (SC(pc++) != 0u) {
+		}
+	}
+
+	return pc;
+}
+
+/*
+ * Checks whether the static operations of the scene are in the cache, i.e.
+ * none of them has been moved since they were drawn.
+ */
+static int
+is_cached(const xg_scene_t *scene, const xg_scene_t *scn)
+{
+	xg_draw_op_t op;
+	xg_point_t off;
+
+	if (cache_scene != scene) {
+		return 0;
+	}
+	for (uint16_t i = 0; i < scn->cached_n; i++) {
+		memcpy_PF(&op, PGM_ADDR(&scn->ops[i]), sizeof(op));
+		off = get_group_offset(scn, op.group);
+		if (cache_pts[i].x != (int16_t)(op.base_pt.x + off.x) ||
+		    cache_pts[i].y != (int16_t)(op.base_pt.y + off.y)) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/* Draws the static operations of the scene into the cache canvas. */
+static void
+cache_ops(const xg_scene_t *scene, const xg_scene_t *scn)
+{
+	xg_draw_op_t op;
+	xg_point_t off;
+
+	memset(cache_canvas->data, 0, (cache_canvas->width *
+	    cache_canvas->height) / cache_canvas->data_size);
+
+	for (uint16_t i = 0; i < scn->cached_n; i++) {
+		memcpy_PF(&op, PGM_ADDR(&scn->ops[i]), sizeof(op));
+		off = get_group_offset(scn, op.group);
+		cache_pts[i].x = (int16_t)(op.base_pt.x + off.x);
+		cache_pts[i].y = (int16_t)(op.base_pt.y + off.y);
+		draw_op(cache_canvas, &op, off);
 	}
+	cache_scene = scene;
 }
 
 static void
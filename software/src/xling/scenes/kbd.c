@@ -29,8 +29,8 @@
  * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
-#include <stdio.h>
 #include <stdlib.h>
+#include <avr/pgmspace.h>
 
 #include "xling/graphics.h"
 #include "xling/msg.h"
@@ -39,15 +39,39 @@
 #define RIGHT_BORDER		((uint8_t) 90u)
 #define COMMENTS_NUM		(5u)
 
-const char *comments[COMMENTS_NUM] = {
-	"- It's me.",
-	"- It's me again.",
-	"- Don't bother me.",
-	"- What?!",
-	"- Why don't you just go and finish this firmware for everybody who "
-	"wanted to play it?!"
+/*
+ * Group of the Exy animations (layers 0-13). It has zero parallax, so Exy is
+ * moved by the offset of the group only. The rest of the scene is scrolled by
+ * its pan, the groups of the other layers and the background have parallax
+ * of 100% and 50% accordingly.
+ */
+#define EXY_GROUP		((uint8_t) 1u)
+#define EXY_STEP		(2)
+
+/*
+ * Frames of the "paws" animations with the paws down and up. Manifest of the
+ * scene has the paws down, chances of both frames are flipped to raise them.
+ */
+#define PAWS_UP			((uint16_t) 0x0003u)
+
+static void	set_active(const xg_scene_t *scene, uint16_t first,
+    uint16_t last, uint8_t active);
+static void	set_alt_flip(const xg_scene_t *scene, uint16_t layer,
+    uint16_t flip);
+
+/* Comments of Exy, they're said right from flash. */
+static const __memx char comment_0[] = "- It's me.";
+static const __memx char comment_1[] = "- It's me again.";
+static const __memx char comment_2[] = "- Don't bother me.";
+static const __memx char comment_3[] = "- What?!";
+static const __memx char comment_4[] = "- Why don't you just go and finish "
+    "this firmware for everybody who wanted to play it?!";
+
+static const xg_str_t PROGMEM comments[COMMENTS_NUM] = {
+	comment_0, comment_1, comment_2, comment_3, comment_4
 };
 
+/* Used by the manifests without a script, see peasant_house.xsc. */
 void
 XG_SCNKBD_peasant_house(void *arg)
 {
@@ -55,81 +79,60 @@ XG_SCNKBD_peasant_house(void *arg)
 	static uint8_t stat_lock = 0;
 	static uint8_t right = 1;
 	xg_scene_ctx_t *scene_ctx = (xg_scene_ctx_t *) arg;
-	xg_scene_t *scene = scene_ctx->scene;
+	const xg_scene_t *scene = scene_ctx->scene;
 	const xg_scene_mode_t scene_mode = scene_ctx->scene_mode;
-	xg_text_t *text = scene_ctx->text;
 	xg_point_t pt = { 0, 0 };
-	xg_anim_t *anim;
+	xg_scene_t scn;
+	xg_anim_frame_t frame;
 	uint16_t rnd;
 
+	xg_get_scene(scene, &scn);
+	xg_get_anim_frame(scene, 0, 0, &frame);
+
 	switch (scene_ctx->btn_stat) {
+	case XM_BTN_NONE:
+		/* The scene is entered again. */
+		show_stat = 0;
+		stat_lock = 0;
+		right = 1;
+		break;
 	case XM_BTN_LEFT_PRESSED:
 		if (scene_mode == XG_SM_SCENE) {
 			/* Does Exy need to turn around? */
 			if (right) {
 				/* Turn around */
-				for (uint8_t i = 0; i <= 5; i++) {
-					anim = (xg_anim_t *) scene->layers[i].obj;
-					anim->active = 0;
-				}
-				anim = (xg_anim_t *) scene->layers[12].obj;
-				anim->active = 0;
-				for (uint8_t i = 6; i <= 11; i++) {
-					anim = (xg_anim_t *) scene->layers[i].obj;
-					anim->active = 1;
-				}
-				anim = (xg_anim_t *) scene->layers[13].obj;
-				anim->active = 1;
+				set_active(scene, 0, 5, 0);
+				set_active(scene, 12, 12, 0);
+				set_active(scene, 6, 11, 1);
+				set_active(scene, 13, 13, 1);
 			}
 			right = 0;
 
 			/* Move scene or all of the Exy animations */
-			anim = (xg_anim_t *) scene->layers[0].obj;
-			if (anim->frames[0].base_pt.x <= LEFT_BORDER) {
-				for (uint8_t i = 14; i <= 25; i++) {
-					/* Move all of the other layers */
-					scene->layers[i].base_pt.x += 2;
-				}
-				for (uint8_t i = 26; i < scene->layers_n; i++) {
-					/* Move all of the background layers */
-					scene->layers[i].base_pt.x += 1;
-				}
+			if ((frame.base_pt.x + scn.offsets[EXY_GROUP].x) <=
+			    LEFT_BORDER) {
+				scn.pan->x += EXY_STEP;
 			} else {
-				for (uint8_t i = 0; i <= 13; i++) {
-					if (scene->layers[i].obj_type == XG_OT_ANIM) {
-						anim = (xg_anim_t *) scene->layers[i].obj;
-						for (uint8_t j = 0; j < anim->frames_n; j++) {
-							anim->frames[j].base_pt.x -= 2;
-						}
-					}
-				}
+				scn.offsets[EXY_GROUP].x -= EXY_STEP;
 			}
 
 			/* Enable legs animation */
-			anim = (xg_anim_t *) scene->layers[10].obj;
-			anim->active = 0;
-			anim = (xg_anim_t *) scene->layers[11].obj;
-			anim->active = 1;
+			set_active(scene, 10, 10, 0);
+			set_active(scene, 11, 11, 1);
 
 			/* Paws up! */
-			anim = (xg_anim_t *) scene->layers[8].obj;
-			anim->frames[0].alt_chance = 0;
-			anim->frames[1].alt_chance = 100;
+			set_alt_flip(scene, 8, PAWS_UP);
 		}
 		break;
 	case XM_BTN_LEFT_RELEASED:
 		if (scene_mode == XG_SM_SCENE) {
 			if (!right) {
 				/* Disable legs animation */
-				anim = (xg_anim_t *) scene->layers[10].obj;
-				anim->active = 1;
-				anim = (xg_anim_t *) scene->layers[11].obj;
-				anim->active = 0;
+				set_active(scene, 10, 10, 1);
+				set_active(scene, 11, 11, 0);
 
 				/* Paws down! */
-				anim = (xg_anim_t *) scene->layers[8].obj;
-				anim->frames[0].alt_chance = 100;
-				anim->frames[1].alt_chance = 0;
+				set_alt_flip(scene, 8, 0);
 			}
 		}
 		break;
@@ -138,68 +141,38 @@ XG_SCNKBD_peasant_house(void *arg)
 			/* Does Exy need to turn around? */
 			if (!right) {
 				/* Turn around */
-				for (uint8_t i = 0; i <= 5; i++) {
-					anim = (xg_anim_t *) scene->layers[i].obj;
-					anim->active = 1;
-				}
-				anim = (xg_anim_t *) scene->layers[12].obj;
-				anim->active = 1;
-				for (uint8_t i = 6; i <= 11; i++) {
-					anim = (xg_anim_t *) scene->layers[i].obj;
-					anim->active = 0;
-				}
-				anim = (xg_anim_t *) scene->layers[13].obj;
-				anim->active = 0;
+				set_active(scene, 0, 5, 1);
+				set_active(scene, 12, 12, 1);
+				set_active(scene, 6, 11, 0);
+				set_active(scene, 13, 13, 0);
 			}
 			right = 1;
 
 			/* Move scene or all of the Exy animations */
-			anim = (xg_anim_t *) scene->layers[0].obj;
-			if (anim->frames[0].base_pt.x >= RIGHT_BORDER) {
-				for (uint8_t i = 14; i <= 25; i++) {
-					/* Move all of the other layers */
-					scene->layers[i].base_pt.x -= 2;
-				}
-				for (uint8_t i = 26; i < scene->layers_n; i++) {
-					/* Move all of the background layers */
-					scene->layers[i].base_pt.x -= 1;
-				}
+			if ((frame.base_pt.x + scn.offsets[EXY_GROUP].x) >=
+			    RIGHT_BORDER) {
+				scn.pan->x -= EXY_STEP;
 			} else {
-				for (uint8_t i = 0; i <= 13; i++) {
-					if (scene->layers[i].obj_type == XG_OT_ANIM) {
-						anim = (xg_anim_t *) scene->layers[i].obj;
-						for (uint8_t j = 0; j < anim->frames_n; j++) {
-							anim->frames[j].base_pt.x += 2;
-						}
-					}
-				}
+				scn.offsets[EXY_GROUP].x += EXY_STEP;
 			}
 
 			/* Enable legs animation */
-			anim = (xg_anim_t *) scene->layers[4].obj;
-			anim->active = 0;
-			anim = (xg_anim_t *) scene->layers[5].obj;
-			anim->active = 1;
+			set_active(scene, 4, 4, 0);
+			set_active(scene, 5, 5, 1);
 
 			/* Paws up! */
-			anim = (xg_anim_t *) scene->layers[2].obj;
-			anim->frames[0].alt_chance = 0;
-			anim->frames[1].alt_chance = 100;
+			set_alt_flip(scene, 2, PAWS_UP);
 		}
 		break;
 	case XM_BTN_RIGHT_RELEASED:
 		if (scene_mode == XG_SM_SCENE) {
 			if (right) {
 				/* Disable legs animation */
-				anim = (xg_anim_t *) scene->layers[4].obj;
-				anim->active = 1;
-				anim = (xg_anim_t *) scene->layers[5].obj;
-				anim->active = 0;
+				set_active(scene, 4, 4, 1);
+				set_active(scene, 5, 5, 0);
 
 				/* Paws down! */
-				anim = (xg_anim_t *) scene->layers[2].obj;
-				anim->frames[0].alt_chance = 100;
-				anim->frames[1].alt_chance = 0;
+				set_alt_flip(scene, 2, 0);
 			}
 		}
 		break;
@@ -210,17 +183,15 @@ XG_SCNKBD_peasant_house(void *arg)
 
 			if (scene_mode == XG_SM_SCENE) {
 				rnd = (uint16_t)
-				    rand() / ((RAND_MAX + 1u) / COMMENTS_NUM);
-
-				text->drawn_pt.x = 0;
-				text->drawn_pt.y = 0;
-				text->drawn_len = 0;
-				text->skip_cycles = 0;
-				snprintf(text->text, text->text_sz,
-				    comments[rnd]);
-				scene_ctx->scene_mode = XG_SM_SPEECH;
+				    ((unsigned int) rand() % COMMENTS_NUM);
+				xg_say(scene_ctx, xg_get_str(comments, rnd));
+			} else if (scene_mode == XG_SM_SPEECH &&
+			    xg_next_page(scene_ctx->canvas,
+			    scene_ctx->text) != 0) {
+				/* Back to the scene at the end of the speech. */
+				xg_start_transition(scene_ctx, XG_TR_FADE);
 			} else {
-				scene_ctx->scene_mode = XG_SM_SCENE;
+				/* The next page of the speech is drawn. */
 			}
 		}
 		break;
@@ -235,20 +206,22 @@ XG_SCNKBD_peasant_house(void *arg)
 	}
 
 	/* if (show_stat == 1) { */
-	/* 	snprintf(text->text, text->text_sz, "%u ms", */
-	/* 	    scene_ctx->frame_delay << 1); */
+	/* 	static const __memx char pct[] = "%3u%%"; */
+	/* 	static const __memx char yes[] = "yes", no[] = "no"; */
+	/* 	xg_text_t *text = scene_ctx->text; */
+	/* 	uint16_t lvl = scene_ctx->bat_lvl; */
 	/* 	pt.x = 85; */
 	/* 	pt.y = 20; */
-	/* 	xg_print(scene_ctx->canvas, text, pt); */
+	/* 	xg_print_uint(scene_ctx->canvas, text, pt, */
+	/* 	    (uint16_t)(scene_ctx->frame_delay << 1), 3); */
 
-	/* 	snprintf(text->text, text->text_sz, "%u%%", scene_ctx->bat_lvl); */
+	/* 	xg_format(text, pct, &lvl); */
 	/* 	pt.y = 31; */
 	/* 	xg_print(scene_ctx->canvas, text, pt); */
 
-	/* 	snprintf(text->text, text->text_sz, (scene_ctx->bat_stat == 1) */
-	/* 	    ? "yes" : "no"); */
+	/* 	text->str = (scene_ctx->bat_stat == 1) ? yes : no; */
 	/* 	pt.y = 42; */
-	/* 	xg_print(scene_ctx->canvas, text, pt); */
+	/* 	xg_print_cached(scene_ctx->canvas, text, pt); */
 	/* } */
 }
 
@@ -269,3 +242,28 @@ XG_SCNKBD_dungeon(void *arg)
 {
 	XG_SCNKBD_peasant_house(arg);
 }
+
+/* Activates or deactivates animation layers in the range [first, last]. */
+static void
+set_active(const xg_scene_t *scene, uint16_t first, uint16_t last,
+    uint8_t active)
+{
+	xg_anim_state_t *state;
+
+	for (uint16_t i = first; i <= last; i++) {
+		state = xg_get_anim_state(scene, i);
+		if (state != NULL) {
+			state->active = active;
+		}
+	}
+}
+
+static void
+set_alt_flip(const xg_scene_t *scene, uint16_t layer, uint16_t flip)
+{
+	xg_anim_state_t *state = xg_get_anim_state(scene, layer);
+
+	if (state != NULL) {
+		state->alt_flip = flip;
+	}
+}
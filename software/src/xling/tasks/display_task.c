@@ -63,7 +63,7 @@
 #define TASK_PERIOD		(42) /* in ms (~ 23.80 Hz) */
 //#define TASK_PERIOD		(83) /* in ms (~ 12.05 Hz) */
 #define TASK_DELAY		(pdMS_TO_TICKS(TASK_PERIOD))
-#define TEXT_BUFSZ		(128)
+#define TEXT_BUFSZ		(16) /* Formatted numbers only, see xg_str_t. */
 
 /*
  * Bigger stack size is necessary to draw text and images to the canvas which
@@ -117,18 +117,14 @@ static xg_text_t text = {
 	.text_sz = TEXT_BUFSZ,
 };
 static xg_scene_ctx_t scene_ctx = {
-	//.scene = &XG_SCN_walking_01,
-	//.scene = &XG_SCN_smoking_02,
-	//.scene = &XG_SCN_test_brick,
-	.scene = &XG_SCN_peasant_house,
-	//.scene = &XG_SCN_forest,
-	//.scene = &XG_SCN_town_street,
-	//.scene = &XG_SCN_dungeon,
+	.scenes = XG_SCENES,
+	.scenes_n = XG_SCENES_N,
 	.canvas = &canvas,
 	.text = &text,
 	.frame_delay = 0,
 	.bat_lvl = 100,
 	.bat_stat = 0,
+	.contrast = XG_CONTRAST,
 	.scene_mode = XG_SM_SCENE
 };
 
@@ -187,7 +183,9 @@ display_task(void *arg)
 {
 	const xt_args_t * const args = (xt_args_t *) arg;
 	MSIM_SH1106_t * const display = MSIM_SH1106_Init(&display_conf);
+	xg_scene_t scene;
 	TickType_t ticks;
+	uint8_t contrast = XG_CONTRAST;
 	TickType_t last_wake;
 
 	/* Use current time as a seed for random generator. */
@@ -200,7 +198,7 @@ display_task(void *arg)
 	MSIM_SH1106_SetPumpVoltage(display, 0x32);
 	MSIM_SH1106_SetChargePeriod(display, 0x22);
 	MSIM_SH1106_SetVCOMDeselectLevel(display, 0x35);
-	MSIM_SH1106_SetContrast(display, 0x75);
+	MSIM_SH1106_SetContrast(display, XG_CONTRAST);
 
 	MSIM_SH1106_DisplayNormal(display);
 	MSIM_SH1106_SetScanDirection(display, 0);
@@ -213,6 +211,9 @@ display_task(void *arg)
 	/* Setup a canvas for cache */
 	xg_cache_canvas(&cache_canvas);
 
+	/* Enter the first scene of the registry. */
+	xg_switch_scene(&scene_ctx, 0);
+
 	/* Task loop */
 	while (1) {
 		/* Wait for the next task tick. */
@@ -233,9 +234,16 @@ display_task(void *arg)
 			memset(display_buffer, 0x00, 1024);
 		}
 
-		/* Process keyboard events. */
-		if (scene_ctx.scene->kbd_cbk != NULL) {
-			scene_ctx.scene->kbd_cbk(&scene_ctx);
+		/*
+		 * Process keyboard events by the script or the callback.
+		 * Neither of them runs while the scene is being switched.
+		 */
+		xg_get_scene(scene_ctx.scene, &scene);
+		if (scene.script != NULL) {
+			xg_run_script(&scene_ctx);
+		} else if (scene.kbd_cbk != NULL &&
+		    scene_ctx.scene_mode != XG_SM_TRANSITION) {
+			scene.kbd_cbk(&scene_ctx);
 		}
 
 		switch (scene_ctx.scene_mode) {
@@ -245,6 +253,9 @@ display_task(void *arg)
 		case XG_SM_SPEECH:
 			xg_draw_speech(&canvas, scene_ctx.text);
 			break;
+		case XG_SM_TRANSITION:
+			xg_draw_transition(&canvas, &scene_ctx);
+			break;
 		default:
 			/* Shouldn't reach here. */
 			break;
@@ -253,6 +264,14 @@ display_task(void *arg)
 		/* Transfer canvas buffer to the display. */
 		xg_transfer_canvas(display, &canvas);
 
+		/* Ramp the contrast if the scene is faded. */
+		if (scene_ctx.contrast != contrast) {
+			contrast = scene_ctx.contrast;
+			MSIM_SH1106_bufClear(display);
+			MSIM_SH1106_SetContrast(display, contrast);
+			MSIM_SH1106_bufSend(display);
+		}
+
 		/*
 		 * Calculate a delay to receive a message from the queue and
 		 * draw an animation frame.
@@ -327,7 +346,20 @@ receive_msgs(const QueueHandle_t q, MSIM_SH1106_t * const display,
 				break;
 			case XM_MSG_KEYBOARD:
 				ctx->btn_stat = (xm_btn_state_t) msg.value;
-				break;
+
+				/* Hold the button to go to the next scene. */
+				if (ctx->btn_stat == XM_BTN_CENTER_HOLD) {
+					xg_switch_scene(ctx, (uint16_t)
+					    ((ctx->scene_idx + 1u) %
+					    ctx->scenes_n));
+				}
+
+				/*
+				 * Every keyboard event is seen by the scene
+				 * for a frame at least, the rest of them are
+				 * received in the next frames.
+				 */
+				return;
 			default:
 				/* Ignore other messages silently. */
 				break;
@@ -42,6 +42,7 @@
 #define TASK_PERIOD		(10)				/* ms */
 #define TASK_DELAY		(pdMS_TO_TICKS(TASK_PERIOD))	/* ticks */
 #define NO_DELAY		(0)
+#define HOLD_PERIODS		(100)				/* ~1 s */
 
 /* Local variables. */
 static xm_btn_state_t _keyboard[] = {
@@ -49,6 +50,12 @@ static xm_btn_state_t _keyboard[] = {
 	XM_BTN_CENTER_RELEASED, /* 1 - Center button. */
 	XM_BTN_RIGHT_RELEASED,  /* 2 - Right button. */
 };
+/*
+ * Periods the center button is held. The display task doesn't receive
+ * XM_BTN_CENTER_PRESSED until the button is released before HOLD_PERIODS,
+ * so holding the button (to switch the scene) isn't a press for the scene.
+ */
+static uint16_t _center_hold = 0;
 static TaskHandle_t _task_handle;
 
 /* Local functions. */
@@ -164,12 +171,11 @@ keyboard_task(void *arg)
 		if (_keyboard[1] == XM_BTN_CENTER_RELEASED) {
 			if (((PIND & 4U) >> 2) == 0U) {
 				_keyboard[1] = XM_BTN_CENTER_PRESSED;
+				_center_hold = 0;
 
 				msg.type = XM_MSG_KEYBOARD;
 				msg.value = XM_BTN_CENTER_PRESSED;
 
-				status = xQueueSendToBack(
-				        display_queue, &msg, 0);
 				status = xQueueSendToBack(
 				        sleep_queue, &msg, 0);
 			}
@@ -177,9 +183,28 @@ keyboard_task(void *arg)
 			if (((PIND & 4U) >> 2) == 1U) {
 				_keyboard[1] = XM_BTN_CENTER_RELEASED;
 
+				/* Deliver the press held back so far. */
+				if (_center_hold < HOLD_PERIODS) {
+					msg.type = XM_MSG_KEYBOARD;
+					msg.value = XM_BTN_CENTER_PRESSED;
+
+					status = xQueueSendToBack(
+					        display_queue, &msg, 0);
+				}
+
 				msg.type = XM_MSG_KEYBOARD;
 				msg.value = XM_BTN_CENTER_RELEASED;
 
+				status = xQueueSendToBack(
+				        display_queue, &msg, 0);
+				status = xQueueSendToBack(
+				        sleep_queue, &msg, 0);
+			} else if (_center_hold < HOLD_PERIODS &&
+			    ++_center_hold == HOLD_PERIODS) {
+				/* Button is still pressed. */
+				msg.type = XM_MSG_KEYBOARD;
+				msg.value = XM_BTN_CENTER_HOLD;
+
 				status = xQueueSendToBack(
 				        display_queue, &msg, 0);
 				status = xQueueSendToBack(